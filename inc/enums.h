@@ -20,6 +20,7 @@
 
 // prGetIntegerv arguments
 #define PR_MAX_TEXTURE_SIZE 0x00000021
+#define PR_NUM_THREADS      0x00000022
 
 // Geometry primitives
 #define PR_POINTS           0x00000031
@@ -40,6 +41,22 @@
 #define PR_POLYGON_LINE     0x00000054
 #define PR_POLYGON_POINT    0x00000055
 
+// Rasterizer modes
+#define PR_RASTERIZER_SCANLINE  0x00000056
+#define PR_RASTERIZER_HALFSPACE 0x00000057
+
+// Depth test functions
+#define PR_DEPTH_GREATER    0x00000058
+#define PR_DEPTH_GEQUAL     0x00000059
+
+// Depth buffer formats
+#define PR_DEPTH_COMPONENT      0x0000005a
+#define PR_DEPTH_COMPONENT32F   0x0000005b
+
+// Texture filters
+#define PR_NEAREST          0x0000005c
+#define PR_LINEAR           0x0000005d
+
 // prGetTexLevelParameteri arguments
 #define PR_TEXTURE_WIDTH    0x00000060
 #define PR_TEXTURE_HEIGHT   0x00000061
@@ -47,9 +64,17 @@
 // States
 #define PR_SCISSOR          0
 #define PR_MIP_MAPPING      1
+#define PR_DEPTH_TEST       2
 
 // Texture environment parameters
-#define PR_TEXTURE_LOD_BIAS 0
+#define PR_TEXTURE_LOD_BIAS                 0
+#define PR_TEXTURE_PERSPECTIVE_SUBSPAN      1
+#define PR_TEXTURE_FILTER                   2
+
+// Dithering modes for texture images (PR_DITHER_NONE and PR_DITHER_FLOYD_STEINBERG are equal to PR_FALSE and PR_TRUE)
+#define PR_DITHER_NONE              0
+#define PR_DITHER_FLOYD_STEINBERG   1
+#define PR_DITHER_ORDERED           2
 
 // Frame buffer clear flags
 #define PR_COLOR_BUFFER_BIT 0x00000001
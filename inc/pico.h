@@ -47,6 +47,7 @@ const char* prGetString(PRenum str);
 Returns the specified parameter value.
 \param[in] param Specifies the parameter which is to be queried.
 - PR_MAX_TEXTURE_SIZE: Returns the maximum texture size.
+- PR_NUM_THREADS: Returns the number of threads the rasterizer uses (including the calling thread).
 */
 PRint prGetIntegerv(PRenum param);
 
@@ -88,11 +89,15 @@ void prPresent(PRobject context);
 Generates a new frame buffer. At least one frame buffer is required to render anything.
 \param[in] width Specifies the frame buffer width.
 \param[in] height Specifies the frame buffer height.
+\param[in] depthFormat Specifies the depth buffer format. This must be one of the following values:
+- PR_DEPTH_COMPONENT: 16-bit fixed-point depths (8-bit if PR_DEPTH_BUFFER_8BIT is defined).
+- PR_DEPTH_COMPONENT32F: 32-bit floating-point depths with reversed Z, i.e. 1/w is stored without conversion,
+so that distant pixels keep the precision of the floating-point exponent. The depth test uses SIMD float compares.
 \return Frame buffer object.
 \remarks The frame buffer must be deleted with 'prDeleteFrameBuffer'.
 \see prDeleteFrameBuffer
 */
-PRobject prCreateFrameBuffer(PRuint width, PRuint height);
+PRobject prCreateFrameBuffer(PRuint width, PRuint height, PRenum depthFormat);
 
 /**
 Deletes the specified frame buffer.
@@ -154,28 +159,62 @@ Sets the 2D image data to the specified texture.
 \param[in] height Specifies the image height. This will be the final texture height.
 \param[in] format Specifies the image data format. This must be PR_UBYTE_RGB.
 \param[in] data Raw pointer to the image data. This must be in the format: PRubyte[width*height*3].
-\param[in] dither Specifies whether dithering is to be applied to the image (to compensate 8-bit colors).
+\param[in] dither Specifies the dithering which is to be applied to the image (to compensate 8-bit colors). Valid values are:
+- PR_DITHER_NONE: Colors are mapped to the nearest lower palette color.
+- PR_DITHER_FLOYD_STEINBERG: Error diffusion with the Floyd-Steinberg pattern. Best quality, but each row depends on the previous one.
+- PR_DITHER_ORDERED: Ordered dithering with an 8x8 Bayer matrix. Each pixel is converted independently, which is considerably faster.
+Dithering is ignored with a 24-bit color buffer.
 \param[in] generateMips Specifies whether MIP maps are to be generated for this texture.
 */
 void prTexImage2D(
     PRobject texture, PRtexsize width, PRtexsize height, PRenum format,
-    const PRvoid* data, PRboolean dither, PRboolean generateMips
+    const PRvoid* data, PRenum dither, PRboolean generateMips
 );
 
 /**
 Sets the 2D image data from file to the specified texture.
 \param[in] texture Specifies the texture whose image data is to be set.
 \param[in] filename Specifies the image filename. Valid image file formats are: BMP, PNG, TGA, JPEG (base line only).
-\param[in] dither Specifies whether dithering is to be applied to the image (to compensate 8-bit colors).
+\param[in] dither Specifies the dithering which is to be applied to the image (see prTexImage2D).
 \param[in] generateMips Specifies whether MIP maps are to be generated for this texture.
 \see prTexImage2D
 */
-void prTexImage2DFromFile(PRobject texture, const char* filename, PRboolean dither, PRboolean generateMips);
+void prTexImage2DFromFile(PRobject texture, const char* filename, PRenum dither, PRboolean generateMips);
+
+/**
+Sets the image data of a rectangle within a MIP level of the specified texture, e.g. to stream video frames into a texture.
+Only the rectangle is converted, and the texels of the following MIP levels which are derived from it are recomputed.
+\param[in] texture Specifies the texture whose image data is to be set.
+\param[in] mip Specifies the MIP level. This must be less than the number of MIP levels of the texture.
+\param[in] x Specifies the left position of the rectangle. The rectangle must lie inside the MIP level.
+\param[in] y Specifies the top position of the rectangle.
+\param[in] width Specifies the rectangle width. This must be greater than 0.
+\param[in] height Specifies the rectangle height. This must be greater than 0.
+\param[in] format Specifies the image data format. This must be PR_UBYTE_RGB.
+\param[in] data Raw pointer to the image data. This must be in the format: PRubyte[width*height*3].
+\param[in] dither Specifies the dithering which is to be applied to the image (see prTexImage2D).
+\remarks Where the rectangle is not aligned to the 2x2 texels of a MIP level,
+the recomputed texels are filtered from the quantized colors of the texels around the rectangle.
+\see prTexImage2D
+*/
+void prTexSubImage2D(
+    PRobject texture, PRubyte mip, PRtexsize x, PRtexsize y, PRtexsize width, PRtexsize height,
+    PRenum format, const PRvoid* data, PRenum dither
+);
 
 /**
 Sets the texture environment parameters.
 \param[in] param Specifies the paramer whose value is to be set. Valid values are:
 - PR_TEXTURE_LOD_BIAS: Specifies the level-of-detail bias for MIP-mapping. Must be in the range [0, 255]. By default 0.
+- PR_TEXTURE_PERSPECTIVE_SUBSPAN: Specifies the number of pixels between two perspective divisions of the texture coordinates.
+The coordinates are interpolated linearly in between (like the Quake software renderer), which saves the division per pixel.
+Must be 0 or a power of two in the range [2, 64], where 0 divides at each pixel. By default 0.
+Only has an effect if PR_PERSPECTIVE_CORRECTED is defined and PR_SIMD_SSE2/PR_SIMD_AVX2 are not,
+because the SIMD span kernels divide several pixels at once. Untextured polygons and spans which are not longer
+than one subspan are always divided at each pixel. This only pays off for large textured polygons.
+- PR_TEXTURE_FILTER: Specifies the texture filter. Must be PR_NEAREST or PR_LINEAR. By default PR_NEAREST.
+PR_LINEAR filters bilinearly between the four nearest texels of the selected MIP level with precomputed blend tables
+of the 8-bit color indices (the fractions are quantized to quarters). The subspan setting is ignored with this filter.
 \param[in] value Specifies the new integer value.
 */
 void prTexEnvi(PRenum param, PRint value);
@@ -190,6 +229,67 @@ Returns a parameter of the specified texture MIP-map.
 */
 PRint prGetTexLevelParameteri(PRobject texture, PRubyte mipLevel, PRenum param);
 
+// --- atlas --- //
+
+/**
+Generates a new texture atlas, which packs many images into a single texture,
+so that all of them can be drawn without binding another texture.
+\param[in] width Specifies the width of the atlas texture.
+\param[in] height Specifies the height of the atlas texture.
+\param[in] mips Specifies the number of MIP levels of the atlas texture. This must be in the range [1, 11].
+Each entry stores its own MIP chain, which is never blended with the neighboring entries.
+For this, the entries are placed at multiples of 2^(mips - 1) texels, i.e. more MIP levels leave more space unused.
+\return Atlas object, or zero if the parameters are invalid.
+\remarks The atlas must be deleted with 'prDeleteAtlas'.
+\see prDeleteAtlas
+*/
+PRobject prCreateAtlas(PRtexsize width, PRtexsize height, PRubyte mips);
+
+/**
+Deletes the specified texture atlas together with its texture.
+\param[in] atlas Specifies the atlas which is to be deleted.
+This must be generated by 'prCreateAtlas'.
+\see prCreateAtlas
+*/
+void prDeleteAtlas(PRobject atlas);
+
+/**
+Removes all entries from the specified texture atlas.
+\param[in] atlas Specifies the atlas which is to be cleared.
+*/
+void prClearAtlas(PRobject atlas);
+
+/**
+Packs the image into the specified texture atlas.
+\param[in] atlas Specifies the atlas into which the image is to be packed.
+\param[in] width Specifies the image width.
+\param[in] height Specifies the image height.
+\param[in] format Specifies the image data format. This must be PR_UBYTE_RGB.
+\param[in] data Raw pointer to the image data. This must be in the format: PRubyte[width*height*3].
+\param[in] dither Specifies the dithering which is to be applied to the image (see prTexImage2D).
+\return Index of the new atlas entry (counted up from 0), or -1 if there is not enough space left in the atlas.
+\remarks The texture coordinates of an entry only cover its rectangle, so they must not be wrapped around the entry.
+With the PR_LINEAR texture filter the texels at the border of an entry are blended with the neighboring entry.
+\see prGetAtlasRect
+*/
+PRint prAtlasImage2D(PRobject atlas, PRtexsize width, PRtexsize height, PRenum format, const PRvoid* data, PRenum dither);
+
+/**
+Returns the texture coordinates of the specified atlas entry.
+\param[in] atlas Specifies the atlas whose entry is to be determined.
+\param[in] entry Specifies the entry index, which has been returned by 'prAtlasImage2D'.
+\param[out] rect Pointer to the texture coordinates in the format: PRfloat[4] = { left, top, right, bottom }.
+Texture coordinates in the range [0, 1] within the entry are mapped to this rectangle as follows:
+u' = left + u*(right - left), v' = top + v*(bottom - top).
+*/
+void prGetAtlasRect(PRobject atlas, PRint entry, PRfloat* rect);
+
+/**
+Returns the texture of the specified atlas, which is to be bound with 'prBindTexture' to draw the atlas entries.
+\remarks This texture is owned by the atlas, i.e. it must not be deleted with 'prDeleteTexture'.
+*/
+PRobject prGetAtlasTexture(PRobject atlas);
+
 // --- vertexbuffer --- //
 
 /**
@@ -301,6 +401,8 @@ void prBindIndexBuffer(PRobject indexBuffer);
 /**
 Sets the projection matrix.
 \param[in] matrix4x4 Raw pointer to a 4x4 left-handed projection matrix (in projection space).
+Polygons are clipped in homogeneous clip space at the near plane (z = 0) and the far plane (z = w).
+Since depth values are stored as 1/w, polygons are additionally clipped where w < 1.
 \see prBuildPerspectiveProjection
 \see prBuildOrthogonalProjection
 */
@@ -378,6 +480,8 @@ void prLoadIdentity(PRfloat* matrix4x4);
 Sets the specified state.
 \param[in] cap Specifies the capability whose state is to be changed. Valid values are:
 - PR_SCISSOR - Enables/disables the scissor rectangle (see prScissor). By default PR_FALSE.
+- PR_DEPTH_TEST - Enables/disables the depth test for filled polygons. If disabled, the depth buffer is neither read
+nor written (regardless of prDepthMask) and untextured polygons are filled with a plain color fill. By default PR_TRUE.
 \param[in] state Specifies the new state.
 \see prEnable
 \see prDisable
@@ -446,6 +550,43 @@ By default PR_POLYGON_FILL.
 */
 void prPolygonMode(PRenum mode);
 
+/**
+Sets the rasterizer mode for filled polygons.
+\param[in] mode Specifies the new rasterizer mode. This must be PR_RASTERIZER_SCANLINE or PR_RASTERIZER_HALFSPACE.
+The scanline rasterizer walks the polygon edges row by row, the half-space rasterizer evaluates
+the edge functions on 8x8 pixel blocks (top-left fill rule).
+The scanline rasterizer is currently the faster one for all polygon sizes.
+By default PR_RASTERIZER_SCANLINE.
+*/
+void prRasterizerMode(PRenum mode);
+
+/**
+Enables or disables writing to the color buffer.
+Together with prDepthMask and prDepthFunc this allows a depth pre-pass:
+draw the scene with color writes disabled first, then draw it again with depth writes disabled and PR_DEPTH_GEQUAL,
+so that each pixel is only shaded once. Polygons drawn without color writes are rasterized without texture sampling.
+This only affects filled polygons (PR_POLYGON_FILL) drawn with prDraw and prDrawIndexed, but not prClearFrameBuffer.
+By default PR_TRUE.
+*/
+void prColorMask(PRboolean flag);
+
+/**
+Enables or disables writing to the depth buffer. The depth test is still made if depth writes are disabled.
+This only affects filled polygons (PR_POLYGON_FILL) drawn with prDraw and prDrawIndexed, but not prClearFrameBuffer.
+By default PR_TRUE.
+\see prColorMask
+*/
+void prDepthMask(PRboolean flag);
+
+/**
+Sets the depth test function. Pixels with a larger depth are nearer to the viewer.
+\param[in] func Specifies the new depth test function. This must be PR_DEPTH_GREATER or PR_DEPTH_GEQUAL.
+With PR_DEPTH_GEQUAL, pixels with the same depth as the depth buffer pass the test,
+which is required for the shading pass after a depth pre-pass (see prColorMask).
+By default PR_DEPTH_GREATER.
+*/
+void prDepthFunc(PRenum func);
+
 // --- drawing --- //
 
 //! Sets the clear color. Default is (0, 0, 0).
@@ -12,6 +12,7 @@
 #include "vertexbuffer.h"
 #include "indexbuffer.h"
 #include "texture.h"
+#include "atlas.h"
 #include "image.h"
 #include "state_machine.h"
 #include "global_state.h"
@@ -70,6 +71,8 @@ PRint prGetIntegerv(PRenum param)
     {
         case PR_MAX_TEXTURE_SIZE:
             return PR_MAX_TEX_SIZE;
+        case PR_NUM_THREADS:
+            return (PRint)_pr_thread_pool_num_threads(PR_THREAD_POOL);
     }
     return 0;
 }
@@ -93,14 +96,15 @@ void prMakeCurrent(PRobject context)
 
 void prPresent(PRobject context)
 {
+    _pr_framebuffer_resolve(PR_STATE_MACHINE.boundFrameBuffer);
     _pr_context_present((pr_context*)context, PR_STATE_MACHINE.boundFrameBuffer);
 }
 
 // --- framebuffer --- //
 
-PRobject prCreateFrameBuffer(PRuint width, PRuint height)
+PRobject prCreateFrameBuffer(PRuint width, PRuint height, PRenum depthFormat)
 {
-    return (PRobject)_pr_framebuffer_create(width, height);
+    return (PRobject)_pr_framebuffer_create(width, height, depthFormat);
 }
 
 void prDeleteFrameBuffer(PRobject frameBuffer)
@@ -137,13 +141,13 @@ void prBindTexture(PRobject texture)
 
 void prTexImage2D(
     PRobject texture, PRtexsize width, PRtexsize height, PRenum format,
-    const PRvoid* data, PRboolean dither, PRboolean generateMips)
+    const PRvoid* data, PRenum dither, PRboolean generateMips)
 {
     _pr_texture_image2d((pr_texture*)texture, width, height, format, data, dither, generateMips);
 }
 
 void prTexImage2DFromFile(
-    PRobject texture, const char* filename, PRboolean dither, PRboolean generateMips)
+    PRobject texture, const char* filename, PRenum dither, PRboolean generateMips)
 {
     pr_image* image = _pr_image_load_from_file(filename);
 
@@ -160,6 +164,13 @@ void prTexImage2DFromFile(
     _pr_image_delete(image);
 }
 
+void prTexSubImage2D(
+    PRobject texture, PRubyte mip, PRtexsize x, PRtexsize y, PRtexsize width, PRtexsize height,
+    PRenum format, const PRvoid* data, PRenum dither)
+{
+    _pr_texture_subimage2d((pr_texture*)texture, mip, x, y, width, height, format, data, dither);
+}
+
 void prTexEnvi(PRenum param, PRint value)
 {
     _pr_state_machine_set_texenvi(param, value);
@@ -170,6 +181,43 @@ PRint prGetTexLevelParameteri(PRobject texture, PRubyte mipLevel, PRenum param)
     return _pr_texture_get_mip_parameter((const pr_texture*)texture, mipLevel, param);
 }
 
+// --- atlas --- //
+
+PRobject prCreateAtlas(PRtexsize width, PRtexsize height, PRubyte mips)
+{
+    return (PRobject)_pr_atlas_create(width, height, mips);
+}
+
+void prDeleteAtlas(PRobject atlas)
+{
+    _pr_atlas_delete((pr_atlas*)atlas);
+}
+
+void prClearAtlas(PRobject atlas)
+{
+    _pr_atlas_clear((pr_atlas*)atlas);
+}
+
+PRint prAtlasImage2D(PRobject atlas, PRtexsize width, PRtexsize height, PRenum format, const PRvoid* data, PRenum dither)
+{
+    return _pr_atlas_image2d((pr_atlas*)atlas, width, height, format, data, dither);
+}
+
+void prGetAtlasRect(PRobject atlas, PRint entry, PRfloat* rect)
+{
+    _pr_atlas_entry_rect((const pr_atlas*)atlas, entry, rect);
+}
+
+PRobject prGetAtlasTexture(PRobject atlas)
+{
+    if (atlas == NULL)
+    {
+        _pr_error_set(PR_ERROR_NULL_POINTER, __FUNCTION__);
+        return NULL;
+    }
+    return (PRobject)(((pr_atlas*)atlas)->texture);
+}
+
 // --- vertexbuffer --- //
 
 PRobject prCreateVertexBuffer()
@@ -320,6 +368,26 @@ void prPolygonMode(PRenum mode)
     _pr_state_machine_polygon_mode(mode);
 }
 
+void prRasterizerMode(PRenum mode)
+{
+    _pr_state_machine_rasterizer_mode(mode);
+}
+
+void prColorMask(PRboolean flag)
+{
+    PR_STATE_MACHINE.colorMask = (flag != PR_FALSE ? PR_TRUE : PR_FALSE);
+}
+
+void prDepthMask(PRboolean flag)
+{
+    PR_STATE_MACHINE.depthMask = (flag != PR_FALSE ? PR_TRUE : PR_FALSE);
+}
+
+void prDepthFunc(PRenum func)
+{
+    _pr_state_machine_depth_func(func);
+}
+
 // --- drawing --- //
 
 void prClearColor(PRubyte r, PRubyte g, PRubyte b)
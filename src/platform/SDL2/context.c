@@ -109,7 +109,7 @@ void _pr_context_present(pr_context* context, const pr_framebuffer* framebuffer)
     pr_color* dst = context->colors;
     pr_color* dstEnd = dst + num;
 
-    const pr_pixel* pixels = framebuffer->pixels;
+    const PRcolorindex* colors = framebuffer->colors;
     const pr_color* palette = context->colorPalette->colors;
 
     #ifndef PR_COLOR_BUFFER_24BIT
@@ -121,9 +121,9 @@ void _pr_context_present(pr_context* context, const pr_framebuffer* framebuffer)
     while (dst != dstEnd)
     {
         #ifdef PR_COLOR_BUFFER_24BIT
-        *dst = pixels->colorIndex;
+        *dst = *colors;
         #else
-        paletteColor = (palette + pixels->colorIndex);
+        paletteColor = (palette + *colors);
 
         dst->r = paletteColor->r;
         dst->g = paletteColor->g;
@@ -131,7 +131,7 @@ void _pr_context_present(pr_context* context, const pr_framebuffer* framebuffer)
         #endif
 
         ++dst;
-        ++pixels;
+        ++colors;
     }
     SDL_RenderClear(context->ren);
     SDL_UpdateTexture(context->tex, NULL, context->colors, context->width * (sizeof(Uint8) * 3));
@@ -99,7 +99,7 @@ void _pr_context_present(pr_context* context, const pr_framebuffer* framebuffer)
     pr_color* dst = context->colors;
     pr_color* dstEnd = dst + num;
 
-    const pr_pixel* pixels = framebuffer->pixels;
+    const PRcolorindex* colors = framebuffer->colors;
     const pr_color* palette = context->colorPalette->colors;
 
     #ifndef PR_COLOR_BUFFER_24BIT
@@ -110,9 +110,9 @@ void _pr_context_present(pr_context* context, const pr_framebuffer* framebuffer)
     while (dst != dstEnd)
     {
         #ifdef PR_COLOR_BUFFER_24BIT
-        *dst = pixels->colorIndex;
+        *dst = *colors;
         #else
-        paletteColor = (palette + pixels->colorIndex);
+        paletteColor = (palette + *colors);
 
         dst->r = paletteColor->r;
         dst->g = paletteColor->g;
@@ -120,7 +120,7 @@ void _pr_context_present(pr_context* context, const pr_framebuffer* framebuffer)
         #endif
 
         ++dst;
-        ++pixels;
+        ++colors;
     }
 
     //todo...
@@ -100,7 +100,7 @@ void _pr_context_present(pr_context* context, const pr_framebuffer* framebuffer)
     pr_color* dst = (pr_color*)[bmp bitmapData];
     pr_color* dstEnd = dst + num;
 
-    const pr_pixel* pixels = framebuffer->pixels;
+    const PRcolorindex* colors = framebuffer->colors;
 
     const pr_color* palette = context->colorPalette->colors;
     const pr_color* paletteColor;
@@ -108,14 +108,14 @@ void _pr_context_present(pr_context* context, const pr_framebuffer* framebuffer)
     // Iterate over all pixels
     while (dst != dstEnd)
     {
-        paletteColor = (palette + pixels->colorIndex);
+        paletteColor = (palette + *colors);
 
         dst->r = paletteColor->r;
         dst->g = paletteColor->g;
         dst->b = paletteColor->b;
 
         ++dst;
-        ++pixels;
+        ++colors;
     }
     
     // Present final bitmap
@@ -101,7 +101,7 @@ void _pr_context_present(pr_context* context, const pr_framebuffer* framebuffer)
     pr_color* dst = context->colors;
     pr_color* dstEnd = dst + num;
 
-    const pr_pixel* pixels = framebuffer->pixels;
+    const PRcolorindex* colors = framebuffer->colors;
     const pr_color* palette = context->colorPalette->colors;
 
     #ifndef PR_COLOR_BUFFER_24BIT
@@ -112,9 +112,9 @@ void _pr_context_present(pr_context* context, const pr_framebuffer* framebuffer)
     while (dst != dstEnd)
     {
         #ifdef PR_COLOR_BUFFER_24BIT
-        *dst = pixels->colorIndex;
+        *dst = *colors;
         #else
-        paletteColor = (palette + pixels->colorIndex);
+        paletteColor = (palette + *colors);
 
         dst->r = paletteColor->r;
         dst->g = paletteColor->g;
@@ -122,7 +122,7 @@ void _pr_context_present(pr_context* context, const pr_framebuffer* framebuffer)
         #endif
 
         ++dst;
-        ++pixels;
+        ++colors;
     }
 
     // Show framebuffer on device context ('SetDIBits' only needs a device context when 'DIB_PAL_COLORS' is used)
@@ -0,0 +1,269 @@
+/*
+ * atlas.c
+ * 
+ * This file is part of the "PicoRenderer" (Copyright (c) 2014 by Lukas Hermanns)
+ * See "LICENSE.txt" for license information.
+ */
+
+#include "atlas.h"
+#include "ext_math.h"
+#include "error.h"
+#include "helper.h"
+#include "state_machine.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// --- internals --- //
+
+static void _atlas_reset(pr_atlas* atlas)
+{
+    // The skyline starts with a single segment over the whole width
+    atlas->numNodes         = 1;
+    atlas->nodes[0].x       = 0;
+    atlas->nodes[0].y       = 0;
+    atlas->nodes[0].width   = atlas->numCellsX;
+    atlas->numEntries       = 0;
+}
+
+/*
+Returns the top row of a rectangle (in cells) which is placed at the left of the skyline segment 'index',
+i.e. the lowest row above all segments it spans, or -1 if the rectangle does not fit into the atlas there.
+*/
+static PRint _atlas_fit(const pr_atlas* atlas, PRint index, PRint width, PRint height)
+{
+    const pr_atlas_node* node = &(atlas->nodes[index]);
+
+    if (node->x + width > atlas->numCellsX)
+        return -1;
+
+    PRint y = 0;
+
+    for (PRint widthLeft = width; widthLeft > 0; ++node)
+    {
+        y = PR_MAX(y, node->y);
+        if (y + height > atlas->numCellsY)
+            return -1;
+        widthLeft -= node->width;
+    }
+
+    return y;
+}
+
+static void _atlas_remove_node(pr_atlas* atlas, PRint index)
+{
+    --atlas->numNodes;
+    memmove(&(atlas->nodes[index]), &(atlas->nodes[index + 1]), sizeof(pr_atlas_node)*(atlas->numNodes - index));
+}
+
+// Raises the skyline over the rectangle (in cells), which is placed at the left of the skyline segment 'index'.
+static void _atlas_insert_node(pr_atlas* atlas, PRint index, PRint y, PRint width, PRint height)
+{
+    pr_atlas_node* nodes = atlas->nodes;
+
+    // Insert new segment on top of the rectangle
+    memmove(&(nodes[index + 1]), &(nodes[index]), sizeof(pr_atlas_node)*(atlas->numNodes - index));
+    ++atlas->numNodes;
+
+    nodes[index].y = y + height;
+    nodes[index].width = width;
+
+    // Shrink or remove the following segments which are covered by the new one
+    for (PRint i = index + 1; i < atlas->numNodes;)
+    {
+        const PRint prevRight = nodes[i - 1].x + nodes[i - 1].width;
+        if (nodes[i].x >= prevRight)
+            break;
+
+        const PRint shrink = prevRight - nodes[i].x;
+        nodes[i].x += shrink;
+        nodes[i].width -= shrink;
+
+        if (nodes[i].width > 0)
+            break;
+
+        _atlas_remove_node(atlas, i);
+    }
+
+    // Merge neighboring segments of the same height
+    for (PRint i = 0; i + 1 < atlas->numNodes;)
+    {
+        if (nodes[i].y == nodes[i + 1].y)
+        {
+            nodes[i].width += nodes[i + 1].width;
+            _atlas_remove_node(atlas, i + 1);
+        }
+        else
+            ++i;
+    }
+}
+
+static void _atlas_add_entry(pr_atlas* atlas, PRtexsize x, PRtexsize y, PRtexsize width, PRtexsize height)
+{
+    if (atlas->numEntries == atlas->capacity)
+    {
+        atlas->capacity = (atlas->capacity < 16 ? 16 : atlas->capacity*2);
+        atlas->entries = (pr_atlas_entry*)realloc(atlas->entries, sizeof(pr_atlas_entry) * atlas->capacity);
+    }
+
+    pr_atlas_entry* entry = &(atlas->entries[atlas->numEntries++]);
+
+    entry->x        = x;
+    entry->y        = y;
+    entry->width    = width;
+    entry->height   = height;
+}
+
+// --- interface --- //
+
+pr_atlas* _pr_atlas_create(PRtexsize width, PRtexsize height, PRubyte mips)
+{
+    if (mips == 0 || mips > PR_MAX_NUM_MIPS)
+    {
+        _pr_error_set(PR_ERROR_INVALID_ARGUMENT, "invalid number of MIP levels");
+        return NULL;
+    }
+
+    // Each skyline cell is as large as one texel of the last MIP level
+    const PRint alignment = (1 << (mips - 1));
+
+    if (width < alignment || height < alignment)
+    {
+        _pr_error_set(PR_ERROR_INVALID_ARGUMENT, "texture atlas is too small for the number of MIP levels");
+        return NULL;
+    }
+
+    // Create texture
+    pr_texture* texture = _pr_texture_create();
+
+    if (!_pr_texture_storage2d(texture, width, height, mips))
+    {
+        _pr_texture_delete(texture);
+        return NULL;
+    }
+
+    // Create atlas
+    pr_atlas* atlas = PR_MALLOC(pr_atlas);
+
+    atlas->texture      = texture;
+    atlas->alignment    = alignment;
+    atlas->numCellsX    = width / alignment;
+    atlas->numCellsY    = height / alignment;
+    atlas->nodes        = PR_CALLOC(pr_atlas_node, atlas->numCellsX + 1);
+    atlas->capacity     = 0;
+    atlas->entries      = NULL;
+
+    _atlas_reset(atlas);
+
+    _pr_ref_add(atlas);
+
+    return atlas;
+}
+
+void _pr_atlas_delete(pr_atlas* atlas)
+{
+    if (atlas != NULL)
+    {
+        _pr_ref_release(atlas);
+
+        _pr_texture_delete(atlas->texture);
+        PR_FREE(atlas->nodes);
+        PR_FREE(atlas->entries);
+        PR_FREE(atlas);
+    }
+}
+
+void _pr_atlas_clear(pr_atlas* atlas)
+{
+    if (atlas == NULL)
+    {
+        _pr_error_set(PR_ERROR_NULL_POINTER, __FUNCTION__);
+        return;
+    }
+
+    pr_texture* texture = atlas->texture;
+    _pr_texture_storage2d(texture, texture->width, texture->height, texture->mips);
+
+    _atlas_reset(atlas);
+}
+
+PRint _pr_atlas_image2d(pr_atlas* atlas, PRtexsize width, PRtexsize height, PRenum format, const PRvoid* data, PRenum dither)
+{
+    // Validate parameters
+    if (atlas == NULL)
+    {
+        _pr_error_set(PR_ERROR_NULL_POINTER, __FUNCTION__);
+        return -1;
+    }
+    if (width <= 0 || height <= 0)
+    {
+        _pr_error_set(PR_ERROR_INVALID_ARGUMENT, "textures must not have a size equal to zero");
+        return -1;
+    }
+
+    // Determine the size in cells
+    const PRint cellsX = (width + atlas->alignment - 1) / atlas->alignment;
+    const PRint cellsY = (height + atlas->alignment - 1) / atlas->alignment;
+
+    // Find the segment where the rectangle ends up lowest (then on the narrowest segment)
+    PRint bestIndex = -1, bestY = 0;
+    PRint bestBottom = INT_MAX, bestWidth = INT_MAX;
+
+    for (PRint i = 0; i < atlas->numNodes; ++i)
+    {
+        const PRint y = _atlas_fit(atlas, i, cellsX, cellsY);
+
+        if (y >= 0 && (y + cellsY < bestBottom || (y + cellsY == bestBottom && atlas->nodes[i].width < bestWidth)))
+        {
+            bestIndex   = i;
+            bestY       = y;
+            bestBottom  = y + cellsY;
+            bestWidth   = atlas->nodes[i].width;
+        }
+    }
+
+    if (bestIndex < 0)
+    {
+        _pr_error_set(PR_ERROR_INVALID_STATE, "not enough space left in texture atlas");
+        return -1;
+    }
+
+    // Store the image with its MIP chain (the texture validates the image data)
+    const PRtexsize x = (PRtexsize)(atlas->nodes[bestIndex].x * atlas->alignment);
+    const PRtexsize y = (PRtexsize)(bestY * atlas->alignment);
+
+    if (!_pr_texture_subimage2d_chain(atlas->texture, x, y, width, height, format, data, dither))
+        return -1;
+
+    _atlas_insert_node(atlas, bestIndex, bestY, cellsX, cellsY);
+    _atlas_add_entry(atlas, x, y, width, height);
+
+    return atlas->numEntries - 1;
+}
+
+PRboolean _pr_atlas_entry_rect(const pr_atlas* atlas, PRint entry, PRfloat* rect)
+{
+    if (atlas == NULL || rect == NULL)
+    {
+        _pr_error_set(PR_ERROR_NULL_POINTER, __FUNCTION__);
+        return PR_FALSE;
+    }
+    if (entry < 0 || entry >= atlas->numEntries)
+    {
+        _pr_error_set(PR_ERROR_INDEX_OUT_OF_BOUNDS, __FUNCTION__);
+        return PR_FALSE;
+    }
+
+    const pr_atlas_entry* e = &(atlas->entries[entry]);
+    const PRfloat invWidth = 1.0f / atlas->texture->width;
+    const PRfloat invHeight = 1.0f / atlas->texture->height;
+
+    rect[0] = invWidth * e->x;
+    rect[1] = invHeight * e->y;
+    rect[2] = invWidth * (e->x + e->width);
+    rect[3] = invHeight * (e->y + e->height);
+
+    return PR_TRUE;
+}
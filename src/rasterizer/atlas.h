@@ -0,0 +1,68 @@
+/*
+ * atlas.h
+ * 
+ * This file is part of the "PicoRenderer" (Copyright (c) 2014 by Lukas Hermanns)
+ * See "LICENSE.txt" for license information.
+ */
+
+#ifndef __PR_ATLAS_H__
+#define __PR_ATLAS_H__
+
+
+#include "types.h"
+#include "texture.h"
+
+
+//! Segment of the skyline: the cells [x, x + width) are occupied from the top down to row 'y' (in units of the alignment).
+typedef struct pr_atlas_node
+{
+    PRint x;
+    PRint y;
+    PRint width;
+}
+pr_atlas_node;
+
+//! Rectangle of an atlas entry in texels of the first MIP level.
+typedef struct pr_atlas_entry
+{
+    PRtexsize x;
+    PRtexsize y;
+    PRtexsize width;
+    PRtexsize height;
+}
+pr_atlas_entry;
+
+/**
+Texture atlas which packs many images into the texels of a single texture, so that all of them are drawn with the same bound texture.
+The images are packed with a bottom-left skyline packer. Each entry stores its own MIP chain at its scaled rectangle
+in the MIP levels of the texture, so the entries are aligned to 2^(mips - 1) texels to never share a texel in any MIP level.
+*/
+typedef struct pr_atlas
+{
+    pr_texture*     texture;    //!< Texture which stores the entries.
+    PRint           alignment;  //!< Alignment of the entry positions in texels (the size of a skyline cell).
+    PRint           numCellsX;  //!< Number of skyline cells in width.
+    PRint           numCellsY;  //!< Number of skyline cells in height.
+    PRint           numNodes;   //!< Number of skyline segments.
+    pr_atlas_node*  nodes;      //!< Skyline segments from left to right (at most one per cell in width).
+    PRint           numEntries; //!< Number of packed entries.
+    PRint           capacity;   //!< Capacity of the entry array.
+    pr_atlas_entry* entries;    //!< Packed entries in the order they were added.
+}
+pr_atlas;
+
+
+pr_atlas* _pr_atlas_create(PRtexsize width, PRtexsize height, PRubyte mips);
+void _pr_atlas_delete(pr_atlas* atlas);
+
+//! Removes all entries from the specified atlas and clears its texels.
+void _pr_atlas_clear(pr_atlas* atlas);
+
+//! Packs the image into the specified atlas and returns the index of the new entry, or -1 if the atlas has not enough space left.
+PRint _pr_atlas_image2d(pr_atlas* atlas, PRtexsize width, PRtexsize height, PRenum format, const PRvoid* data, PRenum dither);
+
+//! Stores the texture coordinates of the specified entry in 'rect': left, top, right, bottom.
+PRboolean _pr_atlas_entry_rect(const pr_atlas* atlas, PRint entry, PRfloat* rect);
+
+
+#endif
@@ -8,6 +8,197 @@
 #include "color_palette.h"
 #include "error.h"
 
+// SIMD conversion only for 8-bit color indices
+#ifndef PR_COLOR_BUFFER_24BIT
+#   if defined(PR_SIMD_AVX2)
+#       include <immintrin.h>
+#       define _COLOR_AVX2
+#   endif
+#   if defined(PR_SIMD_SSE2)
+#       include <emmintrin.h>
+#       define _COLOR_SSE2
+#   endif
+#endif
+
+
+// --- internals --- //
+
+#ifdef _COLOR_SSE2
+
+/*
+Computes the R3G3B2 color indices of four RGBx colors (red in the lowest byte of each 32-bit lane).
+The indices are stored in the lowest byte of each lane, the other bytes are zero.
+*/
+PR_INLINE __m128i _colorindex4_sse2(__m128i rgbx)
+{
+    return _mm_or_si128(
+        _mm_and_si128(rgbx, _mm_set1_epi32(0xe0)),
+        _mm_or_si128(
+            _mm_and_si128(_mm_srli_epi32(rgbx, 11), _mm_set1_epi32(0x1c)),
+            _mm_and_si128(_mm_srli_epi32(rgbx, 22), _mm_set1_epi32(0x03))
+        )
+    );
+}
+
+// Expands four packed RGB colors (12 bytes, 16 bytes are read) into RGBx lanes.
+PR_INLINE __m128i _load_rgb4_sse2(const PRubyte* src)
+{
+    const __m128i rgb = _mm_loadu_si128((const __m128i*)src);
+
+    // Lane i needs the bytes [3*i, 3*i + 3), i.e. the packed colors shifted by i bytes
+    return _mm_or_si128(
+        _mm_or_si128(
+            _mm_and_si128(rgb, _mm_setr_epi32(-1, 0, 0, 0)),
+            _mm_and_si128(_mm_slli_si128(rgb, 1), _mm_setr_epi32(0, -1, 0, 0))
+        ),
+        _mm_or_si128(
+            _mm_and_si128(_mm_slli_si128(rgb, 2), _mm_setr_epi32(0, 0, -1, 0)),
+            _mm_and_si128(_mm_slli_si128(rgb, 3), _mm_setr_epi32(0, 0, 0, -1))
+        )
+    );
+}
+
+// Packs the color indices of 4x4 lanes (see _colorindex4_sse2) into 16 bytes.
+PR_INLINE void _store_colorindex16_sse2(PRubyte* dst, __m128i a, __m128i b, __m128i c, __m128i d)
+{
+    _mm_storeu_si128((__m128i*)dst, _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+}
+
+#endif
+
+#ifdef _COLOR_AVX2
+
+// AVX2 version of _colorindex4_sse2 for eight RGBx colors.
+PR_INLINE __m256i _colorindex8_avx2(__m256i rgbx)
+{
+    return _mm256_or_si256(
+        _mm256_and_si256(rgbx, _mm256_set1_epi32(0xe0)),
+        _mm256_or_si256(
+            _mm256_and_si256(_mm256_srli_epi32(rgbx, 11), _mm256_set1_epi32(0x1c)),
+            _mm256_and_si256(_mm256_srli_epi32(rgbx, 22), _mm256_set1_epi32(0x03))
+        )
+    );
+}
+
+// Expands eight packed RGB colors (24 bytes, 28 bytes are read) into RGBx lanes.
+PR_INLINE __m256i _load_rgb8_avx2(const PRubyte* src)
+{
+    // Each 128-bit half holds four colors, so a single in-lane byte shuffle spreads them
+    const __m256i rgb = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)src)),
+        _mm_loadu_si128((const __m128i*)(src + 12)),
+        1
+    );
+    const __m256i shuffle = _mm256_setr_epi8(
+        0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+        0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1
+    );
+    return _mm256_shuffle_epi8(rgb, shuffle);
+}
+
+// Packs the color indices of 4x8 lanes (see _colorindex8_avx2) into 32 bytes.
+PR_INLINE void _store_colorindex32_avx2(PRubyte* dst, __m256i a, __m256i b, __m256i c, __m256i d)
+{
+    // Packing works within the 128-bit halves, so the 32-bit groups must be put back in order
+    const __m256i indices = _mm256_packus_epi16(_mm256_packs_epi32(a, b), _mm256_packs_epi32(c, d));
+    _mm256_storeu_si256((__m256i*)dst, _mm256_permutevar8x32_epi32(indices, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7)));
+}
+
+#endif
+
+#ifdef _COLOR_SSE2
+
+// Converts the largest multiple of 16 gray values and returns the number of converted values.
+static PRuint _convert_gray_sse2(PRubyte* dst, const PRubyte* src, PRuint count)
+{
+    PRuint i = 0;
+
+    // The masks remove the bits that the 16-bit shifts move in from the neighboring bytes
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m128i gray = _mm_loadu_si128((const __m128i*)(src + i));
+        const __m128i indices = _mm_or_si128(
+            _mm_and_si128(gray, _mm_set1_epi8((char)0xe0)),
+            _mm_or_si128(
+                _mm_and_si128(_mm_srli_epi16(gray, 3), _mm_set1_epi8(0x1c)),
+                _mm_and_si128(_mm_srli_epi16(gray, 6), _mm_set1_epi8(0x03))
+            )
+        );
+        _mm_storeu_si128((__m128i*)(dst + i), indices);
+    }
+
+    return i;
+}
+
+// Converts RGB or RGBA colors in groups of 16 (SSE2) or 32 (AVX2) and returns the number of converted colors.
+static PRuint _convert_rgb_simd(PRubyte* dst, const PRubyte* src, PRuint count, PRint format)
+{
+    PRuint i = 0;
+
+    if (format == 4)
+    {
+        #ifdef _COLOR_AVX2
+        for (; i + 32 <= count; i += 32)
+        {
+            const __m256i* rgba = (const __m256i*)(src + i*4);
+            _store_colorindex32_avx2(
+                dst + i,
+                _colorindex8_avx2(_mm256_loadu_si256(rgba    )),
+                _colorindex8_avx2(_mm256_loadu_si256(rgba + 1)),
+                _colorindex8_avx2(_mm256_loadu_si256(rgba + 2)),
+                _colorindex8_avx2(_mm256_loadu_si256(rgba + 3))
+            );
+        }
+        #endif
+
+        for (; i + 16 <= count; i += 16)
+        {
+            const __m128i* rgba = (const __m128i*)(src + i*4);
+            _store_colorindex16_sse2(
+                dst + i,
+                _colorindex4_sse2(_mm_loadu_si128(rgba    )),
+                _colorindex4_sse2(_mm_loadu_si128(rgba + 1)),
+                _colorindex4_sse2(_mm_loadu_si128(rgba + 2)),
+                _colorindex4_sse2(_mm_loadu_si128(rgba + 3))
+            );
+        }
+    }
+    else
+    {
+        // The last load reads 4 bytes beyond its colors, so keep two more colors in the source
+        #ifdef _COLOR_AVX2
+        for (; i + 34 <= count; i += 32)
+        {
+            const PRubyte* rgb = src + i*3;
+            _store_colorindex32_avx2(
+                dst + i,
+                _colorindex8_avx2(_load_rgb8_avx2(rgb     )),
+                _colorindex8_avx2(_load_rgb8_avx2(rgb + 24)),
+                _colorindex8_avx2(_load_rgb8_avx2(rgb + 48)),
+                _colorindex8_avx2(_load_rgb8_avx2(rgb + 72))
+            );
+        }
+        #endif
+
+        for (; i + 18 <= count; i += 16)
+        {
+            const PRubyte* rgb = src + i*3;
+            _store_colorindex16_sse2(
+                dst + i,
+                _colorindex4_sse2(_load_rgb4_sse2(rgb     )),
+                _colorindex4_sse2(_load_rgb4_sse2(rgb + 12)),
+                _colorindex4_sse2(_load_rgb4_sse2(rgb + 24)),
+                _colorindex4_sse2(_load_rgb4_sse2(rgb + 36))
+            );
+        }
+    }
+
+    return i;
+}
+
+#endif
+
+// --- interface --- //
 
 /*
 8-bit color encoding:
@@ -47,27 +238,38 @@ void _pr_color_palette_fill_r3g3b2(pr_color_palette* colorPalette)
     }
 }
 
-PRcolorindex _pr_color_to_colorindex(PRubyte r, PRubyte g, PRubyte b)
+void _pr_color_to_colorindex_array(PRcolorindex* dstColors, const PRubyte* srcColors, PRuint count, PRint format)
 {
-    #ifdef PR_COLOR_BUFFER_24BIT
-
-    PRcolorindex color;
-    color.r = r;
-    color.g = g;
-    color.b = b;
-    return color;
-
-    #else
-
-    /*
-    No need to crop numbers by bitwise AND 0x07 or 0x03,
-    since PRubyte cannot exceed the ranges.
-    */
-    return
-        ((r / PR_COLORINDEX_SELECT_RED  ) << 5) |
-        ((g / PR_COLORINDEX_SELECT_GREEN) << 2) |
-        ( b / PR_COLORINDEX_SELECT_BLUE       );
-
-    #endif
-}
+    if (dstColors == NULL || srcColors == NULL)
+    {
+        _pr_error_set(PR_ERROR_NULL_POINTER, __FUNCTION__);
+        return;
+    }
+    if (format < 1 || format > 4)
+    {
+        _pr_error_set(PR_ERROR_INVALID_ARGUMENT, __FUNCTION__);
+        return;
+    }
+
+    PRuint i = 0;
 
+    if (format < 3)
+    {
+        #ifdef _COLOR_SSE2
+        if (format == 1)
+            i = _convert_gray_sse2(dstColors, srcColors, count);
+        #endif
+
+        for (const PRubyte* src = srcColors + i*format; i < count; ++i, src += format)
+            dstColors[i] = _pr_color_to_colorindex(*src, *src, *src);
+    }
+    else
+    {
+        #ifdef _COLOR_SSE2
+        i = _convert_rgb_simd(dstColors, srcColors, count, format);
+        #endif
+
+        for (const PRubyte* src = srcColors + i*format; i < count; ++i, src += format)
+            dstColors[i] = _pr_color_to_colorindex(src[0], src[1], src[2]);
+    }
+}
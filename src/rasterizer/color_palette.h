@@ -33,7 +33,57 @@ pr_color_palette;
 void _pr_color_palette_fill_r3g3b2(pr_color_palette* colorPalette);
 
 //! Converts the specified RGB color into a color index with encoding R3G3B2.
-PRcolorindex _pr_color_to_colorindex(PRubyte r, PRubyte g, PRubyte b);
+PR_INLINE PRcolorindex _pr_color_to_colorindex(PRubyte r, PRubyte g, PRubyte b)
+{
+    #ifdef PR_COLOR_BUFFER_24BIT
+
+    PRcolorindex color;
+    color.r = r;
+    color.g = g;
+    color.b = b;
+    return color;
+
+    #else
+
+    /*
+    No need to crop numbers by bitwise AND 0x07 or 0x03,
+    since PRubyte cannot exceed the ranges.
+    */
+    return
+        ((r / PR_COLORINDEX_SELECT_RED  ) << 5) |
+        ((g / PR_COLORINDEX_SELECT_GREEN) << 2) |
+        ( b / PR_COLORINDEX_SELECT_BLUE       );
+
+    #endif
+}
+
+//! Converts the specified color index with encoding R3G3B2 back into its palette color (see _pr_color_palette_fill_r3g3b2).
+PR_INLINE pr_color _pr_color_from_colorindex(PRcolorindex colorIndex)
+{
+    #ifdef PR_COLOR_BUFFER_24BIT
+
+    return colorIndex;
+
+    #else
+
+    pr_color color;
+    color.r = (PRubyte)((((colorIndex >> 5) & 0x07)*255 + 3) / 7);
+    color.g = (PRubyte)((((colorIndex >> 2) & 0x07)*255 + 3) / 7);
+    color.b = (PRubyte)(( colorIndex       & 0x03)*85);
+    return color;
+
+    #endif
+}
+
+/**
+Converts an array of colors into color indices with encoding R3G3B2.
+With the default 8-bit color buffer, this uses SSE2 (16 colors per iteration) or AVX2 (32 colors per iteration) if available.
+\param[out] dstColors Pointer to the destination color indices. This must have at least 'count' entries.
+\param[in] srcColors Pointer to the source colors with 'format' components each.
+\param[in] count Specifies the number of colors to convert.
+\param[in] format Specifies the source color format: 1 (gray), 2 (gray and alpha), 3 (RGB) or 4 (RGBA).
+*/
+void _pr_color_to_colorindex_array(PRcolorindex* dstColors, const PRubyte* srcColors, PRuint count, PRint format);
 
 
 #endif
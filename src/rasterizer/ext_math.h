@@ -23,6 +23,7 @@
 #define PR_CLAMP_SMALLEST(x, c) if ((x) > (c)) x = c
 
 #define PR_SIGN(x)              (((x) > 0) ? 1 : ((x) < 0) ? -1 : 0)
+#define PR_ABS(x)               ((x) < 0 ? -(x) : (x))
 
 #define PR_SQ(x)                ((x)*(x))
 
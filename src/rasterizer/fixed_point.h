@@ -0,0 +1,102 @@
+/*
+ * fixed_point.h
+ *
+ * This file is part of the "PicoRenderer" (Copyright (c) 2014 by Lukas Hermanns)
+ * See "LICENSE.txt" for license information.
+ */
+
+#ifndef __PR_FIXED_POINT_H__
+#define __PR_FIXED_POINT_H__
+
+
+#include "types.h"
+#include "static_config.h"
+
+
+//! 64-bit integer type for intermediate fixed-point products.
+typedef long long PRint64;
+
+#ifdef PR_FIXED_POINT
+
+//! Number of fractional bits of the raster vertex screen coordinates (28.4 format).
+#define PR_SUBPIXEL_BITS            4
+
+//! Number of fractional bits of the interpolation type (16.16 format).
+#define PR_INTERP_BITS              16
+#define PR_INTERP_ONE               (1 << PR_INTERP_BITS)
+
+#define PR_INTERP_FROM_FLOAT(x)     ((PRinterp)((x) * (PRfloat)PR_INTERP_ONE))
+#define PR_INTERP_TO_FLOAT(x)       ((PRfloat)(x) * (1.0f / (PRfloat)PR_INTERP_ONE))
+
+//! Returns (a*b)/c with a 64-bit intermediate product, which is required to interpolate 16.16 values without overflow.
+#define PR_INTERP_MULDIV(a, b, c)   ((PRinterp)(((PRint64)(a) * (b)) / (c)))
+
+#define PR_INTERP_FROM_REAL(x)      PR_INTERP_FROM_FLOAT(x)
+#define PR_INTERP_TO_REAL(x)        PR_INTERP_TO_FLOAT(x)
+
+//! Real type for interpolation factors and plane equations.
+typedef PRfloat PRinterpreal;
+
+//! Integer type for products of raster vertex coordinates (e.g. edge functions and polygon areas).
+typedef PRint64 PRareatype;
+
+//! Number of additional fractional bits of the accumulator type (32.32 format).
+#define PR_INTERP_ACC_BITS          16
+#define PR_INTERP_ACC_ONE           ((PRint64)1 << PR_INTERP_ACC_BITS)
+
+/**
+Accumulator type for interpolated values which are incremented per row or pixel.
+The additional fractional bits keep the truncation error of the steps far below one unit of PRinterp.
+*/
+typedef PRint64 PRinterpacc;
+
+#define PR_INTERP_ACC_FROM_INTERP(x)    ((PRinterpacc)(x) * PR_INTERP_ACC_ONE)
+#define PR_INTERP_ACC_TO_INTERP(x)      ((PRinterp)((x) >> PR_INTERP_ACC_BITS))
+#define PR_INTERP_ACC_FROM_REAL(x)      ((PRinterpacc)((x) * ((PRfloat)PR_INTERP_ONE * (PRfloat)PR_INTERP_ACC_ONE)))
+#define PR_INTERP_ACC_TO_FLOAT(x)       ((PRfloat)(x) * (1.0f / ((PRfloat)PR_INTERP_ONE * (PRfloat)PR_INTERP_ACC_ONE)))
+
+//! Returns (a*b)/c as accumulator value, where 'a' is a difference of PRinterp values.
+#define PR_INTERP_ACC_MULDIV(a, b, c)   (((PRinterpacc)(a) * (b) * PR_INTERP_ACC_ONE) / (c))
+
+#else
+
+#define PR_SUBPIXEL_BITS            0
+
+#define PR_INTERP_FROM_FLOAT(x)     ((PRinterp)(x))
+#define PR_INTERP_TO_FLOAT(x)       ((PRfloat)(x))
+
+#define PR_INTERP_MULDIV(a, b, c)   ((a) * (b) / (c))
+
+#define PR_INTERP_FROM_REAL(x)      (x)
+#define PR_INTERP_TO_REAL(x)        (x)
+
+typedef PRinterp PRinterpreal;
+typedef PRint PRareatype;
+
+typedef PRinterp PRinterpacc;
+
+#define PR_INTERP_ACC_FROM_INTERP(x)    (x)
+#define PR_INTERP_ACC_TO_INTERP(x)      (x)
+#define PR_INTERP_ACC_FROM_REAL(x)      (x)
+#define PR_INTERP_ACC_TO_FLOAT(x)       ((PRfloat)(x))
+
+#define PR_INTERP_ACC_MULDIV(a, b, c)   ((a) * (b) / (c))
+
+#endif
+
+#define PR_SUBPIXEL_ONE             (1 << PR_SUBPIXEL_BITS)
+
+//! Converts the specified pixel coordinate to a raster vertex coordinate.
+#define PR_RASTER_FROM_PIXEL(x)     ((x) * PR_SUBPIXEL_ONE)
+
+//! Rounds the specified raster vertex coordinate to the nearest pixel.
+#define PR_RASTER_TO_PIXEL(x)       (((x) + (PR_SUBPIXEL_ONE >> 1)) >> PR_SUBPIXEL_BITS)
+
+//! Returns the first pixel whose center is greater than or equal to the specified raster vertex coordinate.
+#define PR_RASTER_CEIL(x)           (((x) + PR_SUBPIXEL_ONE - 1) >> PR_SUBPIXEL_BITS)
+
+//! Returns the last pixel whose center is less than or equal to the specified raster vertex coordinate.
+#define PR_RASTER_FLOOR(x)          ((x) >> PR_SUBPIXEL_BITS)
+
+
+#endif
@@ -10,14 +10,174 @@
 #include "helper.h"
 #include "state_machine.h"
 #include "color_palette.h"
+#include "ext_math.h"
 
 #include <stdlib.h>
 #include <string.h>
+#include <float.h>
 
+// SIMD depth scan and fill (for fixed-point depths only with the default format, i.e. 16-bit depths)
+#ifdef PR_SIMD_SSE2
+#   include <emmintrin.h>
+#   define _DEPTH_FLOAT_SSE2
+#   ifndef PR_DEPTH_BUFFER_8BIT
+#       define _DEPTH_FIXED_SSE2
+#   endif
+#endif
 
-pr_framebuffer* _pr_framebuffer_create(PRuint width, PRuint height)
+
+// --- internals --- //
+
+static void _fill_colors(PRcolorindex* colors, PRcolorindex color, PRuint count)
+{
+    #ifdef PR_COLOR_BUFFER_24BIT
+    for (PRuint i = 0; i < count; ++i)
+        colors[i] = color;
+    #else
+    memset(colors, color, count);
+    #endif
+}
+
+// Fills the specified range of the depth plane with the depth of the pending clears.
+static void _fill_depths(pr_framebuffer* frameBuffer, PRuint offset, PRuint count)
+{
+    const PRuint bits = frameBuffer->clearDepth;
+    PRuint i = 0;
+
+    if (frameBuffer->depthFormat == PR_DEPTH_COMPONENT32F)
+    {
+        PRfloat* depths = (PRfloat*)frameBuffer->depths + offset;
+
+        // Zero bits are also the float zero (the default clear depth)
+        if (bits == 0)
+        {
+            memset(depths, 0, count * sizeof(PRfloat));
+            return;
+        }
+
+        PRfloat depth;
+        memcpy(&depth, &bits, sizeof(depth));
+
+        #ifdef _DEPTH_FLOAT_SSE2
+        const __m128 depths4 = _mm_set1_ps(depth);
+        for (; i + 4 <= count; i += 4)
+            _mm_storeu_ps(depths + i, depths4);
+        #endif
+
+        for (; i < count; ++i)
+            depths[i] = depth;
+    }
+    else
+    {
+        PRdepthtype* depths = (PRdepthtype*)frameBuffer->depths + offset;
+        const PRdepthtype depth = (PRdepthtype)bits;
+
+        // Byte-wise fill is only possible for zero (the default clear depth) or 8-bit depths
+        if (depth == 0 || sizeof(PRdepthtype) == 1)
+        {
+            memset(depths, (int)depth, count * sizeof(PRdepthtype));
+            return;
+        }
+
+        #ifdef _DEPTH_FIXED_SSE2
+        const __m128i depths8 = _mm_set1_epi16((short)depth);
+        for (; i + 8 <= count; i += 8)
+            _mm_storeu_si128((__m128i*)(depths + i), depths8);
+        #endif
+
+        for (; i < count; ++i)
+            depths[i] = depth;
+    }
+}
+
+// Returns the minimum of the fixed-point depths in the specified rectangle of the depth plane.
+static PRuint _scan_min_depth_fixed(const pr_framebuffer* frameBuffer, PRuint left, PRuint top, PRuint width, PRuint height)
 {
-    if (width == 0 || height == 0)
+    PRdepthtype minDepth = PR_DEPTH_MAX;
+
+    #ifdef _DEPTH_FIXED_SSE2
+    // Depths are biased for the signed 16-bit minimum (SSE2 has no unsigned one)
+    const __m128i bias = _mm_set1_epi16((short)0x8000);
+    __m128i minDepths = _mm_set1_epi16(0x7fff);
+    #endif
+
+    for (PRuint y = 0; y < height; ++y)
+    {
+        const PRdepthtype* depths = (const PRdepthtype*)frameBuffer->depths + ((top + y) * frameBuffer->width + left);
+        PRuint x = 0;
+
+        #ifdef _DEPTH_FIXED_SSE2
+        for (; x + 8 <= width; x += 8)
+            minDepths = _mm_min_epi16(minDepths, _mm_xor_si128(_mm_loadu_si128((const __m128i*)(depths + x)), bias));
+        #endif
+
+        for (; x < width; ++x)
+        {
+            if (minDepth > depths[x])
+                minDepth = depths[x];
+        }
+    }
+
+    #ifdef _DEPTH_FIXED_SSE2
+    PRushort lanes[8];
+    _mm_storeu_si128((__m128i*)lanes, _mm_xor_si128(minDepths, bias));
+    for (PRint i = 0; i < 8; ++i)
+    {
+        if (minDepth > lanes[i])
+            minDepth = lanes[i];
+    }
+    #endif
+
+    return (PRuint)minDepth;
+}
+
+// Returns the bits of the minimum of the float depths in the specified rectangle of the depth plane.
+static PRuint _scan_min_depth_float(const pr_framebuffer* frameBuffer, PRuint left, PRuint top, PRuint width, PRuint height)
+{
+    PRfloat minDepth = FLT_MAX;
+
+    #ifdef _DEPTH_FLOAT_SSE2
+    __m128 minDepths = _mm_set1_ps(FLT_MAX);
+    #endif
+
+    for (PRuint y = 0; y < height; ++y)
+    {
+        const PRfloat* depths = (const PRfloat*)frameBuffer->depths + ((top + y) * frameBuffer->width + left);
+        PRuint x = 0;
+
+        #ifdef _DEPTH_FLOAT_SSE2
+        for (; x + 4 <= width; x += 4)
+            minDepths = _mm_min_ps(minDepths, _mm_loadu_ps(depths + x));
+        #endif
+
+        for (; x < width; ++x)
+        {
+            if (minDepth > depths[x])
+                minDepth = depths[x];
+        }
+    }
+
+    #ifdef _DEPTH_FLOAT_SSE2
+    PRfloat lanes[4];
+    _mm_storeu_ps(lanes, minDepths);
+    for (PRint i = 0; i < 4; ++i)
+    {
+        if (minDepth > lanes[i])
+            minDepth = lanes[i];
+    }
+    #endif
+
+    PRuint bits;
+    memcpy(&bits, &minDepth, sizeof(bits));
+    return bits;
+}
+
+// --- interface --- //
+
+
+pr_framebuffer* _pr_framebuffer_create(PRuint width, PRuint height, PRenum depthFormat)
+{
+    if (width == 0 || height == 0 || (depthFormat != PR_DEPTH_COMPONENT && depthFormat != PR_DEPTH_COMPONENT32F))
     {
         _pr_error_set(PR_ERROR_INVALID_ARGUMENT, __FUNCTION__);
         return NULL;
@@ -28,12 +188,20 @@ pr_framebuffer* _pr_framebuffer_create(PRuint width, PRuint height)
 
     frameBuffer->width = width;
     frameBuffer->height = height;
-    frameBuffer->pixels = PR_CALLOC(pr_pixel, width*height);
-    frameBuffer->scanlinesStart = PR_CALLOC(pr_scaline_side, height);
-    frameBuffer->scanlinesEnd = PR_CALLOC(pr_scaline_side, height);
+    frameBuffer->depthFormat = depthFormat;
+    frameBuffer->colors = PR_CALLOC(PRcolorindex, width*height);
+
+    if (depthFormat == PR_DEPTH_COMPONENT32F)
+        frameBuffer->depths = PR_CALLOC(PRfloat, width*height);
+    else
+        frameBuffer->depths = PR_CALLOC(PRdepthtype, width*height);
 
-    // Initialize framebuffer
-    memset(frameBuffer->pixels, 0, width*height*sizeof(pr_pixel));
+    frameBuffer->numTilesX = (width + PR_TILE_SIZE - 1) / PR_TILE_SIZE;
+    frameBuffer->numTilesY = (height + PR_TILE_SIZE - 1) / PR_TILE_SIZE;
+    frameBuffer->depthTiles = PR_CALLOC(pr_depth_tile, frameBuffer->numTilesX*frameBuffer->numTilesY);
+    frameBuffer->clearTags  = PR_CALLOC(PRubyte, frameBuffer->numTilesX*frameBuffer->numTilesY);
+    frameBuffer->clearColor = _pr_color_to_colorindex(0, 0, 0);
+    frameBuffer->clearDepth = 0;
 
     _pr_ref_add(frameBuffer);
 
@@ -46,50 +214,44 @@ void _pr_framebuffer_delete(pr_framebuffer* frameBuffer)
     {
         _pr_ref_release(frameBuffer);
 
-        PR_FREE(frameBuffer->pixels);
-        PR_FREE(frameBuffer->scanlinesStart);
-        PR_FREE(frameBuffer->scanlinesEnd);
+        PR_FREE(frameBuffer->colors);
+        PR_FREE(frameBuffer->depths);
+        PR_FREE(frameBuffer->depthTiles);
+        PR_FREE(frameBuffer->clearTags);
         PR_FREE(frameBuffer);
     }
 }
 
 void _pr_framebuffer_clear(pr_framebuffer* frameBuffer, PRfloat clearDepth, PRbitfield clearFlags)
 {
-    if (frameBuffer != NULL && frameBuffer->pixels != NULL)
+    if (frameBuffer != NULL && frameBuffer->colors != NULL && frameBuffer->depths != NULL)
     {
-        // Convert depth (32-bit) into pixel depth (16-bit or 8-bit)
-        PRdepthtype depth = _pr_pixel_write_depth(clearDepth);
+        // Convert depth (32-bit) into the bits of the depth format
+        const PRuint depth = _pr_pixel_depth_bits(PR_INTERP_FROM_FLOAT(clearDepth), frameBuffer->depthFormat);
 
-        // Get clear color from state machine (and optionally its color index)
-        PRcolorindex clearColor = PR_STATE_MACHINE.clearColor;
+        const PRuint numTiles = frameBuffer->numTilesX * frameBuffer->numTilesY;
+        const PRubyte tags = (PRubyte)(clearFlags & (PR_COLOR_BUFFER_BIT | PR_DEPTH_BUFFER_BIT));
 
-        // Iterate over the entire framebuffer
-        pr_pixel* dst = frameBuffer->pixels;
-        pr_pixel* dstEnd = dst + (frameBuffer->width * frameBuffer->height);
+        if (tags == 0)
+            return;
 
-        if ((clearFlags & PR_COLOR_BUFFER_BIT) != 0 && (clearFlags & PR_DEPTH_BUFFER_BIT) != 0)
-        {
-            while (dst != dstEnd)
-            {
-                dst->colorIndex = clearColor;
-                dst->depth      = depth;
-                ++dst;
-            }
-        }
-        else if ((clearFlags & PR_COLOR_BUFFER_BIT) != 0)
-        {
-            while (dst != dstEnd)
-            {
-                dst->colorIndex = clearColor;
-                ++dst;
-            }
-        }
-        else if ((clearFlags & PR_DEPTH_BUFFER_BIT) != 0)
+        // Store clear values (a previous pending clear of the same plane is overwritten entirely)
+        if ((clearFlags & PR_COLOR_BUFFER_BIT) != 0)
+            frameBuffer->clearColor = PR_STATE_MACHINE.clearColor;
+        if ((clearFlags & PR_DEPTH_BUFFER_BIT) != 0)
+            frameBuffer->clearDepth = depth;
+
+        // Tag all tiles as cleared, the pixels are filled when a tile is resolved
+        for (PRuint i = 0; i < numTiles; ++i)
+            frameBuffer->clearTags[i] |= tags;
+
+        // Reset HiZ tiles to the clear depth
+        if ((clearFlags & PR_DEPTH_BUFFER_BIT) != 0)
         {
-            while (dst != dstEnd)
+            for (PRuint i = 0; i < numTiles; ++i)
             {
-                dst->depth = depth;
-                ++dst;
+                frameBuffer->depthTiles[i].minDepth = depth;
+                frameBuffer->depthTiles[i].coverage = 0;
             }
         }
     }
@@ -97,18 +259,154 @@ void _pr_framebuffer_clear(pr_framebuffer* frameBuffer, PRfloat clearDepth, PRbi
         _pr_error_set(PR_ERROR_NULL_POINTER, __FUNCTION__);
 }
 
+void _pr_framebuffer_resolve_tile(pr_framebuffer* frameBuffer, PRuint tileIndex)
+{
+    const PRubyte tags = frameBuffer->clearTags[tileIndex];
+
+    if (tags == 0)
+        return;
+
+    const PRuint left   = (tileIndex % frameBuffer->numTilesX) * PR_TILE_SIZE;
+    const PRuint top    = (tileIndex / frameBuffer->numTilesX) * PR_TILE_SIZE;
+    const PRuint width  = PR_MIN(frameBuffer->width - left, (PRuint)PR_TILE_SIZE);
+    const PRuint height = PR_MIN(frameBuffer->height - top, (PRuint)PR_TILE_SIZE);
+
+    for (PRuint y = 0; y < height; ++y)
+    {
+        const PRuint offset = (top + y) * frameBuffer->width + left;
+
+        if ((tags & PR_COLOR_BUFFER_BIT) != 0)
+            _fill_colors(frameBuffer->colors + offset, frameBuffer->clearColor, width);
+        if ((tags & PR_DEPTH_BUFFER_BIT) != 0)
+            _fill_depths(frameBuffer, offset, width);
+    }
+
+    frameBuffer->clearTags[tileIndex] = 0;
+}
+
+void _pr_framebuffer_resolve_rect(pr_framebuffer* frameBuffer, PRint left, PRint top, PRint right, PRint bottom)
+{
+    // Clamp rectangle to the frame buffer
+    PR_CLAMP_LARGEST(left, 0);
+    PR_CLAMP_LARGEST(top, 0);
+    PR_CLAMP_SMALLEST(right, (PRint)frameBuffer->width - 1);
+    PR_CLAMP_SMALLEST(bottom, (PRint)frameBuffer->height - 1);
+
+    if (left > right || top > bottom)
+        return;
+
+    for (PRuint ty = (PRuint)top / PR_TILE_SIZE; ty <= (PRuint)bottom / PR_TILE_SIZE; ++ty)
+    {
+        for (PRuint tx = (PRuint)left / PR_TILE_SIZE; tx <= (PRuint)right / PR_TILE_SIZE; ++tx)
+            _pr_framebuffer_resolve_tile(frameBuffer, ty * frameBuffer->numTilesX + tx);
+    }
+}
+
+void _pr_framebuffer_resolve(pr_framebuffer* frameBuffer)
+{
+    if (frameBuffer != NULL)
+    {
+        for (PRuint i = 0, n = frameBuffer->numTilesX * frameBuffer->numTilesY; i < n; ++i)
+            _pr_framebuffer_resolve_tile(frameBuffer, i);
+    }
+}
+
+void _pr_framebuffer_update_depth_tile(pr_framebuffer* frameBuffer, PRuint tileIndex)
+{
+    const PRuint left   = (tileIndex % frameBuffer->numTilesX) * PR_TILE_SIZE;
+    const PRuint top    = (tileIndex / frameBuffer->numTilesX) * PR_TILE_SIZE;
+    const PRuint width  = PR_MIN(frameBuffer->width - left, (PRuint)PR_TILE_SIZE);
+    const PRuint height = PR_MIN(frameBuffer->height - top, (PRuint)PR_TILE_SIZE);
+
+    if (frameBuffer->depthFormat == PR_DEPTH_COMPONENT32F)
+        frameBuffer->depthTiles[tileIndex].minDepth = _scan_min_depth_float(frameBuffer, left, top, width, height);
+    else
+        frameBuffer->depthTiles[tileIndex].minDepth = _scan_min_depth_fixed(frameBuffer, left, top, width, height);
+
+    frameBuffer->depthTiles[tileIndex].coverage = 0;
+}
+
 void _pr_framebuffer_setup_scanlines(
-    pr_framebuffer* frameBuffer, pr_scaline_side* sides, pr_raster_vertex start, pr_raster_vertex end)
+    pr_framebuffer* frameBuffer, pr_scaline_side* sides, pr_raster_vertex start, pr_raster_vertex end, PRint yMin, PRint yMax)
 {
     PRint pitch = (PRint)frameBuffer->width;
+
+    #ifdef PR_FIXED_POINT
+
+    // Get first and last row whose pixel centers are covered by this edge
     PRint len = end.y - start.y;
+    PRint yFirst = PR_RASTER_CEIL(start.y);
+    PRint yLast = PR_RASTER_FLOOR(end.y);
 
     if (len <= 0)
     {
-        sides[start.y].offset = start.y * pitch + start.x;
+        if (yFirst == yLast && yFirst >= yMin && yFirst <= yMax)
+            sides[yFirst - yMin].offset = yFirst * pitch + PR_RASTER_TO_PIXEL(start.x);
         return;
     }
 
+    // Skip rows outside the specified range
+    PR_CLAMP_LARGEST(yFirst, yMin);
+    PR_CLAMP_SMALLEST(yLast, yMax);
+
+    if (yFirst > yLast)
+        return;
+
+    // Compute X coordinate and attributes at the first row in the 32.32 accumulator format (see PRinterpacc)
+    const PRint xScale = (1 << (PR_INTERP_BITS - PR_SUBPIXEL_BITS));
+    PRint yOffset = PR_RASTER_FROM_PIXEL(yFirst) - start.y;
+    PRint xDelta = (end.x - start.x) * xScale;
+
+    PRinterpacc x = PR_INTERP_ACC_FROM_INTERP(start.x * xScale) + PR_INTERP_ACC_MULDIV(xDelta, yOffset, len);
+    PRinterpacc z = PR_INTERP_ACC_FROM_INTERP(start.z) + PR_INTERP_ACC_MULDIV(end.z - start.z, yOffset, len);
+    PRinterpacc u = PR_INTERP_ACC_FROM_INTERP(start.u) + PR_INTERP_ACC_MULDIV(end.u - start.u, yOffset, len);
+    PRinterpacc v = PR_INTERP_ACC_FROM_INTERP(start.v) + PR_INTERP_ACC_MULDIV(end.v - start.v, yOffset, len);
+
+    // Compute steps per row (only used if the edge covers more than one row, i.e. len >= PR_SUBPIXEL_ONE)
+    PRinterpacc xStep = 0, zStep = 0, uStep = 0, vStep = 0;
+
+    if (yFirst < yLast)
+    {
+        xStep = PR_INTERP_ACC_MULDIV(xDelta, PR_SUBPIXEL_ONE, len);
+        zStep = PR_INTERP_ACC_MULDIV(end.z - start.z, PR_SUBPIXEL_ONE, len);
+        uStep = PR_INTERP_ACC_MULDIV(end.u - start.u, PR_SUBPIXEL_ONE, len);
+        vStep = PR_INTERP_ACC_MULDIV(end.v - start.v, PR_SUBPIXEL_ONE, len);
+    }
+
+    // Fill scanline sides
+    pr_scaline_side* sidesEnd = &(sides[yLast - yMin]);
+    PRint offset = yFirst * pitch;
+
+    for (sides += yFirst - yMin; sides <= sidesEnd; ++sides)
+    {
+        // Setup scanline side
+        sides->offset = offset + ((PR_INTERP_ACC_TO_INTERP(x) + (PR_INTERP_ONE >> 1)) >> PR_INTERP_BITS);
+        sides->z = PR_INTERP_ACC_TO_INTERP(z);
+        sides->u = PR_INTERP_ACC_TO_INTERP(u);
+        sides->v = PR_INTERP_ACC_TO_INTERP(v);
+
+        // Next step
+        offset += pitch;
+        x += xStep;
+        z += zStep;
+        u += uStep;
+        v += vStep;
+    }
+
+    #else
+
+    PRint len = end.y - start.y;
+
+    if (len <= 0)
+    {
+        if (start.y >= yMin && start.y <= yMax)
+            sides[start.y - yMin].offset = start.y * pitch + start.x;
+        return;
+    }
+
+    if (end.y < yMin || start.y > yMax)
+        return;
+
     // Compute offsets (need doubles for offset for better precision, because the range is larger)
     PRdouble offsetStart = (PRdouble)(start.y * pitch + start.x);
     PRdouble offsetEnd   = (PRdouble)(end.y * pitch + end.x);
@@ -118,10 +416,21 @@ void _pr_framebuffer_setup_scanlines(
     PRinterp uStep       = (end.u - start.u) / len;
     PRinterp vStep       = (end.v - start.v) / len;
 
+    // Skip rows above the specified range
+    if (start.y < yMin)
+    {
+        PRint skip = yMin - start.y;
+        offsetStart += offsetStep * skip;
+        start.z += zStep * skip;
+        start.u += uStep * skip;
+        start.v += vStep * skip;
+        start.y = yMin;
+    }
+
     // Fill scanline sides
-    pr_scaline_side* sidesEnd = &(sides[end.y]);
+    pr_scaline_side* sidesEnd = &(sides[PR_MIN(end.y, yMax) - yMin]);
 
-    for (sides += start.y; sides <= sidesEnd; ++sides)
+    for (sides += start.y - yMin; sides <= sidesEnd; ++sides)
     {
         // Setup scanline side
         sides->offset = (PRint)(offsetStart + 0.5);
@@ -135,5 +444,7 @@ void _pr_framebuffer_setup_scanlines(
         start.u += uStep;
         start.v += vStep;
     }
+
+    #endif
 }
 
@@ -24,40 +24,90 @@ typedef struct pr_scaline_side
 }
 pr_scaline_side;
 
-//! Framebuffer structure
+/**
+Hierarchical depth (HiZ) entry of a screen tile (PR_TILE_SIZE x PR_TILE_SIZE pixels).
+Polygons whose nearest depth is less than 'minDepth' can not pass the depth test anywhere in this tile.
+The depths are compared by their bits for all depth formats (see _pr_pixel_depth_bits).
+*/
+typedef struct pr_depth_tile
+{
+    PRuint              minDepth; //!< Conservative minimum (i.e. farthest) depth bits of all pixels in this tile.
+    PRuint              coverage; //!< Number of rasterized pixels since 'minDepth' was last updated.
+}
+pr_depth_tile;
+
+/**
+Framebuffer structure with separate color and depth planes (width * height entries each, row by row).
+Separate planes keep the color indices contiguous for color-only clears and the palette conversion on present,
+and the depths contiguous for the SIMD depth test.
+*/
 typedef struct pr_framebuffer
 {
     PRuint              width;
     PRuint              height;
-    #ifdef PR_MERGE_COLOR_AND_DEPTH_BUFFERS
-    pr_pixel*           pixels;
-    #else
-    PRubyte*            colors;
-    PRdepthtype         depths;
-    #endif
-    pr_scaline_side*    scanlinesStart; //!< Start offsets to scanlines
-    pr_scaline_side*    scanlinesEnd;   //!< End offsets to scanlines
+    PRenum              depthFormat; //!< PR_DEPTH_COMPONENT (PRdepthtype entries) or PR_DEPTH_COMPONENT32F (PRfloat entries).
+    PRcolorindex*       colors;     //!< Color plane.
+    PRvoid*             depths;     //!< Depth plane (see 'depthFormat').
+    PRuint              numTilesX;
+    PRuint              numTilesY;
+    pr_depth_tile*      depthTiles; //!< HiZ tiles (numTilesX * numTilesY), same layout as the tile binner.
+    PRubyte*            clearTags;  //!< Pending clear flags (PR_COLOR_BUFFER_BIT, PR_DEPTH_BUFFER_BIT) of each screen tile.
+    PRcolorindex        clearColor; //!< Color index of the pending color clears.
+    PRuint              clearDepth; //!< Depth bits of the pending depth clears (see _pr_pixel_depth_bits).
 }
 pr_framebuffer;
 
 
-pr_framebuffer* _pr_framebuffer_create(PRuint width, PRuint height);
+pr_framebuffer* _pr_framebuffer_create(PRuint width, PRuint height, PRenum depthFormat);
 void _pr_framebuffer_delete(pr_framebuffer* frameBuffer);
 
+/**
+Clears the specified planes of the frame buffer. This only tags all screen tiles as cleared and resets the HiZ tiles.
+The pixels of a tagged tile are filled once the tile is rasterized or the frame buffer is read (see _pr_framebuffer_resolve).
+*/
 void _pr_framebuffer_clear(pr_framebuffer* frameBuffer, PRfloat clearDepth, PRbitfield clearFlags);
 
-//! Sets the start and end offsets of the specified scanlines.
+/**
+Resolves the pending clears of the specified screen tile, i.e. fills its pixels with the clear values.
+This must be called before the pixels of a tile are accessed. The tile binner calls it once per tile before rasterizing.
+*/
+void _pr_framebuffer_resolve_tile(pr_framebuffer* frameBuffer, PRuint tileIndex);
+
+/**
+Resolves the pending clears of all screen tiles, which overlap the specified rectangle (in pixels, inclusive).
+This must be called before pixels are written outside of the tile binner (e.g. for lines and images).
+*/
+void _pr_framebuffer_resolve_rect(pr_framebuffer* frameBuffer, PRint left, PRint top, PRint right, PRint bottom);
+
+//! Resolves the pending clears of all screen tiles (e.g. before the frame buffer is presented). The frame buffer may be null.
+void _pr_framebuffer_resolve(pr_framebuffer* frameBuffer);
+
+/**
+Recomputes the minimum depth of the specified HiZ tile from its pixels and resets its coverage.
+This is called once the number of rasterized pixels reaches the tile size, so the scan costs at most one read per written pixel.
+*/
+void _pr_framebuffer_update_depth_tile(pr_framebuffer* frameBuffer, PRuint tileIndex);
+
+/**
+Sets the start and end offsets of the specified scanlines.
+\param[out] sides Specifies the scanline sides. Only the rows in the range [yMin, yMax] are written,
+where 'sides[0]' corresponds to the row 'yMin'.
+*/
 void _pr_framebuffer_setup_scanlines(
-    pr_framebuffer* frameBuffer, pr_scaline_side* sides, pr_raster_vertex start, pr_raster_vertex end
+    pr_framebuffer* frameBuffer, pr_scaline_side* sides, pr_raster_vertex start, pr_raster_vertex end, PRint yMin, PRint yMax
 );
 
+//! Returns a pointer to the depth at the specified offset (y * width + x) in the depth plane.
+PR_INLINE PRvoid* _pr_framebuffer_depth_at(pr_framebuffer* frameBuffer, PRuint offset)
+{
+    if (frameBuffer->depthFormat == PR_DEPTH_COMPONENT32F)
+        return (PRfloat*)frameBuffer->depths + offset;
+    return (PRdepthtype*)frameBuffer->depths + offset;
+}
+
 PR_INLINE void _pr_framebuffer_plot(pr_framebuffer* frameBuffer, PRuint x, PRuint y, PRcolorindex colorIndex)
 {
-    #ifdef PR_MERGE_COLOR_AND_DEPTH_BUFFERS
-    frameBuffer->pixels[y * frameBuffer->width + x].colorIndex = colorIndex;
-    #else
     frameBuffer->colors[y * frameBuffer->width + x] = colorIndex;
-    #endif
 }
 
 
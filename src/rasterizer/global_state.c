@@ -9,6 +9,7 @@
 #include "static_config.h"
 #include "error.h"
 #include "render.h"
+#include "texture.h"
 
 
 pr_global_state _globalState;
@@ -19,7 +20,12 @@ pr_global_state _globalState;
 
 void _pr_global_state_init()
 {
-    _pr_texture_singular_init(&(_globalState.singularTexture));
+    // Initialize tile rasterizer
+    _pr_tile_binner_init(&(_globalState.tileBinner));
+    _globalState.threadPool = _pr_thread_pool_create(_pr_thread_hardware_concurrency());
+
+    _pr_vertex_cache_invalidate(&(_globalState.vertexCache));
+    _pr_vertex_stream_init(&(_globalState.vertexStream));
 
     // Initialize immediate mode
     _pr_vertexbuffer_singular_init(&(_globalState.immModeVertexBuffer), PR_NUM_IMMEDIATE_VERTICES);
@@ -30,8 +36,12 @@ void _pr_global_state_init()
 
 void _pr_global_state_release()
 {
-    _pr_texture_singular_clear(&(_globalState.singularTexture));
+    _pr_tile_binner_clear(&(_globalState.tileBinner));
+    _pr_thread_pool_delete(_globalState.threadPool);
+    _globalState.threadPool = NULL;
+    _pr_vertex_stream_clear(&(_globalState.vertexStream));
     _pr_vertexbuffer_singular_clear(&(_globalState.immModeVertexBuffer));
+    _pr_texture_release_scratch();
 }
 
 static void _immediate_mode_flush()
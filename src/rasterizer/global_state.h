@@ -11,10 +11,16 @@
 
 #include "texture.h"
 #include "vertexbuffer.h"
+#include "tile_binner.h"
+#include "vertex_cache.h"
+#include "thread_pool.h"
 
 
-#define PR_SINGULAR_TEXTURE         _globalState.singularTexture
 #define PR_SINGULAR_VERTEXBUFFER    _globalState.singularVertexBuffer
+#define PR_TILE_BINNER              _globalState.tileBinner
+#define PR_THREAD_POOL              _globalState.threadPool
+#define PR_VERTEX_CACHE             _globalState.vertexCache
+#define PR_VERTEX_STREAM            _globalState.vertexStream
 
 // Number of vertices for the vertex buffer of the immediate draw mode (prBegin/prEnd)
 #define PR_NUM_IMMEDIATE_VERTICES   32
@@ -22,7 +28,13 @@
 
 typedef struct pr_global_state
 {
-    pr_texture      singularTexture;        // Texture with single color
+    // Tile rasterizer
+    pr_tile_binner  tileBinner;
+    pr_thread_pool* threadPool;
+
+    // Post-transform vertex cache for indexed draw calls and output of the batch transform stage
+    pr_vertex_cache  vertexCache;
+    pr_vertex_stream vertexStream;
 
     // Immediate mode
     pr_vertexbuffer immModeVertexBuffer;
@@ -10,6 +10,15 @@
 #include "helper.h"
 #include "static_config.h"
 #include "color_palette.h"
+#include "enums.h"
+
+#include <string.h>
+
+// SIMD ordered dithering (see _dither_ordered)
+#if !defined(PR_COLOR_BUFFER_24BIT) && defined(PR_SIMD_SSE2)
+#   include <emmintrin.h>
+#   define _IMAGE_SSE2
+#endif
 
 #ifdef PR_INCLUDE_PLUGINS
 #   define STB_IMAGE_IMPLEMENTATION
@@ -108,43 +117,171 @@ void _pr_image_delete(pr_image* image)
 }
 
 
-#define PIXEL(x, y) imageBuffer[(y)*imageWidth+(x)]
-#define DITHER(c, s)
+#ifndef PR_COLOR_BUFFER_24BIT
 
 /*
-This function implements the "Floyd-Steinberg" dithering algorithm.
+Quantizes one color component for the "Floyd-Steinberg" dithering algorithm and returns its palette level.
+'cur' and 'next' point to the errors of this component in the current and next row.
+The errors of neighboring pixels are 3 entries apart (see _dither_floyd_steinberg).
 The distribution pattern around the pixel 'px' is:
        [ px ] [7/16]
 [3/16] [5/16] [1/16]
 */
-static void _dither_color(PRint* buffer, PRint x, PRint y, PRint comp, PRint width, PRint height, PRint scale)
+PR_INLINE PRint _dither_error_diffusion(PRint color, PRint scale, PRint maxLevel, PRint* cur, PRint* next)
 {
-    #define COLOR(x, y) buffer[((y)*width + (x))*3 + comp]
-
-    // Get old and new color
-    int oldPixel = COLOR(x, y);
-    int newPixel = (oldPixel/scale)*scale;
-    
-    // Write final color
-    COLOR(x, y) = newPixel;
-    
-    // Get quantification error
-    int quantErr = oldPixel - newPixel;
+    // Get new color level and quantification error
+    const PRint level = color / scale;
+    const PRint quantErr = color - level*scale;
 
     // Apply dithering distribution
-    if (x + 1 < width)
-        COLOR(x + 1, y    ) += quantErr*7/16;
-    if (x > 0 && y + 1 < height)
-        COLOR(x - 1, y + 1) += quantErr*3/16;
-    if (y + 1 < height)
-        COLOR(x    , y + 1) += quantErr*5/16;
-    if (x + 1 < width && y + 1 < height)
-        COLOR(x + 1, y + 1) += quantErr*1/16;
-
-    #undef COLOR
+    cur [ 3] += quantErr*7/16;
+    next[-3] += quantErr*3/16;
+    next[ 0] += quantErr*5/16;
+    next[ 3] += quantErr*1/16;
+
+    // Accumulated errors can push bright colors beyond the last level
+    return (level < maxLevel ? level : maxLevel);
+}
+
+/*
+Converts the image with "Floyd-Steinberg" dithering.
+Only two rows of errors are kept: the row which is converted and the row below.
+Both rows have one more pixel at each side, so errors never have to be bounds checked.
+'errors' must have room for both rows (see _pr_image_scratch_size).
+*/
+static void _dither_floyd_steinberg(PRcolorindex* dst, const PRubyte* src, PRint width, PRint height, PRint format, PRint* errors)
+{
+    const PRint rowSize = (width + 2)*3;
+
+    // The first row starts without errors
+    memset(errors, 0, sizeof(PRint)*rowSize);
+
+    // Components of gray scale images are all read from the same byte
+    const PRint srcG = (format < 3 ? 0 : 1);
+    const PRint srcB = (format < 3 ? 0 : 2);
+
+    for (PRint y = 0; y < height; ++y)
+    {
+        PRint* cur = errors + (y & 1)*rowSize + 3;
+        PRint* next = errors + ((y + 1) & 1)*rowSize + 3;
+
+        // The next row collects the errors of this row only
+        memset(next - 3, 0, sizeof(PRint)*rowSize);
+
+        for (PRint x = 0; x < width; ++x, src += format, cur += 3, next += 3)
+        {
+            const PRint r = _dither_error_diffusion((PRint)src[0   ] + cur[0], PR_COLORINDEX_SCALE_RED,   7, cur,     next    );
+            const PRint g = _dither_error_diffusion((PRint)src[srcG] + cur[1], PR_COLORINDEX_SCALE_GREEN, 7, cur + 1, next + 1);
+            const PRint b = _dither_error_diffusion((PRint)src[srcB] + cur[2], PR_COLORINDEX_SCALE_BLUE,  3, cur + 2, next + 2);
+
+            *dst++ = (PRcolorindex)((r << 5) | (g << 2) | b);
+        }
+    }
+}
+
+//! 8x8 Bayer matrix with the thresholds 0 to 63.
+static const PRubyte _bayerMatrix[8][8] =
+{
+    {  0, 32,  8, 40,  2, 34, 10, 42 },
+    { 48, 16, 56, 24, 50, 18, 58, 26 },
+    { 12, 44,  4, 36, 14, 46,  6, 38 },
+    { 60, 28, 52, 20, 62, 30, 54, 22 },
+    {  3, 35, 11, 43,  1, 33,  9, 41 },
+    { 51, 19, 59, 27, 49, 17, 57, 25 },
+    { 15, 47,  7, 39, 13, 45,  5, 37 },
+    { 63, 31, 55, 23, 61, 29, 53, 21 },
+};
+
+/*
+Converts the image with ordered dithering (8x8 Bayer matrix).
+Each component 'c' with 'n' palette levels is scaled and biased by the pixel's threshold 't', i.e. c' = c*(n-1)/255 + t/64,
+so that the regular color index selection (which truncates c') results in the dithered level.
+Every pixel is independent of the others, so each row is transformed with SIMD and then converted with _pr_color_to_colorindex_array.
+The pattern of scales and biases repeats every 48 bytes (16 RGB pixels), which is a multiple of the SIMD width.
+'row' must have room for one RGB row (see _pr_image_scratch_size).
+*/
+static void _dither_ordered(PRcolorindex* dst, const PRubyte* src, PRint width, PRint height, PRint format, PRubyte* row)
+{
+    const PRint rowSize = width*3;
+
+    // 8.8 fixed-point scales: (n-1)*32/255 for red and green (8 levels), (n-1)*64/255 for blue (4 levels)
+    PRushort scales[48], biases[48];
+
+    for (PRint i = 0; i < 48; ++i)
+        scales[i] = (i % 3 == 2 ? 193 : 225);
+
+    for (PRint y = 0; y < height; ++y, src += width*format, dst += width)
+    {
+        // Thresholds of this row, scaled to the selection steps (32 for red and green, 64 for blue) in 8.8 fixed-point
+        for (PRint i = 0; i < 48; ++i)
+        {
+            const PRushort threshold = _bayerMatrix[y & 7][(i/3) & 7];
+            biases[i] = (i % 3 == 2 ? threshold*256 : threshold*128);
+        }
+
+        // Gray scale images are expanded into RGB first
+        const PRubyte* rgb = src;
+
+        if (format != 3)
+        {
+            for (PRint x = 0, j = 0; x < width; ++x, j += format)
+            {
+                row[x*3    ] = src[j];
+                row[x*3 + 1] = src[j + (format == 4 ? 1 : 0)];
+                row[x*3 + 2] = src[j + (format == 4 ? 2 : 0)];
+            }
+            rgb = row;
+        }
+
+        PRint i = 0;
+
+        #ifdef _IMAGE_SSE2
+
+        const __m128i zero = _mm_setzero_si128();
+
+        for (; i + 48 <= rowSize; i += 48)
+        {
+            for (PRint k = 0; k < 48; k += 16)
+            {
+                const __m128i colors = _mm_loadu_si128((const __m128i*)(rgb + i + k));
+                const __m128i lo = _mm_add_epi16(
+                    _mm_mullo_epi16(_mm_unpacklo_epi8(colors, zero), _mm_loadu_si128((const __m128i*)(scales + k))),
+                    _mm_loadu_si128((const __m128i*)(biases + k))
+                );
+                const __m128i hi = _mm_add_epi16(
+                    _mm_mullo_epi16(_mm_unpackhi_epi8(colors, zero), _mm_loadu_si128((const __m128i*)(scales + k + 8))),
+                    _mm_loadu_si128((const __m128i*)(biases + k + 8))
+                );
+                _mm_storeu_si128((__m128i*)(row + i + k), _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+            }
+        }
+
+        #endif
+
+        for (; i < rowSize; ++i)
+            row[i] = (PRubyte)(((PRuint)rgb[i]*scales[i % 48] + biases[i % 48]) >> 8);
+
+        _pr_color_to_colorindex_array(dst, row, width, 3);
+    }
 }
 
-void _pr_image_color_to_colorindex(PRcolorindex* dstColors, const pr_image* srcImage, PRboolean dither)
+#endif
+
+size_t _pr_image_scratch_size(PRint width, PRenum dither)
+{
+    #ifndef PR_COLOR_BUFFER_24BIT
+    switch (dither)
+    {
+        case PR_DITHER_FLOYD_STEINBERG:
+            return sizeof(PRint)*(width + 2)*3*2;
+        case PR_DITHER_ORDERED:
+            return (size_t)width*3;
+    }
+    #endif
+    return 0;
+}
+
+void _pr_image_color_to_colorindex(PRcolorindex* dstColors, const pr_image* srcImage, PRenum dither, PRvoid* scratch)
 {
     // Validate and map input parameters
     if (dstColors == NULL || srcImage == NULL)
@@ -165,73 +302,45 @@ void _pr_image_color_to_colorindex(PRcolorindex* dstColors, const pr_image* srcI
 
     const PRubyte* src = srcImage->colors;
 
-    const PRuint numPixels = width*height;
+    // Allocate the dithering rows only if the caller has no scratch memory for them
+    PRvoid* rows = scratch;
+    const size_t scratchSize = _pr_image_scratch_size(width, dither);
+
+    if (rows == NULL && scratchSize > 0)
+        rows = PR_CALLOC(PRubyte, scratchSize);
 
-    if (dither != PR_FALSE)
+    switch (dither)
     {
-        // Fill temporary integer buffer
-        const PRuint numColors = width*height*3;
-        PRint* buffer = PR_CALLOC(PRint, numColors);
+        case PR_DITHER_NONE:
+            _pr_color_to_colorindex_array(dstColors, src, (PRuint)(width*height), format);
+            break;
 
-        if (format < 3)
-        {
-            // Copy gray scale image into buffer
-            for (PRuint i = 0, j = 0; i < numColors; i += 3, j += format)
-            {
-                buffer[i    ] = src[j];
-                buffer[i + 1] = src[j];
-                buffer[i + 2] = src[j];
-            }
-        }
-        else
-        {
-            // Copy RGB image into buffer
-            for (PRuint i = 0, j = 0; i < numColors; i += 3, j += format)
-            {
-                buffer[i    ] = (PRint)src[j    ];
-                buffer[i + 1] = (PRint)src[j + 1];
-                buffer[i + 2] = (PRint)src[j + 2];
-            }
-        }
+        #ifdef PR_COLOR_BUFFER_24BIT
 
-        // Apply dithering to buffer
-        for (PRint y = 0; y < height; ++y)
-        {
-            for (PRint x = 0; x < width; ++x)
-            {
-                _dither_color(buffer, x, y, 0, width, height, PR_COLORINDEX_SCALE_RED  );
-                _dither_color(buffer, x, y, 1, width, height, PR_COLORINDEX_SCALE_GREEN);
-                _dither_color(buffer, x, y, 2, width, height, PR_COLORINDEX_SCALE_BLUE );
-            }
-        }
+        // 24-bit colors are stored without quantization, so there is nothing to dither
+        case PR_DITHER_FLOYD_STEINBERG:
+        case PR_DITHER_ORDERED:
+            _pr_color_to_colorindex_array(dstColors, src, (PRuint)(width*height), format);
+            break;
 
-        // Finally convert buffer to color index
-        for (PRuint i = 0, j = 0; i < numPixels; ++i, j += 3)
-            dstColors[i] = _pr_color_to_colorindex(buffer[j], buffer[j + 1], buffer[j + 2]);
+        #else
 
-        // Delete temporary buffer
-        PR_FREE(buffer);
-    }
-    else
-    {
-        // Copy image data
-        if (format < 3)
-        {
-            // Copy gray scale image into color index
-            PRubyte gray;
+        case PR_DITHER_FLOYD_STEINBERG:
+            _dither_floyd_steinberg(dstColors, src, width, height, format, (PRint*)rows);
+            break;
 
-            for (PRuint i = 0, j = 0; i < numPixels; ++i, j += format)
-            {
-                gray = src[j];
-                dstColors[i] = _pr_color_to_colorindex(gray, gray, gray);
-            }
-        }
-        else
-        {
-            // Copy RGB image into color index
-            for (PRuint i = 0, j = 0; i < numPixels; ++i, j += format)
-                dstColors[i] = _pr_color_to_colorindex(src[j], src[j + 1], src[j + 2]);
-        }
+        case PR_DITHER_ORDERED:
+            _dither_ordered(dstColors, src, width, height, format, (PRubyte*)rows);
+            break;
+
+        #endif
+
+        default:
+            _pr_error_set(PR_ERROR_INVALID_ARGUMENT, __FUNCTION__);
+            break;
     }
+
+    if (rows != scratch)
+        PR_FREE(rows);
 }
 
@@ -45,9 +45,15 @@ This must already be allocated with the specified size: width*height*sizeof(PRub
 \param[in] width Specifies the image width.
 \param[in] height Specifies the image height.
 \param[in] format Specifies the source color format. Must be 1, 2, 3 or 4.
-\param[in] dither Specifies whether the image is to be converted with or without dithering.
+\param[in] dither Specifies the dithering mode: PR_DITHER_NONE, PR_DITHER_FLOYD_STEINBERG or PR_DITHER_ORDERED.
+With Floyd-Steinberg dithering, only two rows of errors are needed. Ordered dithering converts 16 pixels per iteration with SSE2.
+\param[in] scratch Optional scratch memory for the dithering rows with at least '_pr_image_scratch_size' bytes.
+If this is null, the rows are allocated temporarily.
 */
-void _pr_image_color_to_colorindex(PRcolorindex* dstColors, const pr_image* srcImage, PRboolean dither);
+void _pr_image_color_to_colorindex(PRcolorindex* dstColors, const pr_image* srcImage, PRenum dither, PRvoid* scratch);
+
+//! Returns the size (in bytes) of the scratch memory which '_pr_image_color_to_colorindex' needs for the specified image width and dithering.
+size_t _pr_image_scratch_size(PRint width, PRenum dither);
 
 
 #endif
@@ -12,8 +12,11 @@
 #include "types.h"
 #include "static_config.h"
 #include "color.h"
+#include "fixed_point.h"
+#include "enums.h"
 
 #include <limits.h>
+#include <string.h>
 
 
 #ifdef PR_DEPTH_BUFFER_8BIT
@@ -24,14 +27,6 @@ typedef PRubyte PRdepthtype;
 typedef PRushort PRdepthtype;
 #endif
 
-//! Frame buffer pixel structure.
-typedef struct pr_pixel
-{
-    PRcolorindex    colorIndex; //!< Colors are stored as 8-bit unsigned integer.
-    PRdepthtype     depth;      //!< Depth values are stored as 16-bit unsigned integer.
-}
-pr_pixel;
-
 
 /**
 Writes the specified real depth value to a pixel depth.
@@ -39,13 +34,38 @@ Writes the specified real depth value to a pixel depth.
 */
 PR_INLINE PRdepthtype _pr_pixel_write_depth(PRinterp z)
 {
+    #ifdef PR_FIXED_POINT
+    return (PRdepthtype)(((PRuint)z * PR_DEPTH_MAX) >> PR_INTERP_BITS);
+    #else
     return (PRdepthtype)(z * (PRinterp)PR_DEPTH_MAX);
+    #endif
 }
 
 //! Reads the specified pixel depth to a real depth value.
 PR_INLINE PRinterp _pr_pixel_read_depth(PRdepthtype z)
 {
+    #ifdef PR_FIXED_POINT
+    return (PRinterp)(((PRuint)z << PR_INTERP_BITS) / PR_DEPTH_MAX);
+    #else
     return ((PRinterp)z) / ((PRdepthtype)PR_DEPTH_MAX);
+    #endif
+}
+
+/**
+Returns the bits of the specified real depth as they are stored in a depth plane of the specified format
+(PR_DEPTH_COMPONENT or PR_DEPTH_COMPONENT32F). Depths are never negative, so for both formats
+the bits (as unsigned integer) have the same order as the depths, which is used for the HiZ tiles and clear values.
+*/
+PR_INLINE PRuint _pr_pixel_depth_bits(PRinterp z, PRenum depthFormat)
+{
+    if (depthFormat == PR_DEPTH_COMPONENT32F)
+    {
+        PRfloat depth = PR_INTERP_TO_FLOAT(z);
+        PRuint bits;
+        memcpy(&bits, &depth, sizeof(bits));
+        return bits;
+    }
+    return (PRuint)_pr_pixel_write_depth(z);
 }
 
 
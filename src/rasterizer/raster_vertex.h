@@ -27,8 +27,8 @@ pr_clip_vertex;
 //! Raster vertex structure after projection
 typedef struct pr_raster_vertex
 {
-    PRint       x; //!< Screen coordinate X.
-    PRint       y; //!< Screen coordinate Y.
+    PRint       x; //!< Screen coordinate X (in 28.4 fixed-point format if PR_FIXED_POINT is defined).
+    PRint       y; //!< Screen coordinate Y (in 28.4 fixed-point format if PR_FIXED_POINT is defined).
     PRinterp    z; //!< Normalized device coordinate Z.
     PRinterp    u; //!< Inverse texture coordinate U.
     PRinterp    v; //!< Inverse texture coordinate V.
@@ -0,0 +1,510 @@
+/*
+ * rasterizer.c
+ *
+ * This file is part of the "PicoRenderer" (Copyright (c) 2014 by Lukas Hermanns)
+ * See "LICENSE.txt" for license information.
+ */
+
+#include "rasterizer.h"
+#include "span.h"
+#include "ext_math.h"
+
+
+// --- internals --- //
+
+static void _index_inc(PRint* x, PRint numVertices)
+{
+    ++(*x);
+    if (*x >= numVertices)
+        *x = 0;
+}
+
+static void _index_dec(PRint* x, PRint numVertices)
+{
+    --(*x);
+    if (*x < 0)
+        *x = numVertices - 1;
+}
+
+static void _setup_edge_function(pr_edge_function* edge, const pr_raster_vertex* a, const pr_raster_vertex* b, PRboolean swapSides)
+{
+    edge->a = a->y - b->y;
+    edge->b = b->x - a->x;
+
+    // Flip edge function for counter-clockwise polygons, so that the inside is always positive
+    if (swapSides)
+    {
+        edge->a = -edge->a;
+        edge->b = -edge->b;
+    }
+
+    edge->c = -(edge->a * a->x + edge->b * a->y);
+
+    // Apply top-left fill rule: exclude pixels on bottom and right edges
+    if (!(edge->a > 0 || (edge->a == 0 && edge->b > 0)))
+        --edge->c;
+
+    // Scale steps from sub-pixels to pixels
+    edge->a *= PR_SUBPIXEL_ONE;
+    edge->b *= PR_SUBPIXEL_ONE;
+}
+
+static void _setup_attrib_plane(
+    pr_attrib_plane* plane, const pr_raster_vertex* v0, const pr_raster_vertex* v1, const pr_raster_vertex* v2,
+    PRinterp f0, PRinterp f1, PRinterp f2, PRinterpreal invArea)
+{
+    const PRinterpreal dx1 = (PRinterpreal)(v1->x - v0->x) / PR_SUBPIXEL_ONE, dy1 = (PRinterpreal)(v1->y - v0->y) / PR_SUBPIXEL_ONE;
+    const PRinterpreal dx2 = (PRinterpreal)(v2->x - v0->x) / PR_SUBPIXEL_ONE, dy2 = (PRinterpreal)(v2->y - v0->y) / PR_SUBPIXEL_ONE;
+    const PRinterpreal df1 = PR_INTERP_TO_REAL(f1 - f0);
+    const PRinterpreal df2 = PR_INTERP_TO_REAL(f2 - f0);
+
+    plane->dx = (df1*dy2 - df2*dy1) * invArea;
+    plane->dy = (df2*dx1 - df1*dx2) * invArea;
+    plane->f0 = PR_INTERP_TO_REAL(f0)
+        - plane->dx * ((PRinterpreal)v0->x / PR_SUBPIXEL_ONE)
+        - plane->dy * ((PRinterpreal)v0->y / PR_SUBPIXEL_ONE);
+}
+
+/*
+Returns the end (exclusive) of the screen tile in x direction. The tile rectangle may be clamped to the clipping rectangle,
+but the pixels up to this end still belong to the same tile bin, which is rasterized by a single thread (see pr_span::slack).
+*/
+static PRint _tile_row_end(const pr_framebuffer* frameBuffer, const pr_raster_tile* tile)
+{
+    return PR_MIN((tile->rect.left / PR_TILE_SIZE + 1) * PR_TILE_SIZE, (PRint)frameBuffer->width);
+}
+
+/*
+Selects the MIP level for a span by the screen space derivatives of the texture coordinates at the specified pixel.
+The spans are at most PR_TILE_SIZE pixels long, so one level per span keeps the texel fetches close to one texel per pixel.
+*/
+static const PRcolorindex* _select_span_miplevel(
+    const pr_raster_polygon* polygon, PRint x, PRint y, PRtexsize* mipWidth, PRtexsize* mipHeight)
+{
+    const pr_attrib_plane* uPlane = &(polygon->uPlane);
+    const pr_attrib_plane* vPlane = &(polygon->vPlane);
+
+    #ifdef PR_PERSPECTIVE_CORRECTED
+    // The planes interpolate u*z, v*z and z linearly, so derive u and v with the quotient rule
+    const pr_attrib_plane* zPlane = &(polygon->zPlane);
+    const PRfloat zInv = 1.0f / (PRfloat)(zPlane->f0 + zPlane->dx * x + zPlane->dy * y);
+    const PRfloat u = (PRfloat)(uPlane->f0 + uPlane->dx * x + uPlane->dy * y) * zInv;
+    const PRfloat v = (PRfloat)(vPlane->f0 + vPlane->dx * x + vPlane->dy * y) * zInv;
+
+    const PRubyte mip = _pr_texture_compute_miplevel(
+        polygon->texture,
+        ((PRfloat)uPlane->dx - u * (PRfloat)zPlane->dx) * zInv, ((PRfloat)vPlane->dx - v * (PRfloat)zPlane->dx) * zInv,
+        ((PRfloat)uPlane->dy - u * (PRfloat)zPlane->dy) * zInv, ((PRfloat)vPlane->dy - v * (PRfloat)zPlane->dy) * zInv
+    );
+    #else
+    const PRubyte mip = _pr_texture_compute_miplevel(
+        polygon->texture, (PRfloat)uPlane->dx, (PRfloat)vPlane->dx, (PRfloat)uPlane->dy, (PRfloat)vPlane->dy
+    );
+    #endif
+
+    return _pr_texture_select_miplevel(polygon->texture, mip, mipWidth, mipHeight);
+}
+
+// --- interface --- //
+
+PRboolean _pr_raster_polygon_setup(pr_raster_polygon* polygon, const pr_raster_vertex* vertices, PRenum depthFormat)
+{
+    const PRint numVertices = polygon->numVertices;
+
+    // Find top and bottom vertices, the bounding rectangle and the nearest depth
+    PRint top = 0, bottom = 0;
+    PRinterp zMax = vertices[0].z;
+    PRareatype area = 0;
+    pr_rect bounds;
+
+    bounds.left     = vertices[0].x;
+    bounds.top      = vertices[0].y;
+    bounds.right    = vertices[0].x;
+    bounds.bottom   = vertices[0].y;
+
+    for (PRint i = 0, j = numVertices - 1; i < numVertices; j = i, ++i)
+    {
+        if (vertices[top].y > vertices[i].y)
+            top = i;
+        if (vertices[bottom].y < vertices[i].y)
+            bottom = i;
+
+        PR_CLAMP_SMALLEST(bounds.left, vertices[i].x);
+        PR_CLAMP_SMALLEST(bounds.top, vertices[i].y);
+        PR_CLAMP_LARGEST(bounds.right, vertices[i].x);
+        PR_CLAMP_LARGEST(bounds.bottom, vertices[i].y);
+        PR_CLAMP_LARGEST(zMax, vertices[i].z);
+
+        // Accumulate signed area (twice the size) to determine the vertex order
+        area += (PRareatype)vertices[j].x * vertices[i].y - (PRareatype)vertices[i].x * vertices[j].y;
+    }
+
+    // Convert bounding rectangle to pixels
+    polygon->bounds.left    = PR_RASTER_TO_PIXEL(bounds.left);
+    polygon->bounds.top     = PR_RASTER_TO_PIXEL(bounds.top);
+    polygon->bounds.right   = PR_RASTER_TO_PIXEL(bounds.right);
+    polygon->bounds.bottom  = PR_RASTER_TO_PIXEL(bounds.bottom);
+    polygon->depthMax       = _pr_pixel_depth_bits(zMax, depthFormat);
+
+    // Interpolated float depths may exceed the vertex depths by a few ULPs, which must not be culled by the HiZ test
+    if (depthFormat == PR_DEPTH_COMPONENT32F)
+        polygon->depthMax += 16;
+
+    if (area == 0)
+        return PR_FALSE;
+
+    polygon->top        = top;
+    polygon->bottom     = bottom;
+    polygon->swapSides  = (area < 0 ? PR_TRUE : PR_FALSE);
+
+    return PR_TRUE;
+}
+
+PRboolean _pr_raster_polygon_setup_halfspace(pr_raster_polygon* polygon, const pr_raster_vertex* vertices, pr_edge_function* edges)
+{
+    const PRint numVertices = polygon->numVertices;
+
+    // Setup edge functions (clipping may produce duplicate vertices, whose edges are skipped)
+    PRint numEdges = 0;
+
+    for (PRint i = 0, j = numVertices - 1; i < numVertices; j = i, ++i)
+    {
+        if (vertices[j].x != vertices[i].x || vertices[j].y != vertices[i].y)
+            _setup_edge_function(&(edges[numEdges++]), &(vertices[j]), &(vertices[i]), polygon->swapSides);
+    }
+
+    polygon->numEdges = numEdges;
+
+    return _pr_raster_polygon_setup_planes(polygon, vertices);
+}
+
+PRboolean _pr_raster_polygon_setup_planes(pr_raster_polygon* polygon, const pr_raster_vertex* vertices)
+{
+    const PRint numVertices = polygon->numVertices;
+
+    // Setup attribute planes from the largest triangle of the polygon's triangle fan
+    PRint k = 1;
+    PRareatype area = 0;
+
+    for (PRint i = 1; i + 1 < numVertices; ++i)
+    {
+        PRareatype a = (PRareatype)(vertices[i].x - vertices[0].x) * (vertices[i + 1].y - vertices[0].y)
+                     - (PRareatype)(vertices[i + 1].x - vertices[0].x) * (vertices[i].y - vertices[0].y);
+        if (PR_ABS(a) > PR_ABS(area))
+        {
+            area = a;
+            k = i;
+        }
+    }
+
+    if (area == 0)
+        return PR_FALSE;
+
+    const pr_raster_vertex* v0 = &(vertices[0]);
+    const pr_raster_vertex* v1 = &(vertices[k]);
+    const pr_raster_vertex* v2 = &(vertices[k + 1]);
+    const PRinterpreal invArea = (PRinterpreal)(PR_SUBPIXEL_ONE * PR_SUBPIXEL_ONE) / (PRinterpreal)area;
+
+    _setup_attrib_plane(&(polygon->zPlane), v0, v1, v2, v0->z, v1->z, v2->z, invArea);
+    _setup_attrib_plane(&(polygon->uPlane), v0, v1, v2, v0->u, v1->u, v2->u, invArea);
+    _setup_attrib_plane(&(polygon->vPlane), v0, v1, v2, v0->v, v1->v, v2->v, invArea);
+
+    return PR_TRUE;
+}
+
+PRuint _pr_rasterize_polygon_fill(
+    pr_framebuffer* frameBuffer, pr_raster_tile* tile, const pr_raster_state* state,
+    const pr_raster_polygon* polygon, const pr_raster_vertex* vertices)
+{
+    // Select MIP level (untextured polygons are rasterized with the flat color, see _select_span_miplevel for MIP-mapping)
+    PRtexsize mipWidth = 0, mipHeight = 0;
+    const PRcolorindex* texels = NULL;
+    if (polygon->texture != NULL && !state->mipMapping)
+        texels = _pr_texture_select_miplevel(polygon->texture, polygon->mipLevel, &mipWidth, &mipHeight);
+
+    const PRint numVertices = polygon->numVertices;
+    const PRint top = polygon->top;
+    const PRint bottom = polygon->bottom;
+
+    // Clamp vertical range to the tile
+    const PRint tileTop = tile->rect.top;
+    const PRint yStart = PR_MAX(PR_RASTER_CEIL(vertices[top].y), tileTop);
+    const PRint yEnd = PR_MIN(PR_RASTER_FLOOR(vertices[bottom].y), tile->rect.bottom);
+
+    if (yStart > yEnd)
+        return 0;
+
+    // Setup raster scanline sides
+    pr_scaline_side* leftSide = tile->sidesStart;
+    pr_scaline_side* rightSide = tile->sidesEnd;
+
+    PRint x, y;
+
+    x = y = top;
+    for (_index_dec(&y, numVertices); x != bottom; x = y, _index_dec(&y, numVertices))
+        _pr_framebuffer_setup_scanlines(frameBuffer, leftSide, vertices[x], vertices[y], yStart, yEnd);
+
+    x = y = top;
+    for (_index_inc(&y, numVertices); x != bottom; x = y, _index_inc(&y, numVertices))
+        _pr_framebuffer_setup_scanlines(frameBuffer, rightSide, vertices[x], vertices[y], yStart, yEnd);
+
+    // Check if sides must be swaped
+    if (polygon->swapSides)
+        PR_SWAP(pr_scaline_side*, leftSide, rightSide);
+
+    // Start rasterizing the polygon
+    const PRint pitch = (PRint)frameBuffer->width;
+    const PRint tileLeft = tile->rect.left;
+    const PRint tileRight = tile->rect.right;
+    const PRint tileEnd = _tile_row_end(frameBuffer, tile);
+
+    PRint len, offset, left, right;
+    PRuint coverage = 0;
+
+    pr_span span;
+    span.subspanLength  = state->subspanLength;
+    span.color          = state->color;
+
+    // Rasterize each scanline
+    for (y = yStart; y <= yEnd; ++y)
+    {
+        const pr_scaline_side* leftRow = &(leftSide[y - yStart]);
+        const pr_scaline_side* rightRow = &(rightSide[y - yStart]);
+
+        len = rightRow->offset - leftRow->offset;
+        if (len <= 0)
+            continue;
+
+        // Clamp horizontal range to the tile
+        left = leftRow->offset - y * pitch;
+        right = left + len;
+
+        PR_CLAMP_LARGEST(left, tileLeft);
+        PR_CLAMP_SMALLEST(right, tileRight);
+
+        if (left > right)
+            continue;
+
+        span.zStep = PR_INTERP_ACC_MULDIV(rightRow->z - leftRow->z, 1, len);
+        span.uStep = PR_INTERP_ACC_MULDIV(rightRow->u - leftRow->u, 1, len);
+        span.vStep = PR_INTERP_ACC_MULDIV(rightRow->v - leftRow->v, 1, len);
+
+        offset = leftRow->offset;
+        span.z = PR_INTERP_ACC_FROM_INTERP(leftRow->z);
+        span.u = PR_INTERP_ACC_FROM_INTERP(leftRow->u);
+        span.v = PR_INTERP_ACC_FROM_INTERP(leftRow->v);
+
+        if (offset < y * pitch + left)
+        {
+            PRint skip = y * pitch + left - offset;
+            offset += skip;
+            span.z += PR_INTERP_ACC_MULDIV(rightRow->z - leftRow->z, skip, len);
+            span.u += PR_INTERP_ACC_MULDIV(rightRow->u - leftRow->u, skip, len);
+            span.v += PR_INTERP_ACC_MULDIV(rightRow->v - leftRow->v, skip, len);
+        }
+
+        // Rasterize current scanline
+        span.colors = &(frameBuffer->colors[offset]);
+        span.depths = _pr_framebuffer_depth_at(frameBuffer, (PRuint)offset);
+        span.length = right - left + 1;
+        span.slack = tileEnd - right - 1;
+        coverage += (PRuint)span.length;
+
+        if (state->mipMapping)
+            texels = _select_span_miplevel(polygon, (left + right) / 2, y, &mipWidth, &mipHeight);
+
+        state->spanKernel(&span, texels, mipWidth, mipHeight);
+    }
+
+    return coverage;
+}
+
+PRuint _pr_rasterize_polygon_halfspace(
+    pr_framebuffer* frameBuffer, pr_raster_tile* tile, const pr_raster_state* state,
+    const pr_raster_polygon* polygon, const pr_edge_function* edges)
+{
+    // Clamp bounding rectangle to the tile
+    const PRint xMin = PR_MAX(polygon->bounds.left, tile->rect.left);
+    const PRint yMin = PR_MAX(polygon->bounds.top, tile->rect.top);
+    const PRint xMax = PR_MIN(polygon->bounds.right, tile->rect.right);
+    const PRint yMax = PR_MIN(polygon->bounds.bottom, tile->rect.bottom);
+
+    if (xMin > xMax || yMin > yMax)
+        return 0;
+
+    // Select MIP level (untextured polygons are rasterized with the flat color, see _select_span_miplevel for MIP-mapping)
+    PRtexsize mipWidth = 0, mipHeight = 0;
+    const PRcolorindex* texels = NULL;
+    if (polygon->texture != NULL && !state->mipMapping)
+        texels = _pr_texture_select_miplevel(polygon->texture, polygon->mipLevel, &mipWidth, &mipHeight);
+
+    const PRint numEdges = polygon->numEdges;
+    const pr_attrib_plane* zPlane = &(polygon->zPlane);
+    const pr_attrib_plane* uPlane = &(polygon->uPlane);
+    const pr_attrib_plane* vPlane = &(polygon->vPlane);
+
+    // Walk over all blocks which overlap the bounding rectangle
+    const PRint pitch = (PRint)frameBuffer->width;
+    const PRint blockMask = ~(PR_RASTER_BLOCK_SIZE - 1);
+    const PRint tileEnd = _tile_row_end(frameBuffer, tile);
+
+    PRareatype eRow[PR_MAX_NUM_POLYGON_VERTS], ePixel[PR_MAX_NUM_POLYGON_VERTS];
+    PRint spanStart[PR_RASTER_BLOCK_SIZE], spanEnd[PR_RASTER_BLOCK_SIZE];
+    PRint i, r, x;
+    PRuint coverage = 0;
+
+    pr_span span;
+    span.subspanLength  = state->subspanLength;
+    span.color          = state->color;
+    span.zStep          = PR_INTERP_ACC_FROM_REAL(zPlane->dx);
+    span.uStep          = PR_INTERP_ACC_FROM_REAL(uPlane->dx);
+    span.vStep          = PR_INTERP_ACC_FROM_REAL(vPlane->dx);
+
+    for (PRint by = (yMin & blockMask); by <= yMax; by += PR_RASTER_BLOCK_SIZE)
+    {
+        const PRint y0 = PR_MAX(by, yMin);
+        const PRint y1 = PR_MIN(by + PR_RASTER_BLOCK_SIZE - 1, yMax);
+        const PRint numRows = y1 - y0 + 1;
+
+        // Covered pixels of each row are collected over all blocks of this block row
+        for (r = 0; r < numRows; ++r)
+        {
+            spanStart[r] = xMax + 1;
+            spanEnd[r] = xMin - 1;
+        }
+
+        for (PRint bx = (xMin & blockMask); bx <= xMax; bx += PR_RASTER_BLOCK_SIZE)
+        {
+            const PRint x0 = PR_MAX(bx, xMin);
+            const PRint x1 = PR_MIN(bx + PR_RASTER_BLOCK_SIZE - 1, xMax);
+
+            // Classify block against all edges by their minimal and maximal values at the block corners
+            PRboolean accept = PR_TRUE;
+
+            for (i = 0; i < numEdges; ++i)
+            {
+                const pr_edge_function* edge = &(edges[i]);
+                const PRareatype e = edge->a * x0 + edge->b * y0 + edge->c;
+                const PRareatype ex = edge->a * (x1 - x0);
+                const PRareatype ey = edge->b * (y1 - y0);
+
+                // Trivial reject: block is completely outside of this edge
+                if (e + PR_MAX(ex, 0) + PR_MAX(ey, 0) < 0)
+                    break;
+
+                // Block is not completely inside of this edge
+                if (e + PR_MIN(ex, 0) + PR_MIN(ey, 0) < 0)
+                    accept = PR_FALSE;
+
+                eRow[i] = e;
+            }
+
+            if (i < numEdges)
+                continue;
+
+            if (accept)
+            {
+                // Block is completely covered
+                for (r = 0; r < numRows; ++r)
+                {
+                    PR_CLAMP_SMALLEST(spanStart[r], x0);
+                    spanEnd[r] = x1;
+                }
+                continue;
+            }
+
+            if (numEdges == 3)
+            {
+                // Common case: triangle with its edge functions in registers
+                const PRareatype a0 = edges[0].a, a1 = edges[1].a, a2 = edges[2].a;
+                const PRareatype b0 = edges[0].b, b1 = edges[1].b, b2 = edges[2].b;
+                PRareatype e0 = eRow[0], e1 = eRow[1], e2 = eRow[2];
+
+                for (r = 0; r < numRows; ++r, e0 += b0, e1 += b1, e2 += b2)
+                {
+                    PRareatype f0 = e0, f1 = e1, f2 = e2;
+
+                    // Skip the pixels in front of the polygon ...
+                    for (x = x0; x <= x1 && (f0 | f1 | f2) < 0; ++x, f0 += a0, f1 += a1, f2 += a2);
+
+                    if (x > x1)
+                        continue;
+
+                    // ... and find the end of the covered pixels (the polygon is convex)
+                    PR_CLAMP_SMALLEST(spanStart[r], x);
+                    for (; x <= x1 && (f0 | f1 | f2) >= 0; ++x, f0 += a0, f1 += a1, f2 += a2);
+                    spanEnd[r] = x - 1;
+                }
+                continue;
+            }
+
+            for (r = 0; r < numRows; ++r)
+            {
+                // Step the edge functions over the block row: skip the pixels in front of the polygon ...
+                for (i = 0; i < numEdges; ++i)
+                    ePixel[i] = eRow[i];
+
+                for (x = x0; x <= x1; ++x)
+                {
+                    PRareatype inside = 0;
+                    for (i = 0; i < numEdges; ++i)
+                    {
+                        inside |= ePixel[i];
+                        ePixel[i] += edges[i].a;
+                    }
+                    if (inside >= 0)
+                        break;
+                }
+
+                if (x <= x1)
+                {
+                    // ... and find the end of the covered pixels (the polygon is convex)
+                    const PRint xStart = x;
+
+                    for (++x; x <= x1; ++x)
+                    {
+                        PRareatype inside = 0;
+                        for (i = 0; i < numEdges; ++i)
+                        {
+                            inside |= ePixel[i];
+                            ePixel[i] += edges[i].a;
+                        }
+                        if (inside < 0)
+                            break;
+                    }
+
+                    PR_CLAMP_SMALLEST(spanStart[r], xStart);
+                    spanEnd[r] = x - 1;
+                }
+
+                for (i = 0; i < numEdges; ++i)
+                    eRow[i] += edges[i].b;
+            }
+        }
+
+        // Rasterize the covered span of each row of this block row
+        for (r = 0; r < numRows; ++r)
+        {
+            const PRint xStart = spanStart[r], y = y0 + r;
+
+            if (xStart > spanEnd[r])
+                continue;
+
+            span.colors = &(frameBuffer->colors[y * pitch + xStart]);
+            span.depths = _pr_framebuffer_depth_at(frameBuffer, (PRuint)(y * pitch + xStart));
+            span.length = spanEnd[r] - xStart + 1;
+            span.slack  = tileEnd - spanEnd[r] - 1;
+            span.z      = PR_INTERP_ACC_FROM_REAL(zPlane->f0 + zPlane->dx * xStart + zPlane->dy * y);
+            span.u      = PR_INTERP_ACC_FROM_REAL(uPlane->f0 + uPlane->dx * xStart + uPlane->dy * y);
+            span.v      = PR_INTERP_ACC_FROM_REAL(vPlane->f0 + vPlane->dx * xStart + vPlane->dy * y);
+            coverage   += (PRuint)span.length;
+
+            if (state->mipMapping)
+                texels = _select_span_miplevel(polygon, (xStart + spanEnd[r]) / 2, y, &mipWidth, &mipHeight);
+
+            state->spanKernel(&span, texels, mipWidth, mipHeight);
+        }
+    }
+
+    return coverage;
+}
@@ -0,0 +1,134 @@
+/*
+ * rasterizer.h
+ *
+ * This file is part of the "PicoRenderer" (Copyright (c) 2014 by Lukas Hermanns)
+ * See "LICENSE.txt" for license information.
+ */
+
+#ifndef __PR_RASTERIZER_H__
+#define __PR_RASTERIZER_H__
+
+
+#include "framebuffer.h"
+#include "texture.h"
+#include "rect.h"
+#include "raster_vertex.h"
+#include "span.h"
+#include "fixed_point.h"
+#include "static_config.h"
+
+
+//! Maximal number of vertices of a clipped polygon.
+#define PR_MAX_NUM_POLYGON_VERTS    32
+
+//! Width and height (in pixels) of the blocks the half-space rasterizer walks over.
+#define PR_RASTER_BLOCK_SIZE        8
+
+
+//! Edge function E(x, y) = a*x + b*y + c in pixel coordinates, which is non-negative for all covered pixels.
+typedef struct pr_edge_function
+{
+    PRareatype a;
+    PRareatype b;
+    PRareatype c;
+}
+pr_edge_function;
+
+//! Plane equation f(x, y) = f0 + dx*x + dy*y of an interpolated attribute.
+typedef struct pr_attrib_plane
+{
+    PRinterpreal f0;
+    PRinterpreal dx;
+    PRinterpreal dy;
+}
+pr_attrib_plane;
+
+//! Render states which are shared by all polygons of a draw call.
+typedef struct pr_raster_state
+{
+    PRenum              rasterizerMode; //!< PR_RASTERIZER_SCANLINE or PR_RASTERIZER_HALFSPACE.
+    PRint               subspanLength;  //!< Number of pixels between two perspective divisions (0 for each pixel).
+    PRboolean           depthTest;      //!< Specifies whether pixels make the depth test (see PR_DEPTH_TEST). Otherwise HiZ culling is disabled, too.
+    PRboolean           depthWrite;     //!< Specifies whether visible pixels write their depth (see prDepthMask). Only with depth test.
+    PRcolorindex        color;          //!< Flat color index for untextured polygons.
+    PRboolean           mipMapping;     //!< Specifies whether the MIP level is selected per span by the texture coordinate derivatives (see PR_MIP_MAPPING).
+    pr_span_kernel      spanKernel;     //!< Span kernel which is specialized for these states (see _pr_span_kernel_select). Null if nothing is written.
+}
+pr_raster_state;
+
+//! Convex polygon which is ready to be rasterized.
+typedef struct pr_raster_polygon
+{
+    PRuint              firstVertex;    //!< Index of the first raster vertex (within the vertex array of the tile binner).
+    PRint               numVertices;    //!< Number of raster vertices.
+    PRint               top;            //!< Index of the top most vertex (relative to 'firstVertex').
+    PRint               bottom;         //!< Index of the bottom most vertex (relative to 'firstVertex').
+    PRboolean           swapSides;      //!< Specifies whether the vertices are in counter-clockwise order.
+    pr_rect             bounds;         //!< Bounding rectangle in screen space.
+    const pr_texture*   texture;        //!< Texture or null for the flat color (see pr_raster_state::color).
+    PRubyte             mipLevel;       //!< MIP level for the whole polygon (only if pr_raster_state::mipMapping is disabled).
+    PRuint              depthMax;       //!< Largest (i.e. nearest) depth bits of all vertices (for the HiZ test, see _pr_pixel_depth_bits).
+    PRint               numEdges;       //!< Number of edge functions (only for the half-space rasterizer).
+    pr_attrib_plane     zPlane;         //!< Attribute planes (only for the half-space rasterizer and for pr_raster_state::mipMapping).
+    pr_attrib_plane     uPlane;
+    pr_attrib_plane     vPlane;
+}
+pr_raster_polygon;
+
+//! Screen tile with the scanline sides of the thread which rasterizes it.
+typedef struct pr_raster_tile
+{
+    pr_rect             rect;                       //!< Tile rectangle in screen space (right and bottom are inclusive).
+    pr_scaline_side     sidesStart[PR_TILE_SIZE];   //!< Start offsets to the tile scanlines.
+    pr_scaline_side     sidesEnd[PR_TILE_SIZE];     //!< End offsets to the tile scanlines.
+}
+pr_raster_tile;
+
+
+/**
+Sets up the specified raster polygon (top, bottom, orientation, bounding rectangle and nearest depth).
+\param[in] depthFormat Specifies the depth format of the frame buffer, which determines the depth bits for the HiZ test.
+\return PR_FALSE if the polygon is degenerated and must not be rasterized.
+*/
+PRboolean _pr_raster_polygon_setup(pr_raster_polygon* polygon, const pr_raster_vertex* vertices, PRenum depthFormat);
+
+/**
+Sets up the attribute planes of the specified raster polygon, which the scanline rasterizer needs for the per-span MIP selection.
+This must be called once after '_pr_raster_polygon_setup' (it is included in '_pr_raster_polygon_setup_halfspace').
+\return PR_FALSE if the polygon is degenerated and must not be rasterized.
+*/
+PRboolean _pr_raster_polygon_setup_planes(pr_raster_polygon* polygon, const pr_raster_vertex* vertices);
+
+/**
+Sets up the edge functions and attribute planes of the specified raster polygon for the half-space rasterizer.
+This must be called once after '_pr_raster_polygon_setup', so that the setup is shared by all tiles the polygon overlaps.
+\param[out] edges Specifies the output edge functions. This must have at least as many entries as the polygon has vertices.
+\return PR_FALSE if the polygon is degenerated and must not be rasterized.
+*/
+PRboolean _pr_raster_polygon_setup_halfspace(pr_raster_polygon* polygon, const pr_raster_vertex* vertices, pr_edge_function* edges);
+
+/**
+Rasterizes the part of the specified convex polygon which lies inside the tile rectangle.
+Without color writes (see pr_raster_state), only the depth buffer is updated and the texture is never sampled.
+With MIP-mapping (see pr_raster_state::mipMapping), the MIP level is selected for each span at its center pixel.
+\return Number of pixels covered by the polygon inside the tile (whether they passed the depth test or not).
+*/
+PRuint _pr_rasterize_polygon_fill(
+    pr_framebuffer* frameBuffer, pr_raster_tile* tile, const pr_raster_state* state,
+    const pr_raster_polygon* polygon, const pr_raster_vertex* vertices
+);
+
+/**
+Rasterizes the part of the specified convex polygon which lies inside the tile rectangle with edge functions.
+The tile is walked in blocks of PR_RASTER_BLOCK_SIZE x PR_RASTER_BLOCK_SIZE pixels, which are either rejected,
+filled without edge tests or tested per pixel. Pixels on shared edges are only covered once (top-left fill rule).
+\param[in] edges Specifies the edge functions from '_pr_raster_polygon_setup_halfspace'.
+\return Number of pixels covered by the polygon inside the tile (whether they passed the depth test or not).
+*/
+PRuint _pr_rasterize_polygon_halfspace(
+    pr_framebuffer* frameBuffer, pr_raster_tile* tile, const pr_raster_state* state,
+    const pr_raster_polygon* polygon, const pr_edge_function* edges
+);
+
+
+#endif
@@ -9,6 +9,8 @@
 #include "state_machine.h"
 #include "global_state.h"
 #include "raster_triangle.h"
+#include "rasterizer.h"
+#include "fixed_point.h"
 #include "ext_math.h"
 #include "matrix4.h"
 #include "error.h"
@@ -16,17 +18,24 @@
 
 #include <stdio.h>
 #include <math.h>
+#include <string.h>
 
 
 // --- internals ---
 
-#define MAX_NUM_POLYGON_VERTS 32
-
-static pr_clip_vertex _clipVertices[MAX_NUM_POLYGON_VERTS], _clipVerticesTmp[MAX_NUM_POLYGON_VERTS];
-static pr_raster_vertex _rasterVertices[MAX_NUM_POLYGON_VERTS], _rasterVerticesTmp[MAX_NUM_POLYGON_VERTS];
-static PRint _numPolyVerts = 0;
+//! Polygon with its scratch buffers for clipping and projection.
+typedef struct pr_polygon
+{
+    pr_clip_vertex      clipVertices[PR_MAX_NUM_POLYGON_VERTS];
+    pr_clip_vertex      clipVerticesTmp[PR_MAX_NUM_POLYGON_VERTS];
+    pr_raster_vertex    rasterVertices[PR_MAX_NUM_POLYGON_VERTS];
+    pr_raster_vertex    rasterVerticesTmp[PR_MAX_NUM_POLYGON_VERTS];
+    PRfloat             rhw[PR_MAX_NUM_POLYGON_VERTS];
+    PRint               numVertices;
+}
+pr_polygon;
 
-#define _CVERT_VEC2(v) (*(pr_vector2*)(&((_clipVertices[v]).x)))
+#define _CVERT_VEC2(p, v) (*(pr_vector2*)(&(((p)->clipVertices[v]).x)))
 
 static void _vertexbuffer_transform(PRsizei numVertices, PRsizei firstVertex, pr_vertexbuffer* vertexBuffer)
 {
@@ -48,19 +57,9 @@ static void _vertexbuffer_transform_all(pr_vertexbuffer* vertexBuffer)
     );
 }
 
-static void _transform_vertex(pr_clip_vertex* clipVert, const pr_vertex* vert)
-{
-    _pr_matrix_mul_float4(&(clipVert->x), &(PR_STATE_MACHINE.worldViewProjectionMatrix), &(vert->coord.x));
-    clipVert->u = vert->texCoord.x;
-    clipVert->v = vert->texCoord.y;
-}
-
-static void _project_vertex(pr_clip_vertex* vertex, const pr_viewport* viewport)
+static void _project_vertex(pr_clip_vertex* vertex, PRfloat rhw, const pr_viewport* viewport)
 {
     // Transform coordinate into normalized device coordinates
-    //vertex->z = 1.0f / vertex->w;
-    PRfloat rhw = 1.0f / vertex->w;
-
     vertex->x *= rhw;
     vertex->y *= rhw;
     //vertex->z *= rhw;
@@ -80,11 +79,17 @@ static void _project_vertex(pr_clip_vertex* vertex, const pr_viewport* viewport)
 
 static void _setup_raster_vertex(pr_raster_vertex* rasterVert, const pr_clip_vertex* clipVert)
 {
+    #ifdef PR_FIXED_POINT
+    // Convert to sub-pixel coordinates (remove rounding adjustment of the projection)
+    rasterVert->x = (PRint)(clipVert->x * PR_SUBPIXEL_ONE) - (PR_SUBPIXEL_ONE >> 1);
+    rasterVert->y = (PRint)(clipVert->y * PR_SUBPIXEL_ONE) - (PR_SUBPIXEL_ONE >> 1);
+    #else
     rasterVert->x = (PRint)(clipVert->x);
     rasterVert->y = (PRint)(clipVert->y);
-    rasterVert->z = clipVert->z;
-    rasterVert->u = clipVert->u;
-    rasterVert->v = clipVert->v;
+    #endif
+    rasterVert->z = PR_INTERP_FROM_FLOAT(clipVert->z);
+    rasterVert->u = PR_INTERP_FROM_FLOAT(clipVert->u);
+    rasterVert->v = PR_INTERP_FROM_FLOAT(clipVert->v);
 }
 
 // Returns PR_TRUE if the specified triangle vertices are culled.
@@ -108,6 +113,25 @@ static PRboolean _is_triangle_culled(const pr_vector2 a, const pr_vector2 b, con
     return PR_FALSE;
 }
 
+// Returns the bound texture after generating the MIP levels which the draw call can sample (see PR_TEXTURE_LAZY_MIPS).
+static pr_texture* _bound_texture()
+{
+    pr_texture* texture = PR_STATE_MACHINE.boundTexture;
+
+    #ifdef PR_TEXTURE_LAZY_MIPS
+    // With MIP-mapping any level can be selected, otherwise only the level of the LOD bias
+    if (texture != NULL && texture->mips > 1)
+    {
+        if (PR_STATE_MACHINE.states[PR_MIP_MAPPING] != PR_FALSE)
+            _pr_texture_generate_mips(texture, texture->mips - 1);
+        else
+            _pr_texture_generate_mips(texture, PR_STATE_MACHINE.textureLodBias);
+    }
+    #endif
+
+    return texture;
+}
+
 // --- points --- //
 
 void _pr_render_screenspace_point(PRint x, PRint y)
@@ -133,6 +157,7 @@ void _pr_render_screenspace_point(PRint x, PRint y)
     #endif
 
     // Plot screen space point
+    _pr_framebuffer_resolve_rect(frameBuffer, x, y, x, y);
     _pr_framebuffer_plot(frameBuffer, x, y, PR_STATE_MACHINE.color0);
 }
 
@@ -162,6 +187,7 @@ void _pr_render_points(PRsizei numVertices, PRsizei firstVertex, /*const */pr_ve
      
     // Transform vertices
     _vertexbuffer_transform(numVertices, firstVertex, vertexBuffer);
+    _pr_framebuffer_resolve(frameBuffer);
     
     // Render points
     pr_vertex* vert;
@@ -269,19 +295,23 @@ static void _render_screenspace_line_colored(PRint x1, PRint y1, PRint x2, PRint
     }
 }
 
-// Rasterizes a textured line using the "Bresenham" algorithm
-static void _rasterize_line(pr_framebuffer* frameBuffer, const pr_texture* texture, PRubyte mipLevel, PRuint indexA, PRuint indexB)
+// Rasterizes a textured line (or a line with the active color if the texture is null) using the "Bresenham" algorithm
+static void _rasterize_line(
+    pr_framebuffer* frameBuffer, const pr_texture* texture, PRubyte mipLevel, const pr_raster_vertex* vertexA, const pr_raster_vertex* vertexB)
 {
-    const pr_raster_vertex* vertexA = &(_rasterVertices[indexA]);
-    const pr_raster_vertex* vertexB = &(_rasterVertices[indexB]);
-
-    // Select MIP level
+    // Select MIP level and sampler
     PRtexsize mipWidth = 0, mipHeight = 0;
-    const PRcolorindex* texels = _pr_texture_select_miplevel(texture, mipLevel, &mipWidth, &mipHeight);
+    const PRcolorindex* texels = NULL;
+    pr_texture_sampler sampler = NULL;
+    if (texture != NULL)
+    {
+        texels = _pr_texture_select_miplevel(texture, mipLevel, &mipWidth, &mipHeight);
+        sampler = _pr_texture_select_sampler(texture);
+    }
 
     // Pre-compuations
-    int dx = vertexB->x - vertexA->x;
-    int dy = vertexB->y - vertexA->y;
+    int dx = PR_RASTER_TO_PIXEL(vertexB->x) - PR_RASTER_TO_PIXEL(vertexA->x);
+    int dy = PR_RASTER_TO_PIXEL(vertexB->y) - PR_RASTER_TO_PIXEL(vertexA->y);
     
     int incx = PR_SIGN(dx);
     int incy = PR_SIGN(dy);
@@ -315,12 +345,12 @@ static void _rasterize_line(pr_framebuffer* frameBuffer, const pr_texture* textu
     if (el == 0)
         return;
     
-    int x = vertexA->x;
-    int y = vertexA->y;
+    int x = PR_RASTER_TO_PIXEL(vertexA->x);
+    int y = PR_RASTER_TO_PIXEL(vertexA->y);
     PRinterp u = vertexA->u;
     PRinterp v = vertexA->v;
 
-    PRinterp uStep = PR_FLOAT(0.0), vStep = PR_FLOAT(0.0);
+    PRinterp uStep = 0, vStep = 0;
 
     if (el > 1)
     {
@@ -330,13 +360,14 @@ static void _rasterize_line(pr_framebuffer* frameBuffer, const pr_texture* textu
 
     int err = el/2;
 
-    PRcolorindex colorIndex;
+    PRcolorindex colorIndex = PR_STATE_MACHINE.color0;
     
     // Render each pixel of the line
     for (PRint t = 0; t < el; ++t)
     {
         // Render pixel
-        colorIndex = _pr_texture_sample_nearest_from_mipmap(texels, mipWidth, mipHeight, (PRfloat)u, (PRfloat)v);
+        if (texels != NULL)
+            colorIndex = sampler(texels, mipWidth, mipHeight, PR_INTERP_TO_FLOAT(u), PR_INTERP_TO_FLOAT(v));
 
         _pr_framebuffer_plot(frameBuffer, (PRuint)x, (PRuint)y, colorIndex);
         
@@ -417,6 +448,7 @@ void _pr_render_screenspace_line(PRint x1, PRint y1, PRint x2, PRint y2)
     y2 = frameBuffer->height - y2 - 1;
     #endif
 
+    _pr_framebuffer_resolve_rect(frameBuffer, PR_MIN(x1, x2), PR_MIN(y1, y2), PR_MAX(x1, x2), PR_MAX(y1, y2));
     _render_screenspace_line_colored(x1, y1, x2, y2);
 }
 
@@ -454,9 +486,12 @@ void _pr_render_indexed_lines(PRsizei numVertices, PRsizei firstVertex, /*const
     }
 
     _vertexbuffer_transform_all(vertexBuffer);
+    _pr_framebuffer_resolve(PR_STATE_MACHINE.boundFrameBuffer);
 
-    if (PR_STATE_MACHINE.boundTexture != NULL)
-        _render_indexed_lines_textured(PR_STATE_MACHINE.boundTexture, numVertices, firstVertex, vertexBuffer, indexBuffer);
+    const pr_texture* texture = _bound_texture();
+
+    if (texture != NULL)
+        _render_indexed_lines_textured(texture, numVertices, firstVertex, vertexBuffer, indexBuffer);
     else
         _render_indexed_lines_colored(numVertices, firstVertex, vertexBuffer, indexBuffer);
 }
@@ -494,15 +529,18 @@ static void _render_screenspace_image_textured(const pr_texture* texture, PRint
     if (left > right)
         PR_SWAP(PRint, left, right);
 
+    _pr_framebuffer_resolve_rect(frameBuffer, left, top, right, bottom);
+
     // Select MIP level
     PRtexsize width = 0, height = 0;
     PRubyte mipLevel = 0;//_pr_texture_compute_miplevel(texture, 1.0f / (PRfloat)(right - left), 0.0f, 0.0f, 1.0f / (PRfloat)(bottom - top));
     const PRcolorindex* texels = _pr_texture_select_miplevel(texture, mipLevel, &width, &height);
+    const pr_texture_sampler sampler = _pr_texture_select_sampler(texture);
 
     // Rasterize rectangle
-    pr_pixel* pixels = frameBuffer->pixels;
+    PRcolorindex* colors = frameBuffer->colors;
     const PRuint pitch = frameBuffer->width;
-    pr_pixel* scanline;
+    PRcolorindex* scanline;
 
     PRfloat u = 0.0f;
     #ifdef PR_ORIGIN_LEFT_TOP
@@ -516,13 +554,13 @@ static void _render_screenspace_image_textured(const pr_texture* texture, PRint
 
     for (PRint y = top; y <= bottom; ++y)
     {
-        scanline = pixels + (y * pitch + left);
+        scanline = colors + (y * pitch + left);
         
         u = 0.0f;
 
         for (PRint x = left; x <= right; ++x)
         {
-            PRcolorindex color = _pr_texture_sample_nearest_from_mipmap(texels, width, height, u, v);
+            PRcolorindex color = sampler(texels, width, height, u, v);
 
             #ifdef PR_BLACK_IS_ALPHA
             #   ifdef PR_COLOR_BUFFER_24BIT
@@ -534,7 +572,7 @@ static void _render_screenspace_image_textured(const pr_texture* texture, PRint
             #   endif
             #endif
 
-            scanline->colorIndex = color;
+            *scanline = color;
 
             #ifdef PR_BLACK_IS_ALPHA
             }
@@ -573,19 +611,22 @@ static void _render_screenspace_image_colored(PRcolorindex colorIndex, PRint lef
     if (left > right)
         PR_SWAP(PRint, left, right);
 
+    _pr_framebuffer_resolve_rect(frameBuffer, left, top, right, bottom);
+
     // Rasterize rectangle
-    pr_pixel* pixels = frameBuffer->pixels;
+    PRcolorindex* colors = frameBuffer->colors;
     const PRuint pitch = frameBuffer->width;
-    pr_pixel* scanline;
+    PRcolorindex* scanline;
 
     for (PRint y = top; y <= bottom; ++y)
     {
-        scanline = pixels + (y * pitch + left);
+        scanline = colors + (y * pitch + left);
+        #ifdef PR_COLOR_BUFFER_24BIT
         for (PRint x = left; x <= right; ++x)
-        {
-            scanline->colorIndex = colorIndex;
-            ++scanline;
-        }
+            scanline[x - left] = colorIndex;
+        #else
+        memset(scanline, colorIndex, (size_t)(right - left + 1));
+        #endif
     }
 }
 
@@ -593,8 +634,10 @@ void _pr_render_screenspace_image(PRint left, PRint top, PRint right, PRint bott
 {
     if (PR_STATE_MACHINE.boundFrameBuffer != NULL)
     {
-        if (PR_STATE_MACHINE.boundTexture != NULL)
-            _render_screenspace_image_textured(PR_STATE_MACHINE.boundTexture, left, top, right, bottom);
+        const pr_texture* texture = _bound_texture();
+
+        if (texture != NULL)
+            _render_screenspace_image_textured(texture, left, top, right, bottom);
         else
             _render_screenspace_image_colored(PR_STATE_MACHINE.color0, left, top, right, bottom);
     }
@@ -604,431 +647,476 @@ void _pr_render_screenspace_image(PRint left, PRint top, PRint right, PRint bott
 
 // --- triangles --- //
 
-// Computes the vertex 'c' which is cliped between the vertices 'a' and 'b' and the plane 'z'
-static pr_clip_vertex _get_zplane_vertex(pr_clip_vertex a, pr_clip_vertex b, PRfloat z)
+// Returns the signed distance of the specified vertex to the clipping plane (positive values are inside)
+static PRfloat _clip_plane_distance(const pr_clip_vertex* vertex, PRuint plane, const pr_vector2* guardBand)
+{
+    switch (plane)
+    {
+        case PR_CLIP_NEAR:
+            return vertex->z;
+        case PR_CLIP_FAR:
+            return vertex->w - vertex->z;
+        case PR_CLIP_GUARD_LEFT:
+            return guardBand->x * vertex->w + vertex->x;
+        case PR_CLIP_GUARD_RIGHT:
+            return guardBand->x * vertex->w - vertex->x;
+        case PR_CLIP_GUARD_BOTTOM:
+            return guardBand->y * vertex->w + vertex->y;
+        case PR_CLIP_GUARD_TOP:
+            return guardBand->y * vertex->w - vertex->y;
+        default:
+            return vertex->w - PR_CLIP_MIN_W;
+    }
+}
+
+// Computes the vertex 'c' which is interpolated from the vertex 'a' towards 'b' by the factor 't'
+static pr_clip_vertex _interp_clip_vertex(const pr_clip_vertex* a, const pr_clip_vertex* b, PRfloat t)
 {
-    PRinterp m = ((PRinterp)(z - b.z)) / (a.z - b.z);
     pr_clip_vertex c;
 
-    c.x = (PRfloat)(m * (a.x - b.x) + b.x);
-    c.y = (PRfloat)(m * (a.y - b.y) + b.y);
-    c.z = z;
-    c.w = (PRfloat)(m * (a.w - b.w) + b.w);
+    c.x = a->x + t * (b->x - a->x);
+    c.y = a->y + t * (b->y - a->y);
+    c.z = a->z + t * (b->z - a->z);
+    c.w = a->w + t * (b->w - a->w);
 
-    c.u = (PRfloat)(m * (a.u - b.u) + b.u);
-    c.v = (PRfloat)(m * (a.v - b.v) + b.v);
+    c.u = a->u + t * (b->u - a->u);
+    c.v = a->v + t * (b->v - a->v);
 
     return c;
 }
 
-// Clips the polygon at the z planes
-static void _polygon_z_clipping(PRfloat zMin, PRfloat zMax)
+// Clips the vertices 'src' at the specified plane and returns the number of vertices written to 'dst'
+static PRint _clip_polygon_plane(
+    pr_clip_vertex* dst, const pr_clip_vertex* src, PRint numVertices, PRuint plane, const pr_vector2* guardBand)
 {
-    PRint x, y;
+    PRint numDstVertices = 0;
+    PRfloat dx = _clip_plane_distance(&(src[numVertices - 1]), plane, guardBand), dy;
 
-    // Clip at near clipping plane (zMin)
-    PRint localNumVerts = 0;
-
-    for (x = _numPolyVerts - 1, y = 0; y < _numPolyVerts; x = y, ++y)
+    for (PRint x = numVertices - 1, y = 0; y < numVertices; x = y, ++y, dx = dy)
     {
-        // Inside
-        if (_clipVertices[x].z >= zMin && _clipVertices[y].z >= zMin)
-            _clipVerticesTmp[localNumVerts++] = _clipVertices[y];
+        dy = _clip_plane_distance(&(src[y]), plane, guardBand);
 
-        // Leaving
-        if (_clipVertices[x].z >= zMin && _clipVertices[y].z < zMin)
-            _clipVerticesTmp[localNumVerts++] = _get_zplane_vertex(_clipVertices[x], _clipVertices[y], zMin);
+        // Edge crosses the plane (always interpolate from the inner vertex, so that shared edges are clipped equally)
+        if (dx >= 0.0f && dy < 0.0f)
+            dst[numDstVertices++] = _interp_clip_vertex(&(src[x]), &(src[y]), dx / (dx - dy));
+        else if (dx < 0.0f && dy >= 0.0f)
+            dst[numDstVertices++] = _interp_clip_vertex(&(src[y]), &(src[x]), dy / (dy - dx));
 
-        // Entering
-        if (_clipVertices[x].z < zMin && _clipVertices[y].z >= zMin)
-        {
-            _clipVerticesTmp[localNumVerts++] = _get_zplane_vertex(_clipVertices[x], _clipVertices[y], zMin);
-            _clipVerticesTmp[localNumVerts++] = _clipVertices[y];
-        }
+        if (dy >= 0.0f)
+            dst[numDstVertices++] = src[y];
     }
 
-    // Clip at far clipping plane (zMax)
-    _numPolyVerts = 0;
+    return numDstVertices;
+}
 
-    for (x = localNumVerts - 1, y = 0; y < localNumVerts; x = y, ++y)
+// Clips the polygon at all near, far and guard band planes, which are crossed by its vertices (see 'outcodes')
+static void _polygon_clip_space_clipping(pr_polygon* polygon, PRuint outcodes, const pr_vector2* guardBand)
+{
+    static const PRuint planes[] =
     {
-        // Inside
-        if (_clipVerticesTmp[x].z <= zMax && _clipVerticesTmp[y].z <= zMax)
-            _clipVertices[_numPolyVerts++] = _clipVerticesTmp[y];
+        PR_CLIP_NEAR, PR_CLIP_FAR, PR_CLIP_DEPTH, PR_CLIP_GUARD_LEFT, PR_CLIP_GUARD_RIGHT, PR_CLIP_GUARD_BOTTOM, PR_CLIP_GUARD_TOP
+    };
 
-        // Leaving
-        if (_clipVerticesTmp[x].z <= zMax && _clipVerticesTmp[y].z > zMax)
-            _clipVertices[_numPolyVerts++] = _get_zplane_vertex(_clipVerticesTmp[x], _clipVerticesTmp[y], zMax);
+    pr_clip_vertex* verts = polygon->clipVertices;
+    pr_clip_vertex* vertsTmp = polygon->clipVerticesTmp;
 
-        // Entering
-        if (_clipVerticesTmp[x].z > zMax && _clipVerticesTmp[y].z <= zMax)
+    for (PRint i = 0; i < 7 && polygon->numVertices > 0; ++i)
+    {
+        if ((outcodes & planes[i]) != 0)
         {
-            _clipVertices[_numPolyVerts++] = _get_zplane_vertex(_clipVerticesTmp[x], _clipVerticesTmp[y], zMax);
-            _clipVertices[_numPolyVerts++] = _clipVerticesTmp[y];
+            polygon->numVertices = _clip_polygon_plane(vertsTmp, verts, polygon->numVertices, planes[i], guardBand);
+            PR_SWAP(pr_clip_vertex*, verts, vertsTmp);
         }
     }
+
+    if (verts != polygon->clipVertices)
+        memcpy(polygon->clipVertices, verts, sizeof(pr_clip_vertex) * polygon->numVertices);
 }
 
-// Computes the vertex 'c' which is cliped between the vertices 'a' and 'b' and the plane 'x'
-static pr_raster_vertex _get_xplane_vertex(pr_raster_vertex a, pr_raster_vertex b, PRint x)
+// Computes the vertex which is interpolated between the vertices 'a' and 'b' by the factor num/den
+static pr_raster_vertex _interp_raster_vertex(pr_raster_vertex a, pr_raster_vertex b, PRint num, PRint den)
 {
-    PRinterp m = ((PRinterp)(x - b.x)) / (a.x - b.x);
     pr_raster_vertex c;
 
-    c.x = x;
+    #ifdef PR_FIXED_POINT
+    c.x = b.x + (PRint)(((PRint64)(a.x - b.x) * num) / den);
+    c.y = b.y + (PRint)(((PRint64)(a.y - b.y) * num) / den);
+    c.z = b.z + PR_INTERP_MULDIV(a.z - b.z, num, den);
+
+    c.u = b.u + PR_INTERP_MULDIV(a.u - b.u, num, den);
+    c.v = b.v + PR_INTERP_MULDIV(a.v - b.v, num, den);
+    #else
+    PRinterp m = ((PRinterp)num) / den;
+
+    c.x = (PRint)(m * (a.x - b.x) + b.x);
     c.y = (PRint)(m * (a.y - b.y) + b.y);
     c.z = m * (a.z - b.z) + b.z;
 
     c.u = m * (a.u - b.u) + b.u;
     c.v = m * (a.v - b.v) + b.v;
+    #endif
+
+    return c;
+}
+
+// Swaps the vertices 'a' and 'b' into a canonical order, so that an edge is clipped equally for both of its polygons
+static void _sort_raster_vertices(pr_raster_vertex* a, pr_raster_vertex* b)
+{
+    if (a->x < b->x || (a->x == b->x && a->y < b->y))
+        PR_SWAP(pr_raster_vertex, *a, *b);
+}
 
+// Computes the vertex 'c' which is cliped between the vertices 'a' and 'b' and the plane 'x'
+static pr_raster_vertex _get_xplane_vertex(pr_raster_vertex a, pr_raster_vertex b, PRint x)
+{
+    _sort_raster_vertices(&a, &b);
+    pr_raster_vertex c = _interp_raster_vertex(a, b, x - b.x, a.x - b.x);
+    c.x = x;
     return c;
 }
 
 // Computes the vertex 'c' which is cliped between the vertices 'a' and 'b' and the plane 'y'
 static pr_raster_vertex _get_yplane_vertex(pr_raster_vertex a, pr_raster_vertex b, PRint y)
 {
-    PRinterp m = ((PRinterp)(y - b.y)) / (a.y - b.y);
-    pr_raster_vertex c;
-
-    c.x = (PRint)(m * (a.x - b.x) + b.x);
+    _sort_raster_vertices(&a, &b);
+    pr_raster_vertex c = _interp_raster_vertex(a, b, y - b.y, a.y - b.y);
     c.y = y;
-    c.z = m * (a.z - b.z) + b.z;
-
-    c.u = m * (a.u - b.u) + b.u;
-    c.v = m * (a.v - b.v) + b.v;
-
     return c;
 }
 
 // Clips the polygon at the x and y planes
-static void _polygon_xy_clipping(PRint xMin, PRint xMax, PRint yMin, PRint yMax)
+static void _polygon_xy_clipping(pr_polygon* polygon, PRint xMin, PRint xMax, PRint yMin, PRint yMax)
 {
+    pr_raster_vertex* verts = polygon->rasterVertices;
+    pr_raster_vertex* vertsTmp = polygon->rasterVerticesTmp;
     PRint x, y;
 
+    // Skip clipping if all vertices are inside (trivial accept)
+    for (x = 0; x < polygon->numVertices; ++x)
+    {
+        if (verts[x].x < xMin || verts[x].x > xMax || verts[x].y < yMin || verts[x].y > yMax)
+            break;
+    }
+
+    if (x == polygon->numVertices)
+        return;
+
     // Clip at left clipping plane (xMin)
     PRint localNumVerts = 0;
 
-    for (x = _numPolyVerts - 1, y = 0; y < _numPolyVerts; x = y, ++y)
+    for (x = polygon->numVertices - 1, y = 0; y < polygon->numVertices; x = y, ++y)
     {
         // Inside
-        if (_rasterVertices[x].x >= xMin && _rasterVertices[y].x >= xMin)
-            _rasterVerticesTmp[localNumVerts++] = _rasterVertices[y];
+        if (verts[x].x >= xMin && verts[y].x >= xMin)
+            vertsTmp[localNumVerts++] = verts[y];
 
         // Leaving
-        if (_rasterVertices[x].x >= xMin && _rasterVertices[y].x < xMin)
-            _rasterVerticesTmp[localNumVerts++] = _get_xplane_vertex(_rasterVertices[x], _rasterVertices[y], xMin);
+        if (verts[x].x >= xMin && verts[y].x < xMin)
+            vertsTmp[localNumVerts++] = _get_xplane_vertex(verts[x], verts[y], xMin);
 
         // Entering
-        if (_rasterVertices[x].x < xMin && _rasterVertices[y].x >= xMin)
+        if (verts[x].x < xMin && verts[y].x >= xMin)
         {
-            _rasterVerticesTmp[localNumVerts++] = _get_xplane_vertex(_rasterVertices[x], _rasterVertices[y], xMin);
-            _rasterVerticesTmp[localNumVerts++] = _rasterVertices[y];
+            vertsTmp[localNumVerts++] = _get_xplane_vertex(verts[x], verts[y], xMin);
+            vertsTmp[localNumVerts++] = verts[y];
         }
     }
 
     // Clip at right clipping plane (xMax)
-    _numPolyVerts = 0;
+    polygon->numVertices = 0;
 
     for (x = localNumVerts - 1, y = 0; y < localNumVerts; x = y, ++y)
     {
         // Inside
-        if (_rasterVerticesTmp[x].x <= xMax && _rasterVerticesTmp[y].x <= xMax)
-            _rasterVertices[_numPolyVerts++] = _rasterVerticesTmp[y];
+        if (vertsTmp[x].x <= xMax && vertsTmp[y].x <= xMax)
+            verts[polygon->numVertices++] = vertsTmp[y];
 
         // Leaving
-        if (_rasterVerticesTmp[x].x <= xMax && _rasterVerticesTmp[y].x > xMax)
-            _rasterVertices[_numPolyVerts++] = _get_xplane_vertex(_rasterVerticesTmp[x], _rasterVerticesTmp[y], xMax);
+        if (vertsTmp[x].x <= xMax && vertsTmp[y].x > xMax)
+            verts[polygon->numVertices++] = _get_xplane_vertex(vertsTmp[x], vertsTmp[y], xMax);
 
         // Entering
-        if (_rasterVerticesTmp[x].x > xMax && _rasterVerticesTmp[y].x <= xMax)
+        if (vertsTmp[x].x > xMax && vertsTmp[y].x <= xMax)
         {
-            _rasterVertices[_numPolyVerts++] = _get_xplane_vertex(_rasterVerticesTmp[x], _rasterVerticesTmp[y], xMax);
-            _rasterVertices[_numPolyVerts++] = _rasterVerticesTmp[y];
+            verts[polygon->numVertices++] = _get_xplane_vertex(vertsTmp[x], vertsTmp[y], xMax);
+            verts[polygon->numVertices++] = vertsTmp[y];
         }
     }
 
     // Clip at top clipping plane (yMin)
     localNumVerts = 0;
 
-    for (x = _numPolyVerts - 1, y = 0; y < _numPolyVerts; x = y, ++y)
+    for (x = polygon->numVertices - 1, y = 0; y < polygon->numVertices; x = y, ++y)
     {
         // Inside
-        if (_rasterVertices[x].y >= yMin && _rasterVertices[y].y >= yMin)
-            _rasterVerticesTmp[localNumVerts++] = _rasterVertices[y];
+        if (verts[x].y >= yMin && verts[y].y >= yMin)
+            vertsTmp[localNumVerts++] = verts[y];
 
         // Leaving
-        if (_rasterVertices[x].y >= yMin && _rasterVertices[y].y < yMin)
-            _rasterVerticesTmp[localNumVerts++] = _get_yplane_vertex(_rasterVertices[x], _rasterVertices[y], yMin);
+        if (verts[x].y >= yMin && verts[y].y < yMin)
+            vertsTmp[localNumVerts++] = _get_yplane_vertex(verts[x], verts[y], yMin);
 
         // Entering
-        if (_rasterVertices[x].y < yMin && _rasterVertices[y].y >= yMin)
+        if (verts[x].y < yMin && verts[y].y >= yMin)
         {
-            _rasterVerticesTmp[localNumVerts++] = _get_yplane_vertex(_rasterVertices[x], _rasterVertices[y], yMin);
-            _rasterVerticesTmp[localNumVerts++] = _rasterVertices[y];
+            vertsTmp[localNumVerts++] = _get_yplane_vertex(verts[x], verts[y], yMin);
+            vertsTmp[localNumVerts++] = verts[y];
         }
     }
 
     // Clip at bottom clipping plane (yMax)
-    _numPolyVerts = 0;
+    polygon->numVertices = 0;
 
     for (x = localNumVerts - 1, y = 0; y < localNumVerts; x = y, ++y)
     {
         // Inside
-        if (_rasterVerticesTmp[x].y <= yMax && _rasterVerticesTmp[y].y <= yMax)
-            _rasterVertices[_numPolyVerts++] = _rasterVerticesTmp[y];
+        if (vertsTmp[x].y <= yMax && vertsTmp[y].y <= yMax)
+            verts[polygon->numVertices++] = vertsTmp[y];
 
         // Leaving
-        if (_rasterVerticesTmp[x].y <= yMax && _rasterVerticesTmp[y].y > yMax)
-            _rasterVertices[_numPolyVerts++] = _get_yplane_vertex(_rasterVerticesTmp[x], _rasterVerticesTmp[y], yMax);
+        if (vertsTmp[x].y <= yMax && vertsTmp[y].y > yMax)
+            verts[polygon->numVertices++] = _get_yplane_vertex(vertsTmp[x], vertsTmp[y], yMax);
 
         // Entering
-        if (_rasterVerticesTmp[x].y > yMax && _rasterVerticesTmp[y].y <= yMax)
+        if (vertsTmp[x].y > yMax && vertsTmp[y].y <= yMax)
         {
-            _rasterVertices[_numPolyVerts++] = _get_yplane_vertex(_rasterVerticesTmp[x], _rasterVerticesTmp[y], yMax);
-            _rasterVertices[_numPolyVerts++] = _rasterVerticesTmp[y];
-        }
-    }
-}
-
-static void _index_inc(PRint* x, PRint numVertices)
-{
-    ++(*x);
-    if (*x >= numVertices)
-        *x = 0;
-}
-
-static void _index_dec(PRint* x, PRint numVertices)
-{
-    --(*x);
-    if (*x < 0)
-        *x = numVertices - 1;
-}
-
-// Rasterizes convex polygon filled
-static void _rasterize_polygon_fill(pr_framebuffer* frameBuffer, const pr_texture* texture, PRubyte mipLevel)
-{
-    // Select MIP level
-    PRtexsize mipWidth = 0, mipHeight = 0;
-    const PRcolorindex* texels = _pr_texture_select_miplevel(texture, mipLevel, &mipWidth, &mipHeight);
-
-    // Find left- and right sided polygon edges
-    PRint x, y, top = 0, bottom = 0;
-
-    for (x = 1; x < _numPolyVerts; ++x)
-    {
-        if (_rasterVertices[top].y > _rasterVertices[x].y)
-            top = x;
-        if (_rasterVertices[bottom].y < _rasterVertices[x].y)
-            bottom = x;
-    }
-
-    // Setup raster scanline sides
-    pr_scaline_side* leftSide = frameBuffer->scanlinesStart;
-    pr_scaline_side* rightSide = frameBuffer->scanlinesEnd;
-
-    x = y = top;
-    for (_index_dec(&y, _numPolyVerts); x != bottom; x = y, _index_dec(&y, _numPolyVerts))
-        _pr_framebuffer_setup_scanlines(frameBuffer, leftSide, _rasterVertices[x], _rasterVertices[y]);
-
-    x = y = top;
-    for (_index_inc(&y, _numPolyVerts); x != bottom; x = y, _index_inc(&y, _numPolyVerts))
-        _pr_framebuffer_setup_scanlines(frameBuffer, rightSide, _rasterVertices[x], _rasterVertices[y]);
-
-    // Check if sides must be swaped
-    long midIndex = (_rasterVertices[bottom].y + _rasterVertices[top].y) / 2;
-    if (frameBuffer->scanlinesStart[midIndex].offset > frameBuffer->scanlinesEnd[midIndex].offset)
-        PR_SWAP(pr_scaline_side*, leftSide, rightSide);
-
-    // Start rasterizing the polygon
-    PRint len, offset;
-    PRinterp z, zAct, zStep;
-    PRinterp u, uAct, uStep;
-    PRinterp v, vAct, vStep;
-
-    PRint yStart = _rasterVertices[top].y;
-    PRint yEnd = _rasterVertices[bottom].y;
-
-    pr_pixel* pixel;
-
-    // Rasterize each scanline
-    for (y = yStart; y <= yEnd; ++y)
-    {
-        len = rightSide[y].offset - leftSide[y].offset;
-        if (len <= 0)
-            continue;
-
-        zStep = (rightSide[y].z - leftSide[y].z) / len;
-        uStep = (rightSide[y].u - leftSide[y].u) / len;
-        vStep = (rightSide[y].v - leftSide[y].v) / len;
-
-        offset = leftSide[y].offset;
-        zAct = leftSide[y].z;
-        uAct = leftSide[y].u;
-        vAct = leftSide[y].v;
-
-        // Rasterize current scanline
-        while (len-- >= 0)
-        {
-            // Fetch pixel from framebuffer
-            pixel = &(frameBuffer->pixels[offset]);
-
-            // Make depth test
-            PRdepthtype depth = _pr_pixel_write_depth(zAct);
-
-            if (depth > pixel->depth)
-            {
-                pixel->depth = depth;
-
-                #ifdef PR_PERSPECTIVE_CORRECTED
-                // Compute perspective corrected texture coordinates
-                z = PR_FLOAT(1.0) / zAct;
-                u = uAct * z;
-                v = vAct * z;
-                #else
-                z = zAct;
-                u = uAct;
-                v = vAct;
-                #endif
-
-                // Sample texture
-                pixel->colorIndex = _pr_texture_sample_nearest_from_mipmap(texels, mipWidth, mipHeight, (PRfloat)u, (PRfloat)v);
-                //pixel->colorIndex = _pr_texture_sample_nearest(texture, u, v, uStep*z, vStep*z);
-                //pixel->colorIndex = (PRubyte)(zAct * (PRfloat)UCHAR_MAX);
-            }
-
-            // Next pixel
-            ++offset;
-            zAct += zStep;
-            uAct += uStep;
-            vAct += vStep;
+            verts[polygon->numVertices++] = _get_yplane_vertex(vertsTmp[x], vertsTmp[y], yMax);
+            verts[polygon->numVertices++] = vertsTmp[y];
         }
     }
 }
 
 // Rasterizes convex polygon outlines
-static void _rasterize_polygon_line(pr_framebuffer* frameBuffer, const pr_texture* texture, PRubyte mipLevel)
+static void _rasterize_polygon_line(pr_framebuffer* frameBuffer, const pr_texture* texture, PRubyte mipLevel, const pr_polygon* polygon)
 {
-    for (PRint i = 0; i + 1 < _numPolyVerts; ++i)
-        _rasterize_line(frameBuffer, texture, mipLevel, i, i + 1);
-    _rasterize_line(frameBuffer, texture, mipLevel, _numPolyVerts - 1, 0);
+    const pr_raster_vertex* verts = polygon->rasterVertices;
+
+    for (PRint i = 0; i + 1 < polygon->numVertices; ++i)
+        _rasterize_line(frameBuffer, texture, mipLevel, &(verts[i]), &(verts[i + 1]));
+    _rasterize_line(frameBuffer, texture, mipLevel, &(verts[polygon->numVertices - 1]), &(verts[0]));
 }
 
 // Rasterizes convex polygon points
-static void _rasterize_polygon_point(
-    pr_framebuffer* frameBuffer, const pr_texture* texture, PRubyte mipLevel)
+static void _rasterize_polygon_point(pr_framebuffer* frameBuffer, const pr_polygon* polygon)
 {
-    for (PRint i = 0; i < _numPolyVerts; ++i)
+    for (PRint i = 0; i < polygon->numVertices; ++i)
     {
         _pr_framebuffer_plot(
             frameBuffer,
-            _rasterVertices[i].x,
-            _rasterVertices[i].y,
+            PR_RASTER_TO_PIXEL(polygon->rasterVertices[i].x),
+            PR_RASTER_TO_PIXEL(polygon->rasterVertices[i].y),
             PR_STATE_MACHINE.color0
         );
     }
 }
 
-static void _rasterize_polygon(pr_framebuffer* frameBuffer, const pr_texture* texture, PRubyte mipLevel)
+static void _rasterize_polygon(pr_framebuffer* frameBuffer, const pr_texture* texture, PRubyte mipLevel, const pr_polygon* polygon)
 {
     // Rasterize polygon with selected MIP level
     switch (PR_STATE_MACHINE.polygonMode)
     {
         case PR_POLYGON_FILL:
-            _rasterize_polygon_fill(frameBuffer, texture, mipLevel);
+            // Defer filled polygons to the tile rasterizer
+            _pr_tile_binner_add_polygon(&PR_TILE_BINNER, polygon->rasterVertices, polygon->numVertices, texture, mipLevel);
             break;
         case PR_POLYGON_LINE:
-            _rasterize_polygon_line(frameBuffer, texture, mipLevel);
+            _rasterize_polygon_line(frameBuffer, texture, mipLevel, polygon);
             break;
         case PR_POLYGON_POINT:
-            _rasterize_polygon_point(frameBuffer, texture, mipLevel);
+            _rasterize_polygon_point(frameBuffer, polygon);
             break;
     }
 }
 
-static PRboolean _clip_and_project_polygon(PRint numVertices)
+// Returns the guard band planes in normalized device coordinates (the viewport height is negative for a flipped origin)
+static pr_vector2 _get_guard_band(const pr_viewport* viewport)
 {
-    // Get clipping rectangle
-    const PRint xMin = PR_STATE_MACHINE.clipRect.left;
-    const PRint xMax = PR_STATE_MACHINE.clipRect.right;
-    const PRint yMin = PR_STATE_MACHINE.clipRect.top;
-    const PRint yMax = PR_STATE_MACHINE.clipRect.bottom;
-
-    // Z clipping
-    _numPolyVerts = numVertices;
-    _polygon_z_clipping(1.0f, 100.0f);//!!!
-    //_polygon_z_clipping(0.01f, 100.0f);//!!!
-    
-    if (_numPolyVerts < 3)
-        return PR_FALSE;
+    pr_vector2 guardBand;
+    guardBand.x = 1.0f + (PRfloat)PR_GUARD_BAND / PR_ABS(viewport->halfWidth);
+    guardBand.y = 1.0f + (PRfloat)PR_GUARD_BAND / PR_ABS(viewport->halfHeight);
+    return guardBand;
+}
+
+// Copies the entry 'i' of the vertex stream into the polygon vertex 'j' and returns its outcode
+static PRuint _fetch_stream_vertex(pr_polygon* polygon, PRint j, const pr_vertex_stream* stream, PRsizei i)
+{
+    pr_clip_vertex* clipVert = &(polygon->clipVertices[j]);
+
+    clipVert->x = stream->x[i];
+    clipVert->y = stream->y[i];
+    clipVert->z = stream->z[i];
+    clipVert->w = stream->w[i];
+    clipVert->u = stream->u[i];
+    clipVert->v = stream->v[i];
+
+    polygon->rhw[j] = stream->rhw[i];
+
+    return stream->outcodes[i];
+}
+
+// Copies the entry 'i' of the vertex cache into the polygon vertex 'j' and returns its outcode
+static PRuint _fetch_cache_vertex(pr_polygon* polygon, PRint j, const pr_vertex_cache* vertexCache, PRuint i)
+{
+    polygon->clipVertices[j] = vertexCache->vertices[i];
+    polygon->rhw[j] = vertexCache->rhw[i];
+    return vertexCache->outcodes[i];
+}
+
+/*
+Clips, projects and culls the polygon, whose clip vertices and reciprocal W coordinates are already set.
+The polygon must not be trivially rejected, i.e. its vertices must not be outside of the same frustum plane.
+*/
+static PRboolean _clip_and_project_polygon(pr_polygon* polygon, PRint numVertices, PRuint outcodesOr, const pr_vector2* guardBand)
+{
+    const pr_viewport* viewport = &(PR_STATE_MACHINE.viewport);
+
+    // Clip only at the near, far and guard band planes which are crossed by any vertex
+    polygon->numVertices = numVertices;
+
+    if ((outcodesOr & PR_CLIP_PLANES) != 0)
+    {
+        _polygon_clip_space_clipping(polygon, outcodesOr, guardBand);
+        if (polygon->numVertices < 3)
+            return PR_FALSE;
+
+        for (PRint j = 0; j < polygon->numVertices; ++j)
+            polygon->rhw[j] = 1.0f / polygon->clipVertices[j].w;
+    }
 
     // Projection
-    for (PRint j = 0; j < _numPolyVerts; ++j)
-        _project_vertex(&(_clipVertices[j]), &(PR_STATE_MACHINE.viewport));
+    for (PRint j = 0; j < polygon->numVertices; ++j)
+        _project_vertex(&(polygon->clipVertices[j]), polygon->rhw[j], viewport);
 
     // Make culling test
-    if (_is_triangle_culled(_CVERT_VEC2(0), _CVERT_VEC2(1), _CVERT_VEC2(2)))
+    if (_is_triangle_culled(_CVERT_VEC2(polygon, 0), _CVERT_VEC2(polygon, 1), _CVERT_VEC2(polygon, 2)))
         return PR_FALSE;
 
     // Setup raster vertices
-    for (PRint j = 0; j < _numPolyVerts; ++j)
-        _setup_raster_vertex(&(_rasterVertices[j]), &(_clipVertices[j]));
+    for (PRint j = 0; j < polygon->numVertices; ++j)
+        _setup_raster_vertex(&(polygon->rasterVertices[j]), &(polygon->clipVertices[j]));
 
-    // Edge clipping
-    _polygon_xy_clipping(xMin, xMax, yMin, yMax);
+    // Filled polygons are clamped to the clipping rectangle by the tile rasterizer, only outlines and points are clipped here
+    if (PR_STATE_MACHINE.polygonMode != PR_POLYGON_FILL)
+    {
+        _polygon_xy_clipping(
+            polygon,
+            PR_RASTER_FROM_PIXEL(PR_STATE_MACHINE.clipRect.left),
+            PR_RASTER_FROM_PIXEL(PR_STATE_MACHINE.clipRect.right),
+            PR_RASTER_FROM_PIXEL(PR_STATE_MACHINE.clipRect.top),
+            PR_RASTER_FROM_PIXEL(PR_STATE_MACHINE.clipRect.bottom)
+        );
 
-    if (_numPolyVerts < 3)
-        return PR_FALSE;
+        if (polygon->numVertices < 3)
+            return PR_FALSE;
+    }
 
     return PR_TRUE;
 }
 
-static PRubyte _compute_polygon_miplevel(const pr_texture* texture)
+static PRubyte _compute_polygon_miplevel(const pr_texture* texture, const pr_polygon* polygon)
 {
-    if (PR_STATE_MACHINE.states[PR_MIP_MAPPING] != PR_FALSE && texture->mips > 0)
+    if (texture != NULL && PR_STATE_MACHINE.states[PR_MIP_MAPPING] != PR_FALSE && texture->mips > 0)
     {
         // Find closest vertex
-        PRinterp zMin = _rasterVertices[0].z;
-        for (PRint i = 1; i < _numPolyVerts; ++i)
+        PRinterp zMin = polygon->rasterVertices[0].z;
+        for (PRint i = 1; i < polygon->numVertices; ++i)
         {
-            if (zMin > _rasterVertices[i].z)
-                zMin = _rasterVertices[i].z;
+            if (zMin > polygon->rasterVertices[i].z)
+                zMin = polygon->rasterVertices[i].z;
         }
 
         // Derive mip level from z value
-        zMin = 0.25f / zMin;
-        PRint zLog = _int_log2((PRfloat)zMin);
+        PRfloat zInv = 0.25f / PR_INTERP_TO_FLOAT(zMin);
+        PRint zLog = _int_log2(zInv);
 
         return PR_CLAMP(zLog, 0, texture->mips - 1);
     }
     return 0;
 }
 
+// Starts binning the filled polygons of a draw call with the current render states (texture is null for untextured polygons)
+static void _tile_binner_begin(pr_framebuffer* frameBuffer, const pr_texture* texture)
+{
+    pr_raster_state state;
+
+    state.rasterizerMode    = PR_STATE_MACHINE.rasterizerMode;
+    state.subspanLength     = PR_STATE_MACHINE.textureSubspanLength;
+    state.depthTest         = PR_STATE_MACHINE.states[PR_DEPTH_TEST];
+    state.depthWrite        = (state.depthTest && PR_STATE_MACHINE.depthMask);
+    state.color             = PR_STATE_MACHINE.color0;
+    state.mipMapping        = (texture != NULL && PR_STATE_MACHINE.colorMask && PR_STATE_MACHINE.states[PR_MIP_MAPPING] != PR_FALSE && PR_TEXTURE_HAS_MIPS(texture));
+
+    // Select the span kernel only once for all polygons, so that the span loops contain no state branches
+    PRbitfield kernelFlags = 0;
+
+    if (PR_STATE_MACHINE.colorMask)
+        kernelFlags |= PR_SPAN_COLOR_WRITE;
+    if (state.depthTest)
+        kernelFlags |= PR_SPAN_DEPTH_TEST;
+    if (state.depthWrite)
+        kernelFlags |= PR_SPAN_DEPTH_WRITE;
+    if (PR_STATE_MACHINE.depthFunc == PR_DEPTH_GEQUAL)
+        kernelFlags |= PR_SPAN_DEPTH_GEQUAL;
+    if (PR_STATE_MACHINE.textureSubspanLength > 0)
+        kernelFlags |= PR_SPAN_SUBSPAN;
+    if (texture == NULL)
+        kernelFlags |= PR_SPAN_FLAT;
+    else if (PR_STATE_MACHINE.textureFilter == PR_LINEAR)
+        kernelFlags |= PR_SPAN_TEXTURE_LINEAR;
+    else if (texture->powerOfTwo)
+        kernelFlags |= PR_SPAN_TEXTURE_POT;
+    if (frameBuffer->depthFormat == PR_DEPTH_COMPONENT32F)
+        kernelFlags |= PR_SPAN_DEPTH_FLOAT;
+
+    state.spanKernel        = _pr_span_kernel_select(kernelFlags);
+
+    // Outlines and points of polygons are written directly, i.e. not per tile
+    if (PR_STATE_MACHINE.polygonMode != PR_POLYGON_FILL)
+        _pr_framebuffer_resolve(frameBuffer);
+
+    _pr_tile_binner_begin(&PR_TILE_BINNER, frameBuffer, &(PR_STATE_MACHINE.clipRect), &state);
+}
+
 static void _render_triangles(
     const pr_texture* texture, PRsizei numVertices, PRsizei firstVertex, const pr_vertexbuffer* vertexBuffer)
 {
     // Get clipping dimensions
     pr_framebuffer* frameBuffer = PR_STATE_MACHINE.boundFrameBuffer;
+    pr_polygon polygon;
 
-    // Iterate over the index buffer
-    for (PRsizei i = firstVertex, n = numVertices + firstVertex; i + 2 < n; i += 3)
+    // Transform all vertices in a single batch
+    pr_vertex_stream* stream = &PR_VERTEX_STREAM;
+    const pr_vector2 guardBand = _get_guard_band(&(PR_STATE_MACHINE.viewport));
+
+    _pr_vertexbuffer_transform_stream(
+        stream, numVertices, firstVertex, vertexBuffer, &(PR_STATE_MACHINE.worldViewProjectionMatrix), &guardBand
+    );
+
+    _tile_binner_begin(frameBuffer, texture);
+
+    // Iterate over the transformed vertices
+    for (PRsizei i = 0; i + 2 < numVertices; i += 3)
     {
-        // Fetch vertices
-        const pr_vertex* vertexA = (vertexBuffer->vertices + i);
-        const pr_vertex* vertexB = (vertexBuffer->vertices + (i + 1));
-        const pr_vertex* vertexC = (vertexBuffer->vertices + (i + 2));
+        // Drop polygon if all vertices are outside of the same frustum plane (trivial reject)
+        const PRuint* outcodes = stream->outcodes + i;
+
+        if ((outcodes[0] & outcodes[1] & outcodes[2] & PR_CLIP_FRUSTUM) != 0)
+            continue;
 
         // Setup polygon
-        _transform_vertex(&(_clipVertices[0]), vertexA);
-        _transform_vertex(&(_clipVertices[1]), vertexB);
-        _transform_vertex(&(_clipVertices[2]), vertexC);
+        _fetch_stream_vertex(&polygon, 0, stream, i);
+        _fetch_stream_vertex(&polygon, 1, stream, i + 1);
+        _fetch_stream_vertex(&polygon, 2, stream, i + 2);
 
-        if (_clip_and_project_polygon(3) != PR_FALSE)
+        if (_clip_and_project_polygon(&polygon, 3, outcodes[0] | outcodes[1] | outcodes[2], &guardBand) != PR_FALSE)
         {
             // Rasterize active polygon
-            _rasterize_polygon(frameBuffer, texture, _compute_polygon_miplevel(texture));
+            _rasterize_polygon(frameBuffer, texture, _compute_polygon_miplevel(texture, &polygon), &polygon);
         }
     }
+
+    // Rasterize all binned polygons
+    _pr_tile_binner_flush(&PR_TILE_BINNER, PR_THREAD_POOL);
 }
 
 void _pr_render_triangles(PRsizei numVertices, PRsizei firstVertex, const pr_vertexbuffer* vertexBuffer)
@@ -1049,14 +1137,12 @@ void _pr_render_triangles(PRsizei numVertices, PRsizei firstVertex, const pr_ver
         return;
     }
 
-    pr_texture* texture = PR_STATE_MACHINE.boundTexture;
-    if (texture == NULL || texture->texels == NULL)
-    {
-        _pr_texture_singular_color(&PR_SINGULAR_TEXTURE, PR_STATE_MACHINE.color0);
-        _render_triangles(&PR_SINGULAR_TEXTURE, numVertices, firstVertex, vertexBuffer);
-    }
-    else
-        _render_triangles(texture, numVertices, firstVertex, vertexBuffer);
+    // Untextured polygons are rendered with the active color
+    const pr_texture* texture = _bound_texture();
+    if (texture != NULL && texture->texels == NULL)
+        texture = NULL;
+
+    _render_triangles(texture, numVertices, firstVertex, vertexBuffer);
 }
 
 void _pr_render_triangle_strip(PRsizei numVertices, PRsizei firstVertex, const pr_vertexbuffer* vertexBuffer)
@@ -1069,46 +1155,125 @@ void _pr_render_triangle_fan(PRsizei numVertices, PRsizei firstVertex, const pr_
     //...
 }
 
-static void _render_indexed_triangles(
-    const pr_texture* texture, PRsizei numVertices, PRsizei firstVertex, const pr_vertexbuffer* vertexBuffer, const pr_indexbuffer* indexBuffer)
+// Renders the indexed triangles with the vertices [minIndex, maxIndex], which are transformed in a single batch
+static void _render_indexed_triangles_batch(
+    pr_framebuffer* frameBuffer, const pr_texture* texture, PRsizei numVertices, PRsizei firstVertex,
+    const pr_vertexbuffer* vertexBuffer, const pr_indexbuffer* indexBuffer, PRuint minIndex, PRuint maxIndex)
 {
-    // Get clipping dimensions
-    pr_framebuffer* frameBuffer = PR_STATE_MACHINE.boundFrameBuffer;
+    pr_polygon polygon;
+
+    pr_vertex_stream* stream = &PR_VERTEX_STREAM;
+    const pr_vector2 guardBand = _get_guard_band(&(PR_STATE_MACHINE.viewport));
+
+    _pr_vertexbuffer_transform_stream(
+        stream, (PRsizei)(maxIndex - minIndex + 1), (PRsizei)minIndex, vertexBuffer,
+        &(PR_STATE_MACHINE.worldViewProjectionMatrix), &guardBand
+    );
 
     // Iterate over the index buffer
     for (PRsizei i = firstVertex, n = numVertices + firstVertex; i + 2 < n; i += 3)
     {
-        // Fetch indices
-        PRushort indexA = indexBuffer->indices[i];
-        PRushort indexB = indexBuffer->indices[i + 1];
-        PRushort indexC = indexBuffer->indices[i + 2];
+        // Fetch indices (relative to the first transformed vertex)
+        PRuint indexA = indexBuffer->indices[i] - minIndex;
+        PRuint indexB = indexBuffer->indices[i + 1] - minIndex;
+        PRuint indexC = indexBuffer->indices[i + 2] - minIndex;
 
-        #ifdef PR_DEBUG
-        if (indexA >= vertexBuffer->numVertices || indexB >= vertexBuffer->numVertices || indexC >= vertexBuffer->numVertices)
+        // Drop polygon if all vertices are outside of the same frustum plane (trivial reject)
+        const PRuint outcodeA = stream->outcodes[indexA];
+        const PRuint outcodeB = stream->outcodes[indexB];
+        const PRuint outcodeC = stream->outcodes[indexC];
+
+        if ((outcodeA & outcodeB & outcodeC & PR_CLIP_FRUSTUM) != 0)
+            continue;
+
+        // Setup polygon
+        _fetch_stream_vertex(&polygon, 0, stream, indexA);
+        _fetch_stream_vertex(&polygon, 1, stream, indexB);
+        _fetch_stream_vertex(&polygon, 2, stream, indexC);
+
+        if (_clip_and_project_polygon(&polygon, 3, outcodeA | outcodeB | outcodeC, &guardBand) != PR_FALSE)
         {
-            PR_SET_ERROR_FATAL("element in index buffer out of bounds");
-            return;
+            // Rasterize active polygon
+            _rasterize_polygon(frameBuffer, texture, _compute_polygon_miplevel(texture, &polygon), &polygon);
         }
-        #endif
+    }
+}
 
-        // Fetch vertices
-        const pr_vertex* vertexA = (vertexBuffer->vertices + indexA);
-        const pr_vertex* vertexB = (vertexBuffer->vertices + indexB);
-        const pr_vertex* vertexC = (vertexBuffer->vertices + indexC);
+// Renders the indexed triangles with vertices which are transformed on demand by the post-transform vertex cache
+static void _render_indexed_triangles_cached(
+    pr_framebuffer* frameBuffer, const pr_texture* texture, PRsizei numVertices, PRsizei firstVertex,
+    const pr_vertexbuffer* vertexBuffer, const pr_indexbuffer* indexBuffer)
+{
+    pr_polygon polygon;
+
+    // Transformed vertices are only valid for this draw call
+    pr_vertex_cache* vertexCache = &PR_VERTEX_CACHE;
+    const pr_matrix4* worldViewProjectionMatrix = &(PR_STATE_MACHINE.worldViewProjectionMatrix);
+    const pr_vector2 guardBand = _get_guard_band(&(PR_STATE_MACHINE.viewport));
+
+    _pr_vertex_cache_invalidate(vertexCache);
+
+    // Iterate over the index buffer
+    for (PRsizei i = firstVertex, n = numVertices + firstVertex; i + 2 < n; i += 3)
+    {
+        // Fetch cache entries (shared vertices are only transformed once)
+        PRuint entryA = _pr_vertex_cache_fetch(vertexCache, vertexBuffer, indexBuffer->indices[i], worldViewProjectionMatrix, &guardBand);
+        PRuint entryB = _pr_vertex_cache_fetch(vertexCache, vertexBuffer, indexBuffer->indices[i + 1], worldViewProjectionMatrix, &guardBand);
+        PRuint entryC = _pr_vertex_cache_fetch(vertexCache, vertexBuffer, indexBuffer->indices[i + 2], worldViewProjectionMatrix, &guardBand);
 
         // Setup polygon
-        _transform_vertex(&(_clipVertices[0]), vertexA);
-        _transform_vertex(&(_clipVertices[1]), vertexB);
-        _transform_vertex(&(_clipVertices[2]), vertexC);
+        const PRuint outcodeA = _fetch_cache_vertex(&polygon, 0, vertexCache, entryA);
+        const PRuint outcodeB = _fetch_cache_vertex(&polygon, 1, vertexCache, entryB);
+        const PRuint outcodeC = _fetch_cache_vertex(&polygon, 2, vertexCache, entryC);
 
-        if (_clip_and_project_polygon(3) != PR_FALSE)
+        // Drop polygon if all vertices are outside of the same frustum plane (trivial reject)
+        if ((outcodeA & outcodeB & outcodeC & PR_CLIP_FRUSTUM) != 0)
+            continue;
+
+        if (_clip_and_project_polygon(&polygon, 3, outcodeA | outcodeB | outcodeC, &guardBand) != PR_FALSE)
         {
             // Rasterize active polygon
-            _rasterize_polygon(frameBuffer, texture, _compute_polygon_miplevel(texture));
+            _rasterize_polygon(frameBuffer, texture, _compute_polygon_miplevel(texture, &polygon), &polygon);
         }
     }
 }
 
+static void _render_indexed_triangles(
+    const pr_texture* texture, PRsizei numVertices, PRsizei firstVertex, const pr_vertexbuffer* vertexBuffer, const pr_indexbuffer* indexBuffer)
+{
+    // Get clipping dimensions
+    pr_framebuffer* frameBuffer = PR_STATE_MACHINE.boundFrameBuffer;
+
+    // Get range of referenced vertices
+    PRuint minIndex = ~0u, maxIndex = 0;
+
+    for (PRsizei i = firstVertex, n = numVertices + firstVertex; i < n; ++i)
+    {
+        PR_CLAMP_SMALLEST(minIndex, indexBuffer->indices[i]);
+        PR_CLAMP_LARGEST(maxIndex, indexBuffer->indices[i]);
+    }
+
+    if (minIndex > maxIndex)
+        return;
+
+    if (maxIndex >= (PRuint)vertexBuffer->numVertices)
+    {
+        PR_SET_ERROR_FATAL("element in index buffer out of bounds");
+        return;
+    }
+
+    _tile_binner_begin(frameBuffer, texture);
+
+    // Transform the whole range in a batch if it is dense, i.e. most of its vertices are referenced
+    if (maxIndex - minIndex < (PRuint)numVertices)
+        _render_indexed_triangles_batch(frameBuffer, texture, numVertices, firstVertex, vertexBuffer, indexBuffer, minIndex, maxIndex);
+    else
+        _render_indexed_triangles_cached(frameBuffer, texture, numVertices, firstVertex, vertexBuffer, indexBuffer);
+
+    // Rasterize all binned polygons
+    _pr_tile_binner_flush(&PR_TILE_BINNER, PR_THREAD_POOL);
+}
+
 void _pr_render_indexed_triangles(PRsizei numVertices, PRsizei firstVertex, const pr_vertexbuffer* vertexBuffer, const pr_indexbuffer* indexBuffer)
 {
     if (PR_STATE_MACHINE.boundFrameBuffer == NULL)
@@ -1127,13 +1292,12 @@ void _pr_render_indexed_triangles(PRsizei numVertices, PRsizei firstVertex, cons
         return;
     }
 
-    if (PR_STATE_MACHINE.boundTexture == NULL)
-    {
-        _pr_texture_singular_color(&PR_SINGULAR_TEXTURE, PR_STATE_MACHINE.color0);
-        _render_indexed_triangles(&PR_SINGULAR_TEXTURE, numVertices, firstVertex, vertexBuffer, indexBuffer);
-    }
-    else
-        _render_indexed_triangles(PR_STATE_MACHINE.boundTexture, numVertices, firstVertex, vertexBuffer, indexBuffer);
+    // Untextured polygons are rendered with the active color
+    const pr_texture* texture = _bound_texture();
+    if (texture != NULL && texture->texels == NULL)
+        texture = NULL;
+
+    _render_indexed_triangles(texture, numVertices, firstVertex, vertexBuffer, indexBuffer);
 }
 
 void _pr_render_indexed_triangle_strip(PRsizei numVertices, PRsizei firstVertex, const pr_vertexbuffer* vertexBuffer, const pr_indexbuffer* indexBuffer)
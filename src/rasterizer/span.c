@@ -0,0 +1,669 @@
+/*
+ * span.c
+ *
+ * This file is part of the "PicoRenderer" (Copyright (c) 2014 by Lukas Hermanns)
+ * See "LICENSE.txt" for license information.
+ */
+
+#include "span.h"
+#include "ext_math.h"
+
+#include <string.h>
+
+// SIMD kernels require the default buffer formats (8-bit color indices and 16-bit depths)
+#if !defined(PR_COLOR_BUFFER_24BIT) && !defined(PR_DEPTH_BUFFER_8BIT)
+#   if defined(PR_SIMD_AVX2)
+#       include <immintrin.h>
+#       define _SPAN_AVX2
+#   elif defined(PR_SIMD_SSE2)
+#       include <emmintrin.h>
+#       define _SPAN_SSE2
+#   endif
+#endif
+
+
+// --- internals --- //
+
+// Samples the texel at the interpolated texture coordinates (perspective corrected if PR_PERSPECTIVE_CORRECTED is defined).
+PR_INLINE PRcolorindex _span_sample_texel(
+    PRinterp zAct, PRinterp uAct, PRinterp vAct, const PRcolorindex* texels, PRtexsize mipWidth, PRtexsize mipHeight, pr_texture_sampler sampler)
+{
+    #if defined(PR_PERSPECTIVE_CORRECTED) && defined(PR_FIXED_POINT)
+    // Compute perspective corrected texture coordinates (the fixed-point scale cancels out)
+    PRfloat z = 1.0f / (PRfloat)zAct;
+    PRfloat u = (PRfloat)uAct * z;
+    PRfloat v = (PRfloat)vAct * z;
+    #elif defined(PR_PERSPECTIVE_CORRECTED)
+    // Compute perspective corrected texture coordinates
+    PRinterp z = PR_FLOAT(1.0) / zAct;
+    PRinterp u = uAct * z;
+    PRinterp v = vAct * z;
+    #else
+    PRfloat u = PR_INTERP_TO_FLOAT(uAct);
+    PRfloat v = PR_INTERP_TO_FLOAT(vAct);
+    #endif
+
+    return sampler(texels, mipWidth, mipHeight, (PRfloat)u, (PRfloat)v);
+}
+
+#ifdef PR_PERSPECTIVE_CORRECTED
+
+// Computes the exact perspective corrected texture coordinates at the specified pixel of the span.
+PR_INLINE void _span_texcoord_at(const pr_span* span, PRint i, PRfloat* u, PRfloat* v)
+{
+    #ifdef PR_FIXED_POINT
+    PRfloat z = 1.0f / (PRfloat)(span->z + span->zStep * i);
+    *u = (PRfloat)(span->u + span->uStep * i) * z;
+    *v = (PRfloat)(span->v + span->vStep * i) * z;
+    #else
+    PRinterp z = PR_FLOAT(1.0) / (span->z + span->zStep * i);
+    *u = (PRfloat)((span->u + span->uStep * i) * z);
+    *v = (PRfloat)((span->v + span->vStep * i) * z);
+    #endif
+}
+
+// Converts the texture coordinate to a wrapped texel coordinate in 16.16 fixed-point format.
+PR_INLINE PRint _span_wrap_texel_coord(PRfloat t, PRtexsize size)
+{
+    const PRint sizeFixed = (PRint)size << 16;
+
+    PRfloat frac = t - (PRfloat)(PRint)t;
+    if (frac < 0.0f)
+        frac += 1.0f;
+
+    PRint x = (PRint)(frac * (PRfloat)sizeFixed);
+    return (x >= sizeFixed ? x - sizeFixed : x);
+}
+
+#endif
+
+#if defined(_SPAN_SSE2)
+
+// Converts the texture coordinates to wrapped texel coordinates (same as '_pr_texture_sample_nearest_from_mipmap').
+PR_INLINE __m128i _span_texel_coord_sse2(__m128 t, __m128 size, __m128i sizeInt)
+{
+    __m128 frac = _mm_sub_ps(t, _mm_cvtepi32_ps(_mm_cvttps_epi32(t)));
+    __m128i x = _mm_cvttps_epi32(_mm_mul_ps(frac, size));
+    return _mm_add_epi32(x, _mm_and_si128(_mm_cmplt_epi32(x, _mm_setzero_si128()), sizeInt));
+}
+
+// Converts the texture coordinates to wrapped texel coordinates of a power-of-two texture (same as '_pr_texture_sample_nearest_pot_from_mipmap').
+PR_INLINE __m128i _span_texel_coord_pot_sse2(__m128 t, __m128 size, __m128i sizeMask)
+{
+    return _mm_and_si128(_mm_cvttps_epi32(_mm_mul_ps(t, size)), sizeMask);
+}
+
+// Computes the indices of 4 texels (see _pr_texture_texel_index). The multiplication with the pitch is exact in floating-point for all texture sizes up to PR_MAX_TEX_SIZE.
+PR_INLINE __m128i _span_texel_index_sse2(__m128i x, __m128i y, __m128 pitch)
+{
+    #ifdef PR_TEXTURE_BLOCKS
+    const __m128i blockMask = _mm_set1_epi32(PR_TEXTURE_BLOCK_MASK);
+    __m128 block = _mm_add_ps(
+        _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(y, PR_TEXTURE_BLOCK_SHIFT)), pitch),
+        _mm_cvtepi32_ps(_mm_srli_epi32(x, PR_TEXTURE_BLOCK_SHIFT))
+    );
+    __m128i texel = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(y, blockMask), PR_TEXTURE_BLOCK_SHIFT), _mm_and_si128(x, blockMask));
+    return _mm_or_si128(_mm_slli_epi32(_mm_cvttps_epi32(block), PR_TEXTURE_BLOCK_SHIFT*2), texel);
+    #else
+    return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(y), pitch), _mm_cvtepi32_ps(x)));
+    #endif
+}
+
+// Converts the depths of 4 pixels (32 bits per lane) into the lower half of biased 16-bit depths (see _span_load_depths_sse2).
+PR_INLINE __m128i _span_bias_depths_sse2(__m128i depth)
+{
+    depth = _mm_sub_epi32(depth, _mm_set1_epi32(0x8000));
+    return _mm_packs_epi32(depth, depth);
+}
+
+// Loads the depths of 4 pixels biased by 0x8000, so that they can be compared with the signed 16-bit comparison of SSE2.
+PR_INLINE __m128i _span_load_depths_sse2(const PRdepthtype* depths)
+{
+    return _mm_xor_si128(_mm_loadl_epi64((const __m128i*)depths), _mm_set1_epi16((short)0x8000));
+}
+
+// Stores the biased depths of 4 pixels.
+PR_INLINE void _span_store_depths_sse2(PRdepthtype* depths, __m128i depth)
+{
+    _mm_storel_epi64((__m128i*)depths, _mm_xor_si128(depth, _mm_set1_epi16((short)0x8000)));
+}
+
+// Packs the depth test mask of 4 float depths (32 bits per lane) into the lower half of a 16-bit lane mask.
+PR_INLINE __m128i _span_pack_mask_sse2(__m128 mask)
+{
+    __m128i v = _mm_castps_si128(mask);
+    return _mm_packs_epi32(v, v);
+}
+
+#elif defined(_SPAN_AVX2)
+
+// Converts the texture coordinates to wrapped texel coordinates (same as '_pr_texture_sample_nearest_from_mipmap').
+PR_INLINE __m256i _span_texel_coord_avx2(__m256 t, __m256 size, __m256i sizeInt)
+{
+    __m256 frac = _mm256_sub_ps(t, _mm256_round_ps(t, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC));
+    __m256i x = _mm256_cvttps_epi32(_mm256_mul_ps(frac, size));
+    return _mm256_add_epi32(x, _mm256_and_si256(_mm256_cmpgt_epi32(_mm256_setzero_si256(), x), sizeInt));
+}
+
+// Converts the texture coordinates to wrapped texel coordinates of a power-of-two texture (same as '_pr_texture_sample_nearest_pot_from_mipmap').
+PR_INLINE __m256i _span_texel_coord_pot_avx2(__m256 t, __m256 size, __m256i sizeMask)
+{
+    return _mm256_and_si256(_mm256_cvttps_epi32(_mm256_mul_ps(t, size)), sizeMask);
+}
+
+// Computes the indices of 8 texels (see _pr_texture_texel_index).
+PR_INLINE __m256i _span_texel_index_avx2(__m256i x, __m256i y, __m256i pitch)
+{
+    #ifdef PR_TEXTURE_BLOCKS
+    const __m256i blockMask = _mm256_set1_epi32(PR_TEXTURE_BLOCK_MASK);
+    __m256i block = _mm256_add_epi32(
+        _mm256_mullo_epi32(_mm256_srli_epi32(y, PR_TEXTURE_BLOCK_SHIFT), pitch),
+        _mm256_srli_epi32(x, PR_TEXTURE_BLOCK_SHIFT)
+    );
+    __m256i texel = _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(y, blockMask), PR_TEXTURE_BLOCK_SHIFT), _mm256_and_si256(x, blockMask));
+    return _mm256_or_si256(_mm256_slli_epi32(block, PR_TEXTURE_BLOCK_SHIFT*2), texel);
+    #else
+    return _mm256_add_epi32(_mm256_mullo_epi32(y, pitch), x);
+    #endif
+}
+
+// Converts the depths of 8 pixels (32 bits per lane) into biased 16-bit depths (see _span_load_depths_avx2).
+PR_INLINE __m128i _span_bias_depths_avx2(__m256i depth)
+{
+    __m128i v = _mm_packus_epi32(_mm256_castsi256_si128(depth), _mm256_extracti128_si256(depth, 1));
+    return _mm_xor_si128(v, _mm_set1_epi16((short)0x8000));
+}
+
+// Loads the depths of 8 pixels biased by 0x8000, so that they can be compared with the signed 16-bit comparison.
+PR_INLINE __m128i _span_load_depths_avx2(const PRdepthtype* depths)
+{
+    return _mm_xor_si128(_mm_loadu_si128((const __m128i*)depths), _mm_set1_epi16((short)0x8000));
+}
+
+// Stores the biased depths of 8 pixels.
+PR_INLINE void _span_store_depths_avx2(PRdepthtype* depths, __m128i depth)
+{
+    _mm_storeu_si128((__m128i*)depths, _mm_xor_si128(depth, _mm_set1_epi16((short)0x8000)));
+}
+
+// Packs the depth test mask of 8 float depths (32 bits per lane) into a 16-bit lane mask.
+PR_INLINE __m128i _span_pack_mask_avx2(__m256 mask)
+{
+    __m256i v = _mm256_castps_si256(mask);
+    return _mm_packs_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+}
+
+#endif
+
+// --- kernel variants --- //
+
+// Textured, depth writes with PR_DEPTH_GREATER
+#define _SPAN_DEPTH_TEST     1
+#define _SPAN_DEPTH_WRITE    1
+#define _SPAN_DEPTH_GEQUAL   0
+#define _SPAN_FLAT           0
+#define _SPAN_DEPTH_FLOAT    0
+#define _SPAN_TEXTURE_POT    0
+#define _SPAN_TEXTURE_LINEAR 0
+#define _SPAN_KERNEL(name)   name##_write_greater
+#include "span_kernel.h"
+
+// Textured, depth writes with PR_DEPTH_GEQUAL
+#define _SPAN_DEPTH_TEST     1
+#define _SPAN_DEPTH_WRITE    1
+#define _SPAN_DEPTH_GEQUAL   1
+#define _SPAN_FLAT           0
+#define _SPAN_DEPTH_FLOAT    0
+#define _SPAN_TEXTURE_POT    0
+#define _SPAN_TEXTURE_LINEAR 0
+#define _SPAN_KERNEL(name)   name##_write_gequal
+#include "span_kernel.h"
+
+// Textured, depth test only with PR_DEPTH_GREATER
+#define _SPAN_DEPTH_TEST     1
+#define _SPAN_DEPTH_WRITE    0
+#define _SPAN_DEPTH_GEQUAL   0
+#define _SPAN_FLAT           0
+#define _SPAN_DEPTH_FLOAT    0
+#define _SPAN_TEXTURE_POT    0
+#define _SPAN_TEXTURE_LINEAR 0
+#define _SPAN_KERNEL(name)   name##_test_greater
+#include "span_kernel.h"
+
+// Textured, depth test only with PR_DEPTH_GEQUAL
+#define _SPAN_DEPTH_TEST     1
+#define _SPAN_DEPTH_WRITE    0
+#define _SPAN_DEPTH_GEQUAL   1
+#define _SPAN_FLAT           0
+#define _SPAN_DEPTH_FLOAT    0
+#define _SPAN_TEXTURE_POT    0
+#define _SPAN_TEXTURE_LINEAR 0
+#define _SPAN_KERNEL(name)   name##_test_gequal
+#include "span_kernel.h"
+
+// Textured, no depth test
+#define _SPAN_DEPTH_TEST     0
+#define _SPAN_DEPTH_WRITE    0
+#define _SPAN_DEPTH_GEQUAL   0
+#define _SPAN_FLAT           0
+#define _SPAN_DEPTH_FLOAT    0
+#define _SPAN_TEXTURE_POT    0
+#define _SPAN_TEXTURE_LINEAR 0
+#define _SPAN_KERNEL(name)   name##_none
+#include "span_kernel.h"
+
+// Flat color, depth writes with PR_DEPTH_GREATER
+#define _SPAN_DEPTH_TEST     1
+#define _SPAN_DEPTH_WRITE    1
+#define _SPAN_DEPTH_GEQUAL   0
+#define _SPAN_FLAT           1
+#define _SPAN_DEPTH_FLOAT    0
+#define _SPAN_TEXTURE_POT    0
+#define _SPAN_TEXTURE_LINEAR 0
+#define _SPAN_KERNEL(name)   name##_flat_write_greater
+#include "span_kernel.h"
+
+// Flat color, depth writes with PR_DEPTH_GEQUAL
+#define _SPAN_DEPTH_TEST     1
+#define _SPAN_DEPTH_WRITE    1
+#define _SPAN_DEPTH_GEQUAL   1
+#define _SPAN_FLAT           1
+#define _SPAN_DEPTH_FLOAT    0
+#define _SPAN_TEXTURE_POT    0
+#define _SPAN_TEXTURE_LINEAR 0
+#define _SPAN_KERNEL(name)   name##_flat_write_gequal
+#include "span_kernel.h"
+
+// Flat color, depth test only with PR_DEPTH_GREATER
+#define _SPAN_DEPTH_TEST     1
+#define _SPAN_DEPTH_WRITE    0
+#define _SPAN_DEPTH_GEQUAL   0
+#define _SPAN_FLAT           1
+#define _SPAN_DEPTH_FLOAT    0
+#define _SPAN_TEXTURE_POT    0
+#define _SPAN_TEXTURE_LINEAR 0
+#define _SPAN_KERNEL(name)   name##_flat_test_greater
+#include "span_kernel.h"
+
+// Flat color, depth test only with PR_DEPTH_GEQUAL
+#define _SPAN_DEPTH_TEST     1
+#define _SPAN_DEPTH_WRITE    0
+#define _SPAN_DEPTH_GEQUAL   1
+#define _SPAN_FLAT           1
+#define _SPAN_DEPTH_FLOAT    0
+#define _SPAN_TEXTURE_POT    0
+#define _SPAN_TEXTURE_LINEAR 0
+#define _SPAN_KERNEL(name)   name##_flat_test_gequal
+#include "span_kernel.h"
+
+// Textured, float depth writes with PR_DEPTH_GREATER
+#define _SPAN_DEPTH_TEST     1
+#define _SPAN_DEPTH_WRITE    1
+#define _SPAN_DEPTH_GEQUAL   0
+#define _SPAN_FLAT           0
+#define _SPAN_DEPTH_FLOAT    1
+#define _SPAN_TEXTURE_POT    0
+#define _SPAN_TEXTURE_LINEAR 0
+#define _SPAN_KERNEL(name)   name##_float_write_greater
+#include "span_kernel.h"
+
+// Textured, float depth writes with PR_DEPTH_GEQUAL
+#define _SPAN_DEPTH_TEST     1
+#define _SPAN_DEPTH_WRITE    1
+#define _SPAN_DEPTH_GEQUAL   1
+#define _SPAN_FLAT           0
+#define _SPAN_DEPTH_FLOAT    1
+#define _SPAN_TEXTURE_POT    0
+#define _SPAN_TEXTURE_LINEAR 0
+#define _SPAN_KERNEL(name)   name##_float_write_gequal
+#include "span_kernel.h"
+
+// Textured, float depth test only with PR_DEPTH_GREATER
+#define _SPAN_DEPTH_TEST     1
+#define _SPAN_DEPTH_WRITE    0
+#define _SPAN_DEPTH_GEQUAL   0
+#define _SPAN_FLAT           0
+#define _SPAN_DEPTH_FLOAT    1
+#define _SPAN_TEXTURE_POT    0
+#define _SPAN_TEXTURE_LINEAR 0
+#define _SPAN_KERNEL(name)   name##_float_test_greater
+#include "span_kernel.h"
+
+// Textured, float depth test only with PR_DEPTH_GEQUAL
+#define _SPAN_DEPTH_TEST     1
+#define _SPAN_DEPTH_WRITE    0
+#define _SPAN_DEPTH_GEQUAL   1
+#define _SPAN_FLAT           0
+#define _SPAN_DEPTH_FLOAT    1
+#define _SPAN_TEXTURE_POT    0
+#define _SPAN_TEXTURE_LINEAR 0
+#define _SPAN_KERNEL(name)   name##_float_test_gequal
+#include "span_kernel.h"
+
+// Flat color, float depth writes with PR_DEPTH_GREATER
+#define _SPAN_DEPTH_TEST     1
+#define _SPAN_DEPTH_WRITE    1
+#define _SPAN_DEPTH_GEQUAL   0
+#define _SPAN_FLAT           1
+#define _SPAN_DEPTH_FLOAT    1
+#define _SPAN_TEXTURE_POT    0
+#define _SPAN_TEXTURE_LINEAR 0
+#define _SPAN_KERNEL(name)   name##_flat_float_write_greater
+#include "span_kernel.h"
+
+// Flat color, float depth writes with PR_DEPTH_GEQUAL
+#define _SPAN_DEPTH_TEST     1
+#define _SPAN_DEPTH_WRITE    1
+#define _SPAN_DEPTH_GEQUAL   1
+#define _SPAN_FLAT           1
+#define _SPAN_DEPTH_FLOAT    1
+#define _SPAN_TEXTURE_POT    0
+#define _SPAN_TEXTURE_LINEAR 0
+#define _SPAN_KERNEL(name)   name##_flat_float_write_gequal
+#include "span_kernel.h"
+
+// Flat color, float depth test only with PR_DEPTH_GREATER
+#define _SPAN_DEPTH_TEST     1
+#define _SPAN_DEPTH_WRITE    0
+#define _SPAN_DEPTH_GEQUAL   0
+#define _SPAN_FLAT           1
+#define _SPAN_DEPTH_FLOAT    1
+#define _SPAN_TEXTURE_POT    0
+#define _SPAN_TEXTURE_LINEAR 0
+#define _SPAN_KERNEL(name)   name##_flat_float_test_greater
+#include "span_kernel.h"
+
+// Flat color, float depth test only with PR_DEPTH_GEQUAL
+#define _SPAN_DEPTH_TEST     1
+#define _SPAN_DEPTH_WRITE    0
+#define _SPAN_DEPTH_GEQUAL   1
+#define _SPAN_FLAT           1
+#define _SPAN_DEPTH_FLOAT    1
+#define _SPAN_TEXTURE_POT    0
+#define _SPAN_TEXTURE_LINEAR 0
+#define _SPAN_KERNEL(name)   name##_flat_float_test_gequal
+#include "span_kernel.h"
+
+// Power-of-two texture, depth writes with PR_DEPTH_GREATER
+#define _SPAN_DEPTH_TEST     1
+#define _SPAN_DEPTH_WRITE    1
+#define _SPAN_DEPTH_GEQUAL   0
+#define _SPAN_FLAT           0
+#define _SPAN_DEPTH_FLOAT    0
+#define _SPAN_TEXTURE_POT    1
+#define _SPAN_TEXTURE_LINEAR 0
+#define _SPAN_KERNEL(name)   name##_pot_write_greater
+#include "span_kernel.h"
+
+// Power-of-two texture, depth writes with PR_DEPTH_GEQUAL
+#define _SPAN_DEPTH_TEST     1
+#define _SPAN_DEPTH_WRITE    1
+#define _SPAN_DEPTH_GEQUAL   1
+#define _SPAN_FLAT           0
+#define _SPAN_DEPTH_FLOAT    0
+#define _SPAN_TEXTURE_POT    1
+#define _SPAN_TEXTURE_LINEAR 0
+#define _SPAN_KERNEL(name)   name##_pot_write_gequal
+#include "span_kernel.h"
+
+// Power-of-two texture, depth test only with PR_DEPTH_GREATER
+#define _SPAN_DEPTH_TEST     1
+#define _SPAN_DEPTH_WRITE    0
+#define _SPAN_DEPTH_GEQUAL   0
+#define _SPAN_FLAT           0
+#define _SPAN_DEPTH_FLOAT    0
+#define _SPAN_TEXTURE_POT    1
+#define _SPAN_TEXTURE_LINEAR 0
+#define _SPAN_KERNEL(name)   name##_pot_test_greater
+#include "span_kernel.h"
+
+// Power-of-two texture, depth test only with PR_DEPTH_GEQUAL
+#define _SPAN_DEPTH_TEST     1
+#define _SPAN_DEPTH_WRITE    0
+#define _SPAN_DEPTH_GEQUAL   1
+#define _SPAN_FLAT           0
+#define _SPAN_DEPTH_FLOAT    0
+#define _SPAN_TEXTURE_POT    1
+#define _SPAN_TEXTURE_LINEAR 0
+#define _SPAN_KERNEL(name)   name##_pot_test_gequal
+#include "span_kernel.h"
+
+// Power-of-two texture, no depth test
+#define _SPAN_DEPTH_TEST     0
+#define _SPAN_DEPTH_WRITE    0
+#define _SPAN_DEPTH_GEQUAL   0
+#define _SPAN_FLAT           0
+#define _SPAN_DEPTH_FLOAT    0
+#define _SPAN_TEXTURE_POT    1
+#define _SPAN_TEXTURE_LINEAR 0
+#define _SPAN_KERNEL(name)   name##_pot_none
+#include "span_kernel.h"
+
+// Power-of-two texture, float depth writes with PR_DEPTH_GREATER
+#define _SPAN_DEPTH_TEST     1
+#define _SPAN_DEPTH_WRITE    1
+#define _SPAN_DEPTH_GEQUAL   0
+#define _SPAN_FLAT           0
+#define _SPAN_DEPTH_FLOAT    1
+#define _SPAN_TEXTURE_POT    1
+#define _SPAN_TEXTURE_LINEAR 0
+#define _SPAN_KERNEL(name)   name##_pot_float_write_greater
+#include "span_kernel.h"
+
+// Power-of-two texture, float depth writes with PR_DEPTH_GEQUAL
+#define _SPAN_DEPTH_TEST     1
+#define _SPAN_DEPTH_WRITE    1
+#define _SPAN_DEPTH_GEQUAL   1
+#define _SPAN_FLAT           0
+#define _SPAN_DEPTH_FLOAT    1
+#define _SPAN_TEXTURE_POT    1
+#define _SPAN_TEXTURE_LINEAR 0
+#define _SPAN_KERNEL(name)   name##_pot_float_write_gequal
+#include "span_kernel.h"
+
+// Power-of-two texture, float depth test only with PR_DEPTH_GREATER
+#define _SPAN_DEPTH_TEST     1
+#define _SPAN_DEPTH_WRITE    0
+#define _SPAN_DEPTH_GEQUAL   0
+#define _SPAN_FLAT           0
+#define _SPAN_DEPTH_FLOAT    1
+#define _SPAN_TEXTURE_POT    1
+#define _SPAN_TEXTURE_LINEAR 0
+#define _SPAN_KERNEL(name)   name##_pot_float_test_greater
+#include "span_kernel.h"
+
+// Power-of-two texture, float depth test only with PR_DEPTH_GEQUAL
+#define _SPAN_DEPTH_TEST     1
+#define _SPAN_DEPTH_WRITE    0
+#define _SPAN_DEPTH_GEQUAL   1
+#define _SPAN_FLAT           0
+#define _SPAN_DEPTH_FLOAT    1
+#define _SPAN_TEXTURE_POT    1
+#define _SPAN_TEXTURE_LINEAR 0
+#define _SPAN_KERNEL(name)   name##_pot_float_test_gequal
+#include "span_kernel.h"
+
+// Bilinear texture, depth writes with PR_DEPTH_GREATER
+#define _SPAN_DEPTH_TEST     1
+#define _SPAN_DEPTH_WRITE    1
+#define _SPAN_DEPTH_GEQUAL   0
+#define _SPAN_FLAT           0
+#define _SPAN_DEPTH_FLOAT    0
+#define _SPAN_TEXTURE_POT    0
+#define _SPAN_TEXTURE_LINEAR 1
+#define _SPAN_KERNEL(name)   name##_linear_write_greater
+#include "span_kernel.h"
+
+// Bilinear texture, depth writes with PR_DEPTH_GEQUAL
+#define _SPAN_DEPTH_TEST     1
+#define _SPAN_DEPTH_WRITE    1
+#define _SPAN_DEPTH_GEQUAL   1
+#define _SPAN_FLAT           0
+#define _SPAN_DEPTH_FLOAT    0
+#define _SPAN_TEXTURE_POT    0
+#define _SPAN_TEXTURE_LINEAR 1
+#define _SPAN_KERNEL(name)   name##_linear_write_gequal
+#include "span_kernel.h"
+
+// Bilinear texture, depth test only with PR_DEPTH_GREATER
+#define _SPAN_DEPTH_TEST     1
+#define _SPAN_DEPTH_WRITE    0
+#define _SPAN_DEPTH_GEQUAL   0
+#define _SPAN_FLAT           0
+#define _SPAN_DEPTH_FLOAT    0
+#define _SPAN_TEXTURE_POT    0
+#define _SPAN_TEXTURE_LINEAR 1
+#define _SPAN_KERNEL(name)   name##_linear_test_greater
+#include "span_kernel.h"
+
+// Bilinear texture, depth test only with PR_DEPTH_GEQUAL
+#define _SPAN_DEPTH_TEST     1
+#define _SPAN_DEPTH_WRITE    0
+#define _SPAN_DEPTH_GEQUAL   1
+#define _SPAN_FLAT           0
+#define _SPAN_DEPTH_FLOAT    0
+#define _SPAN_TEXTURE_POT    0
+#define _SPAN_TEXTURE_LINEAR 1
+#define _SPAN_KERNEL(name)   name##_linear_test_gequal
+#include "span_kernel.h"
+
+// Bilinear texture, no depth test
+#define _SPAN_DEPTH_TEST     0
+#define _SPAN_DEPTH_WRITE    0
+#define _SPAN_DEPTH_GEQUAL   0
+#define _SPAN_FLAT           0
+#define _SPAN_DEPTH_FLOAT    0
+#define _SPAN_TEXTURE_POT    0
+#define _SPAN_TEXTURE_LINEAR 1
+#define _SPAN_KERNEL(name)   name##_linear_none
+#include "span_kernel.h"
+
+// Bilinear texture, float depth writes with PR_DEPTH_GREATER
+#define _SPAN_DEPTH_TEST     1
+#define _SPAN_DEPTH_WRITE    1
+#define _SPAN_DEPTH_GEQUAL   0
+#define _SPAN_FLAT           0
+#define _SPAN_DEPTH_FLOAT    1
+#define _SPAN_TEXTURE_POT    0
+#define _SPAN_TEXTURE_LINEAR 1
+#define _SPAN_KERNEL(name)   name##_linear_float_write_greater
+#include "span_kernel.h"
+
+// Bilinear texture, float depth writes with PR_DEPTH_GEQUAL
+#define _SPAN_DEPTH_TEST     1
+#define _SPAN_DEPTH_WRITE    1
+#define _SPAN_DEPTH_GEQUAL   1
+#define _SPAN_FLAT           0
+#define _SPAN_DEPTH_FLOAT    1
+#define _SPAN_TEXTURE_POT    0
+#define _SPAN_TEXTURE_LINEAR 1
+#define _SPAN_KERNEL(name)   name##_linear_float_write_gequal
+#include "span_kernel.h"
+
+// Bilinear texture, float depth test only with PR_DEPTH_GREATER
+#define _SPAN_DEPTH_TEST     1
+#define _SPAN_DEPTH_WRITE    0
+#define _SPAN_DEPTH_GEQUAL   0
+#define _SPAN_FLAT           0
+#define _SPAN_DEPTH_FLOAT    1
+#define _SPAN_TEXTURE_POT    0
+#define _SPAN_TEXTURE_LINEAR 1
+#define _SPAN_KERNEL(name)   name##_linear_float_test_greater
+#include "span_kernel.h"
+
+// Bilinear texture, float depth test only with PR_DEPTH_GEQUAL
+#define _SPAN_DEPTH_TEST     1
+#define _SPAN_DEPTH_WRITE    0
+#define _SPAN_DEPTH_GEQUAL   1
+#define _SPAN_FLAT           0
+#define _SPAN_DEPTH_FLOAT    1
+#define _SPAN_TEXTURE_POT    0
+#define _SPAN_TEXTURE_LINEAR 1
+#define _SPAN_KERNEL(name)   name##_linear_float_test_gequal
+#include "span_kernel.h"
+
+// Fills the span with the flat color without depth test (the depth buffer is neither read nor written).
+static void _span_rasterize_flat_fill(const pr_span* span, const PRcolorindex* texels, PRtexsize mipWidth, PRtexsize mipHeight)
+{
+    (void)texels;
+    (void)mipWidth;
+    (void)mipHeight;
+
+    #ifdef PR_COLOR_BUFFER_24BIT
+    for (PRint i = 0; i < span->length; ++i)
+        span->colors[i] = span->color;
+    #else
+    memset(span->colors, span->color, (size_t)span->length);
+    #endif
+}
+
+#if defined(PR_PERSPECTIVE_CORRECTED) && !defined(_SPAN_AVX2) && !defined(_SPAN_SSE2)
+#   define _SPAN_SUBSPAN_KERNEL(name) _span_rasterize_subspan_##name
+#else
+// The SIMD span kernels divide several pixels at once, which is faster than linear subspans
+#   define _SPAN_SUBSPAN_KERNEL(name) _span_rasterize_##name
+#endif
+
+/*
+Span kernels indexed by depth format (PRdepthtype, PRfloat), depth mode and shading
+(depth only, textured, textured with subspans, flat color, power-of-two textured, power-of-two textured with subspans, bilinear textured)
+*/
+static const pr_span_kernel _spanKernels[2][5][7] =
+{
+    {
+        // No depth test
+        { NULL, _span_rasterize_none, _SPAN_SUBSPAN_KERNEL(none), _span_rasterize_flat_fill, _span_rasterize_pot_none, _SPAN_SUBSPAN_KERNEL(pot_none), _span_rasterize_linear_none },
+
+        // Depth test only with PR_DEPTH_GREATER and PR_DEPTH_GEQUAL
+        { NULL, _span_rasterize_test_greater, _SPAN_SUBSPAN_KERNEL(test_greater), _span_rasterize_flat_test_greater, _span_rasterize_pot_test_greater, _SPAN_SUBSPAN_KERNEL(pot_test_greater), _span_rasterize_linear_test_greater },
+        { NULL, _span_rasterize_test_gequal, _SPAN_SUBSPAN_KERNEL(test_gequal), _span_rasterize_flat_test_gequal, _span_rasterize_pot_test_gequal, _SPAN_SUBSPAN_KERNEL(pot_test_gequal), _span_rasterize_linear_test_gequal },
+
+        // Depth writes with PR_DEPTH_GREATER and PR_DEPTH_GEQUAL
+        { _span_rasterize_depth_write_greater, _span_rasterize_write_greater, _SPAN_SUBSPAN_KERNEL(write_greater), _span_rasterize_flat_write_greater, _span_rasterize_pot_write_greater, _SPAN_SUBSPAN_KERNEL(pot_write_greater), _span_rasterize_linear_write_greater },
+        { _span_rasterize_depth_write_gequal, _span_rasterize_write_gequal, _SPAN_SUBSPAN_KERNEL(write_gequal), _span_rasterize_flat_write_gequal, _span_rasterize_pot_write_gequal, _SPAN_SUBSPAN_KERNEL(pot_write_gequal), _span_rasterize_linear_write_gequal },
+    },
+    {
+        // No depth test (the depth buffer is neither read nor written, so the format does not matter)
+        { NULL, _span_rasterize_none, _SPAN_SUBSPAN_KERNEL(none), _span_rasterize_flat_fill, _span_rasterize_pot_none, _SPAN_SUBSPAN_KERNEL(pot_none), _span_rasterize_linear_none },
+
+        // Depth test only with PR_DEPTH_GREATER and PR_DEPTH_GEQUAL
+        { NULL, _span_rasterize_float_test_greater, _SPAN_SUBSPAN_KERNEL(float_test_greater), _span_rasterize_flat_float_test_greater, _span_rasterize_pot_float_test_greater, _SPAN_SUBSPAN_KERNEL(pot_float_test_greater), _span_rasterize_linear_float_test_greater },
+        { NULL, _span_rasterize_float_test_gequal, _SPAN_SUBSPAN_KERNEL(float_test_gequal), _span_rasterize_flat_float_test_gequal, _span_rasterize_pot_float_test_gequal, _SPAN_SUBSPAN_KERNEL(pot_float_test_gequal), _span_rasterize_linear_float_test_gequal },
+
+        // Depth writes with PR_DEPTH_GREATER and PR_DEPTH_GEQUAL
+        { _span_rasterize_depth_float_write_greater, _span_rasterize_float_write_greater, _SPAN_SUBSPAN_KERNEL(float_write_greater), _span_rasterize_flat_float_write_greater, _span_rasterize_pot_float_write_greater, _SPAN_SUBSPAN_KERNEL(pot_float_write_greater), _span_rasterize_linear_float_write_greater },
+        { _span_rasterize_depth_float_write_gequal, _span_rasterize_float_write_gequal, _SPAN_SUBSPAN_KERNEL(float_write_gequal), _span_rasterize_flat_float_write_gequal, _span_rasterize_pot_float_write_gequal, _SPAN_SUBSPAN_KERNEL(pot_float_write_gequal), _span_rasterize_linear_float_write_gequal },
+    },
+};
+
+#undef _SPAN_SUBSPAN_KERNEL
+
+// --- interface --- //
+
+pr_span_kernel _pr_span_kernel_select(PRbitfield flags)
+{
+    PRint depthMode = 0, shading = 0;
+
+    if ((flags & PR_SPAN_DEPTH_TEST) != 0)
+        depthMode = ((flags & PR_SPAN_DEPTH_WRITE) != 0 ? 3 : 1) + ((flags & PR_SPAN_DEPTH_GEQUAL) != 0 ? 1 : 0);
+
+    if ((flags & PR_SPAN_COLOR_WRITE) != 0)
+    {
+        if ((flags & PR_SPAN_FLAT) != 0)
+            shading = 3;
+        else if ((flags & PR_SPAN_SUBSPAN) != 0)
+            shading = 2;
+        else
+            shading = 1;
+
+        if ((flags & PR_SPAN_FLAT) == 0)
+        {
+            if ((flags & PR_SPAN_TEXTURE_LINEAR) != 0)
+                shading = 6;
+            else if ((flags & PR_SPAN_TEXTURE_POT) != 0)
+                shading += 3;
+        }
+    }
+
+    return _spanKernels[(flags & PR_SPAN_DEPTH_FLOAT) != 0 ? 1 : 0][depthMode][shading];
+}
@@ -0,0 +1,76 @@
+/*
+ * span.h
+ *
+ * This file is part of the "PicoRenderer" (Copyright (c) 2014 by Lukas Hermanns)
+ * See "LICENSE.txt" for license information.
+ */
+
+#ifndef __PR_SPAN_H__
+#define __PR_SPAN_H__
+
+
+#include "pixel.h"
+#include "texture.h"
+
+
+#define PR_SPAN_COLOR_WRITE     0x0001 //!< Visible pixels write the sampled texel (or the flat color).
+#define PR_SPAN_DEPTH_WRITE     0x0002 //!< Visible pixels write their depth.
+#define PR_SPAN_DEPTH_GEQUAL    0x0004 //!< Pixels with an equal depth pass the depth test (PR_DEPTH_GEQUAL instead of PR_DEPTH_GREATER).
+#define PR_SPAN_SUBSPAN         0x0008 //!< Perspective correction only at every n-th pixel (see pr_span::subspanLength).
+#define PR_SPAN_DEPTH_TEST      0x0010 //!< Pixels make the depth test. Otherwise the depth buffer is neither read nor written.
+#define PR_SPAN_FLAT            0x0020 //!< Visible pixels write the flat color (see pr_span::color) instead of a texel.
+#define PR_SPAN_DEPTH_FLOAT     0x0040 //!< Depths are 32-bit floats (PR_DEPTH_COMPONENT32F) instead of PRdepthtype.
+#define PR_SPAN_TEXTURE_POT     0x0080 //!< Texture width and height are powers of two, so the texture coordinates are wrapped with bitmasks.
+#define PR_SPAN_TEXTURE_LINEAR  0x0100 //!< Visible pixels write the bilinear filtered texel (see PR_TEXTURE_FILTER).
+
+
+//! Horizontal pixel span with the interpolated attributes at its first pixel and their steps per pixel.
+typedef struct pr_span
+{
+    PRcolorindex* colors;            //!< Pointer to the color index of the first pixel in the color plane.
+    PRvoid*      depths;             //!< Pointer to the depth of the first pixel in the depth plane (PRdepthtype or PRfloat, see PR_SPAN_DEPTH_FLOAT).
+    PRint        length;             //!< Number of pixels in the span.
+    PRint        slack;              //!< Number of pixels after the span in the same screen tile, which the SIMD kernels may load and store back unchanged.
+    PRinterpacc  z;
+    PRinterpacc  u;
+    PRinterpacc  v;
+    PRinterpacc  zStep;
+    PRinterpacc  uStep;
+    PRinterpacc  vStep;
+    PRint        subspanLength;      //!< Number of pixels per subspan (power of two). Only used by the PR_SPAN_SUBSPAN kernels.
+    PRcolorindex color;              //!< Flat color index. Only used by the PR_SPAN_FLAT kernels.
+}
+pr_span;
+
+//! Span kernel function, which makes the depth test for each pixel of the span and writes the enabled buffers on success.
+typedef void (*pr_span_kernel)(const pr_span* span, const PRcolorindex* texels, PRtexsize mipWidth, PRtexsize mipHeight);
+
+
+/**
+Returns the span kernel, which is specialized for the specified state bits, so that its inner loop contains no state branches.
+All variants are generated from the template "span_kernel.h" at compile time.
+With PR_SIMD_SSE2 the pixels are processed in groups of 4, followed by a scalar tail.
+With PR_SIMD_AVX2 the pixels are processed in groups of 8; the last group is masked if it fits into the span and its slack
+(see pr_span::slack), otherwise it is tested one pixel at a time.
+\param[in] flags Bitwise OR combination of the PR_SPAN_... bits.
+- Without PR_SPAN_COLOR_WRITE the kernel writes the depth buffer only and never samples the texture (e.g. for a depth pre-pass).
+- Without PR_SPAN_DEPTH_TEST, PR_SPAN_DEPTH_WRITE and PR_SPAN_DEPTH_GEQUAL are ignored.
+- PR_SPAN_DEPTH_FLOAT selects a kernel, which compares and writes the interpolated depths as floats without conversion.
+- PR_SPAN_TEXTURE_POT selects a kernel, which wraps the texture coordinates with bitmasks instead of their fractions.
+It gives the same texels, but must only be used for power-of-two textures (see pr_texture::powerOfTwo).
+- PR_SPAN_TEXTURE_LINEAR selects a kernel, which filters the texels bilinearly with '_pr_texture_sample_linear_from_mipmap'
+(the SIMD kernels still make the depth test and the perspective correction for several pixels at once).
+PR_SPAN_TEXTURE_POT and PR_SPAN_SUBSPAN are ignored in this case.
+- PR_SPAN_FLAT selects a kernel, which only interpolates the depth and writes the flat color.
+Without PR_SPAN_DEPTH_TEST this is a plain fill of the color buffer. PR_SPAN_SUBSPAN is ignored in this case.
+- PR_SPAN_SUBSPAN selects a kernel, which computes the perspective correction only at every n-th pixel
+and interpolates the texture coordinates linearly in between. It is ignored if a SIMD kernel or
+no PR_PERSPECTIVE_CORRECTED is compiled in, and it falls back to per-pixel correction for untextured polygons
+and spans which are not longer than one subspan.
+\return Span kernel or null if nothing would be written, i.e. without PR_SPAN_COLOR_WRITE
+and without PR_SPAN_DEPTH_TEST or PR_SPAN_DEPTH_WRITE.
+*/
+pr_span_kernel _pr_span_kernel_select(PRbitfield flags);
+
+
+#endif
@@ -0,0 +1,803 @@
+/*
+ * span_kernel.h
+ *
+ * This file is part of the "PicoRenderer" (Copyright (c) 2014 by Lukas Hermanns)
+ * See "LICENSE.txt" for license information.
+ */
+
+/*
+Span kernel template, which is included by "span.c" once for each kernel variant (therefore no include guard).
+The following macros must be defined before each inclusion and are undefined at the end of this file:
+ - _SPAN_DEPTH_TEST:    1 if the depth test is made, otherwise 0 (then the depth buffer is neither read nor written).
+ - _SPAN_DEPTH_WRITE:   1 if visible pixels write their depth, otherwise 0.
+ - _SPAN_DEPTH_GEQUAL:  1 if pixels with an equal depth pass the depth test, otherwise 0.
+ - _SPAN_FLAT:          1 if visible pixels write the flat color (pr_span::color) instead of a texel, otherwise 0.
+ - _SPAN_DEPTH_FLOAT:   1 if the depths are 32-bit floats (PR_DEPTH_COMPONENT32F), otherwise 0 (PRdepthtype).
+ - _SPAN_TEXTURE_POT:   1 if the texture coordinates are wrapped with bitmasks (power-of-two textures only), otherwise 0.
+ - _SPAN_TEXTURE_LINEAR: 1 if the texels are filtered bilinearly (see PR_TEXTURE_FILTER), otherwise 0 (nearest texel).
+ - _SPAN_KERNEL(name):  Appends the variant suffix to the specified function name.
+*/
+
+#if _SPAN_DEPTH_WRITE && !_SPAN_DEPTH_TEST
+#   error Depth writes require the depth test in span kernels
+#endif
+#if _SPAN_FLAT && !_SPAN_DEPTH_TEST
+#   error Flat spans without depth test are filled by '_span_rasterize_flat_fill'
+#endif
+#if _SPAN_FLAT && (_SPAN_TEXTURE_POT || _SPAN_TEXTURE_LINEAR)
+#   error Flat spans sample no texture
+#endif
+#if _SPAN_TEXTURE_POT && _SPAN_TEXTURE_LINEAR
+#   error Bilinear spans wrap the texture coordinates in the sampler
+#endif
+
+#if _SPAN_DEPTH_GEQUAL
+#   define _SPAN_DEPTH_PASS(depth, dst)             ((depth) >= (dst))
+#   define _SPAN_DEPTH_PASS_SIMD(depth, dst)        _mm_or_si128(_mm_cmpgt_epi16(depth, dst), _mm_cmpeq_epi16(depth, dst))
+#   define _SPAN_DEPTH_PASS_PS(depth, dst)          _mm_cmpge_ps(depth, dst)
+#   define _SPAN_DEPTH_PASS_PS256(depth, dst)       _mm256_cmp_ps(depth, dst, _CMP_GE_OQ)
+#else
+#   define _SPAN_DEPTH_PASS(depth, dst)             ((depth) > (dst))
+#   define _SPAN_DEPTH_PASS_SIMD(depth, dst)        _mm_cmpgt_epi16(depth, dst)
+#   define _SPAN_DEPTH_PASS_PS(depth, dst)          _mm_cmpgt_ps(depth, dst)
+#   define _SPAN_DEPTH_PASS_PS256(depth, dst)       _mm256_cmp_ps(depth, dst, _CMP_GT_OQ)
+#endif
+
+// Float depths are the interpolated values themselves (reversed Z), i.e. they need no conversion
+#if _SPAN_DEPTH_FLOAT
+#   define _SPAN_DEPTH_TYPE                         PRfloat
+#   define _SPAN_DEPTH_FROM_ACC(z)                  PR_INTERP_ACC_TO_FLOAT(z)
+#else
+#   define _SPAN_DEPTH_TYPE                         PRdepthtype
+#   define _SPAN_DEPTH_FROM_ACC(z)                  _pr_pixel_write_depth(PR_INTERP_ACC_TO_INTERP(z))
+#endif
+
+// The SIMD kernels compute the indices of the nearest texels themselves, but call the bilinear sampler for each visible pixel
+#if _SPAN_TEXTURE_LINEAR
+#   define _SPAN_SAMPLER                            _pr_texture_sample_linear_from_mipmap
+#   define _SPAN_GATHER(j)                          _pr_texture_sample_linear_from_mipmap(texels, mipWidth, mipHeight, uCoords[j], vCoords[j])
+#elif _SPAN_TEXTURE_POT
+#   define _SPAN_SAMPLER                            _pr_texture_sample_nearest_pot_from_mipmap
+#   define _SPAN_GATHER(j)                          texels[indices[j]]
+#else
+#   define _SPAN_SAMPLER                            _pr_texture_sample_nearest_from_mipmap
+#   define _SPAN_GATHER(j)                          texels[indices[j]]
+#endif
+
+/*
+The span fields are copied into local variables at the beginning of each kernel,
+because the color indices are bytes and each store would otherwise force the fields to be reloaded (aliasing rules).
+*/
+
+#if defined(_SPAN_SSE2)
+
+// Rasterizes 4 pixels per iteration and returns the number of processed pixels.
+static PRint _SPAN_KERNEL(_span_rasterize_sse2)(const pr_span* span, const PRcolorindex* texels, PRtexsize mipWidth, PRtexsize mipHeight)
+{
+    #if _SPAN_FLAT
+    // Flat spans do not sample the texture
+    (void)texels;
+    (void)mipWidth;
+    (void)mipHeight;
+    #endif
+
+    const __m128 laneOffsets    = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    #if _SPAN_DEPTH_TEST && !_SPAN_DEPTH_FLOAT
+    const __m128 depthMax       = _mm_set1_ps((PRfloat)PR_DEPTH_MAX);
+    const __m128i depthMask     = _mm_set1_epi32(PR_DEPTH_MAX);
+    #endif
+    #if _SPAN_DEPTH_TEST
+    _SPAN_DEPTH_TYPE* depths    = span->depths;
+    #endif
+    #if _SPAN_FLAT
+    const __m128i colorBytes    = _mm_set1_epi8((char)span->color);
+    #else
+    #if !_SPAN_TEXTURE_LINEAR
+    const __m128 width          = _mm_set1_ps((PRfloat)mipWidth);
+    const __m128 height         = _mm_set1_ps((PRfloat)mipHeight);
+    #if _SPAN_TEXTURE_POT
+    const __m128i widthMask     = _mm_set1_epi32(mipWidth - 1);
+    const __m128i heightMask    = _mm_set1_epi32(mipHeight - 1);
+    #else
+    const __m128i widthInt      = _mm_set1_epi32(mipWidth);
+    const __m128i heightInt     = _mm_set1_epi32(mipHeight);
+    #endif
+    const __m128 pitch          = _mm_set1_ps((PRfloat)_pr_texture_texel_pitch(mipWidth));
+    #endif
+    const __m128 uStep          = _mm_mul_ps(laneOffsets, _mm_set1_ps(PR_INTERP_ACC_TO_FLOAT(span->uStep)));
+    const __m128 vStep          = _mm_mul_ps(laneOffsets, _mm_set1_ps(PR_INTERP_ACC_TO_FLOAT(span->vStep)));
+    const PRinterpacc uGroupStep = span->uStep * 4;
+    const PRinterpacc vGroupStep = span->vStep * 4;
+    PRinterpacc u = span->u, v = span->v;
+    #if _SPAN_TEXTURE_LINEAR
+    PRfloat uCoords[4], vCoords[4];
+    #else
+    PRint indices[4];
+    #endif
+    #endif
+
+    const __m128 zStep = _mm_mul_ps(laneOffsets, _mm_set1_ps(PR_INTERP_ACC_TO_FLOAT(span->zStep)));
+    const PRinterpacc zGroupStep = span->zStep * 4;
+
+    PRcolorindex* colors = span->colors;
+    const PRint length = span->length;
+
+    PRinterpacc z = span->z;
+    PRint i = 0;
+
+    for (; i + 4 <= length; i += 4)
+    {
+        __m128 zv = _mm_add_ps(_mm_set1_ps(PR_INTERP_ACC_TO_FLOAT(z)), zStep);
+
+        #if _SPAN_DEPTH_TEST
+        // Interpolate depth and make depth test against the depth of all 4 pixels
+        #if _SPAN_DEPTH_FLOAT
+        __m128 dstDepth = _mm_loadu_ps(depths + i);
+        __m128 depthPass = _SPAN_DEPTH_PASS_PS(zv, dstDepth);
+        __m128i mask = _span_pack_mask_sse2(depthPass);
+        #else
+        __m128i depth = _span_bias_depths_sse2(_mm_and_si128(_mm_cvttps_epi32(_mm_mul_ps(zv, depthMax)), depthMask));
+        __m128i dstDepth = _span_load_depths_sse2(depths + i);
+        __m128i mask = _SPAN_DEPTH_PASS_SIMD(depth, dstDepth);
+        #endif
+        __m128i byteMask = _mm_packs_epi16(mask, mask);
+        PRint laneMask = _mm_movemask_epi8(byteMask) & 0xf;
+
+        if (laneMask != 0)
+        #else
+        const PRint laneMask = 0xf;
+        #endif
+        {
+            #if !_SPAN_FLAT
+            __m128 uv = _mm_add_ps(_mm_set1_ps(PR_INTERP_ACC_TO_FLOAT(u)), uStep);
+            __m128 vv = _mm_add_ps(_mm_set1_ps(PR_INTERP_ACC_TO_FLOAT(v)), vStep);
+
+            #ifdef PR_PERSPECTIVE_CORRECTED
+            // Compute perspective corrected texture coordinates
+            __m128 w = _mm_div_ps(_mm_set1_ps(1.0f), zv);
+            uv = _mm_mul_ps(uv, w);
+            vv = _mm_mul_ps(vv, w);
+            #endif
+
+            #if _SPAN_TEXTURE_LINEAR
+            _mm_storeu_ps(uCoords, uv);
+            _mm_storeu_ps(vCoords, vv);
+            #else
+            // Compute texel indices
+            #if _SPAN_TEXTURE_POT
+            __m128i x = _span_texel_coord_pot_sse2(uv, width, widthMask);
+            __m128i y = _span_texel_coord_pot_sse2(vv, height, heightMask);
+            #else
+            __m128i x = _span_texel_coord_sse2(uv, width, widthInt);
+            __m128i y = _span_texel_coord_sse2(vv, height, heightInt);
+            #endif
+            _mm_storeu_si128((__m128i*)indices, _span_texel_index_sse2(x, y, pitch));
+            #endif
+            #endif
+
+            // Write depth of the visible pixels
+            #if _SPAN_DEPTH_WRITE && _SPAN_DEPTH_FLOAT
+            _mm_storeu_ps(depths + i, _mm_or_ps(_mm_and_ps(depthPass, zv), _mm_andnot_ps(depthPass, dstDepth)));
+            #elif _SPAN_DEPTH_WRITE
+            _span_store_depths_sse2(depths + i, _mm_or_si128(_mm_and_si128(mask, depth), _mm_andnot_si128(mask, dstDepth)));
+            #endif
+
+            #if _SPAN_FLAT
+
+            // Write flat color of the visible pixels
+            PRint dst;
+            memcpy(&dst, colors + i, 4);
+            __m128i v = _mm_cvtsi32_si128(dst);
+            v = _mm_or_si128(_mm_and_si128(byteMask, colorBytes), _mm_andnot_si128(byteMask, v));
+            dst = _mm_cvtsi128_si32(v);
+            memcpy(colors + i, &dst, 4);
+
+            #else
+
+            // Write color index of the visible pixels (texels are only gathered for them)
+            for (PRint j = 0; j < 4; ++j)
+            {
+                if ((laneMask >> j) & 0x1)
+                    colors[i + j] = _SPAN_GATHER(j);
+            }
+
+            #endif
+        }
+
+        // Next 4 pixels
+        z += zGroupStep;
+        #if !_SPAN_FLAT
+        u += uGroupStep;
+        v += vGroupStep;
+        #endif
+    }
+
+    return i;
+}
+
+#if _SPAN_DEPTH_WRITE && !_SPAN_FLAT && !_SPAN_TEXTURE_POT && !_SPAN_TEXTURE_LINEAR
+
+// Rasterizes 4 pixels per iteration into the depth buffer only and returns the number of processed pixels.
+static PRint _SPAN_KERNEL(_span_rasterize_depth_sse2)(const pr_span* span)
+{
+    const __m128 laneOffsets    = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    #if !_SPAN_DEPTH_FLOAT
+    const __m128 depthMax       = _mm_set1_ps((PRfloat)PR_DEPTH_MAX);
+    const __m128i depthMask     = _mm_set1_epi32(PR_DEPTH_MAX);
+    #endif
+
+    const __m128 zStep = _mm_mul_ps(laneOffsets, _mm_set1_ps(PR_INTERP_ACC_TO_FLOAT(span->zStep)));
+
+    _SPAN_DEPTH_TYPE* depths = span->depths;
+    PRinterpacc z = span->z;
+    PRint i = 0;
+
+    for (; i + 4 <= span->length; i += 4)
+    {
+        // Interpolate depth and make depth test against the depth of all 4 pixels
+        __m128 zv = _mm_add_ps(_mm_set1_ps(PR_INTERP_ACC_TO_FLOAT(z)), zStep);
+
+        #if _SPAN_DEPTH_FLOAT
+
+        __m128 dstDepth = _mm_loadu_ps(depths + i);
+        __m128 depthPass = _SPAN_DEPTH_PASS_PS(zv, dstDepth);
+
+        // Write depth of the visible pixels
+        _mm_storeu_ps(depths + i, _mm_or_ps(_mm_and_ps(depthPass, zv), _mm_andnot_ps(depthPass, dstDepth)));
+
+        #else
+
+        __m128i depth = _span_bias_depths_sse2(_mm_and_si128(_mm_cvttps_epi32(_mm_mul_ps(zv, depthMax)), depthMask));
+
+        __m128i dstDepth = _span_load_depths_sse2(depths + i);
+        __m128i mask = _SPAN_DEPTH_PASS_SIMD(depth, dstDepth);
+
+        // Write depth of the visible pixels
+        _span_store_depths_sse2(depths + i, _mm_or_si128(_mm_and_si128(mask, depth), _mm_andnot_si128(mask, dstDepth)));
+
+        #endif
+
+        z += span->zStep * 4;
+    }
+
+    return i;
+}
+
+#endif
+
+#elif defined(_SPAN_AVX2)
+
+#if _SPAN_DEPTH_TEST
+
+/*
+Makes the depth test for the last (incomplete) group of a span one pixel at a time, so that no pixel outside the span is touched.
+The depths are still interpolated with SIMD, so that the result does not depend on the position of the group.
+Returns the lane mask of the visible pixels.
+*/
+#if _SPAN_DEPTH_FLOAT
+PR_INLINE PRint _SPAN_KERNEL(_span_depth_test_tail_avx2)(PRfloat* depths, __m256 depth, PRint count)
+#else
+PR_INLINE PRint _SPAN_KERNEL(_span_depth_test_tail_avx2)(PRdepthtype* depths, __m128i depth, PRint count)
+#endif
+{
+    _SPAN_DEPTH_TYPE laneDepths[8];
+    #if _SPAN_DEPTH_FLOAT
+    _mm256_storeu_ps(laneDepths, depth);
+    #else
+    _span_store_depths_avx2(laneDepths, depth);
+    #endif
+
+    PRint laneMask = 0;
+
+    // Select instead of branch, because the depth test is hardly predictable for single pixels
+    for (PRint j = 0; j < count; ++j)
+    {
+        PRint visible = _SPAN_DEPTH_PASS(laneDepths[j], depths[j]);
+        #if _SPAN_DEPTH_WRITE
+        depths[j] = (visible ? laneDepths[j] : depths[j]);
+        #endif
+        laneMask |= (visible << j);
+    }
+
+    return laneMask;
+}
+
+#endif
+
+/*
+Rasterizes 8 pixels per iteration and returns the number of processed pixels (always the entire span).
+The last group is processed like the others if it fits into the span and its slack, otherwise one pixel at a time.
+*/
+static PRint _SPAN_KERNEL(_span_rasterize_avx2)(const pr_span* span, const PRcolorindex* texels, PRtexsize mipWidth, PRtexsize mipHeight)
+{
+    #if _SPAN_FLAT
+    // Flat spans do not sample the texture
+    (void)texels;
+    (void)mipWidth;
+    (void)mipHeight;
+    #endif
+
+    const __m256 laneOffsets    = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    #if _SPAN_DEPTH_TEST && _SPAN_DEPTH_FLOAT
+    const __m256i laneIndices   = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    #elif _SPAN_DEPTH_TEST
+    const __m128i laneIndices   = _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256 depthMax       = _mm256_set1_ps((PRfloat)PR_DEPTH_MAX);
+    const __m256i depthMask     = _mm256_set1_epi32(PR_DEPTH_MAX);
+    #endif
+    #if _SPAN_DEPTH_TEST
+    _SPAN_DEPTH_TYPE* depths    = span->depths;
+    #endif
+    #if _SPAN_FLAT
+    const PRcolorindex color    = span->color;
+    const __m128i colorBytes    = _mm_set1_epi8((char)color);
+    #else
+    #if !_SPAN_TEXTURE_LINEAR
+    const __m256 width          = _mm256_set1_ps((PRfloat)mipWidth);
+    const __m256 height         = _mm256_set1_ps((PRfloat)mipHeight);
+    #if _SPAN_TEXTURE_POT
+    const __m256i widthMask     = _mm256_set1_epi32(mipWidth - 1);
+    const __m256i heightMask    = _mm256_set1_epi32(mipHeight - 1);
+    #else
+    const __m256i widthInt      = _mm256_set1_epi32(mipWidth);
+    const __m256i heightInt     = _mm256_set1_epi32(mipHeight);
+    #endif
+    const __m256i pitch         = _mm256_set1_epi32(_pr_texture_texel_pitch(mipWidth));
+    #endif
+    const __m256 uStep          = _mm256_mul_ps(laneOffsets, _mm256_set1_ps(PR_INTERP_ACC_TO_FLOAT(span->uStep)));
+    const __m256 vStep          = _mm256_mul_ps(laneOffsets, _mm256_set1_ps(PR_INTERP_ACC_TO_FLOAT(span->vStep)));
+    const PRinterpacc uGroupStep = span->uStep * 8;
+    const PRinterpacc vGroupStep = span->vStep * 8;
+    PRinterpacc u = span->u, v = span->v;
+    #if _SPAN_TEXTURE_LINEAR
+    PRfloat uCoords[8], vCoords[8];
+    #else
+    PRint indices[8];
+    #endif
+    #endif
+
+    const __m256 zStep = _mm256_mul_ps(laneOffsets, _mm256_set1_ps(PR_INTERP_ACC_TO_FLOAT(span->zStep)));
+    const PRinterpacc zGroupStep = span->zStep * 8;
+
+    PRcolorindex* colors = span->colors;
+    const PRint length = span->length;
+    #if _SPAN_DEPTH_TEST
+    const PRint slack = span->slack;
+    #endif
+
+    PRinterpacc z = span->z;
+
+    for (PRint i = 0; i < length; i += 8)
+    {
+        const PRint remaining = length - i;
+        __m256 zv = _mm256_add_ps(_mm256_set1_ps(PR_INTERP_ACC_TO_FLOAT(z)), zStep);
+
+        #if _SPAN_DEPTH_TEST
+
+        const PRboolean fullGroup = (remaining + slack >= 8);
+
+        // Interpolate depth of all 8 pixels
+        #if _SPAN_DEPTH_FLOAT
+        const __m256 depth = zv;
+        #else
+        __m128i depth = _span_bias_depths_avx2(_mm256_and_si256(_mm256_cvttps_epi32(_mm256_mul_ps(zv, depthMax)), depthMask));
+        #endif
+        __m128i mask = _mm_setzero_si128();
+        PRint laneMask;
+
+        if (fullGroup)
+        {
+            // Make depth test against the depth of all 8 pixels and write depth of the visible pixels
+            #if _SPAN_DEPTH_FLOAT
+
+            __m256 dstDepth = _mm256_loadu_ps(depths + i);
+            __m256 depthPass = _SPAN_DEPTH_PASS_PS256(depth, dstDepth);
+            if (remaining < 8)
+                depthPass = _mm256_and_ps(depthPass, _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(remaining), laneIndices)));
+            mask = _span_pack_mask_avx2(depthPass);
+            laneMask = _mm_movemask_epi8(_mm_packs_epi16(mask, mask)) & 0xff;
+
+            #if _SPAN_DEPTH_WRITE
+            if (laneMask != 0)
+                _mm256_storeu_ps(depths + i, _mm256_blendv_ps(dstDepth, depth, depthPass));
+            #endif
+
+            #else
+
+            __m128i dstDepth = _span_load_depths_avx2(depths + i);
+            mask = _SPAN_DEPTH_PASS_SIMD(depth, dstDepth);
+            if (remaining < 8)
+                mask = _mm_and_si128(mask, _mm_cmpgt_epi16(_mm_set1_epi16((short)remaining), laneIndices));
+            laneMask = _mm_movemask_epi8(_mm_packs_epi16(mask, mask)) & 0xff;
+
+            #if _SPAN_DEPTH_WRITE
+            if (laneMask != 0)
+                _span_store_depths_avx2(depths + i, _mm_blendv_epi8(dstDepth, depth, mask));
+            #endif
+
+            #endif
+        }
+        else
+            laneMask = _SPAN_KERNEL(_span_depth_test_tail_avx2)(depths + i, depth, remaining);
+
+        #else
+
+        PRint laneMask = (remaining >= 8 ? 0xff : (1 << remaining) - 1);
+
+        #endif
+
+        if (laneMask != 0)
+        {
+            #if _SPAN_FLAT
+
+            if (fullGroup)
+            {
+                // Write flat color of the visible pixels
+                __m128i dst = _mm_loadl_epi64((const __m128i*)(colors + i));
+                _mm_storel_epi64((__m128i*)(colors + i), _mm_blendv_epi8(dst, colorBytes, _mm_packs_epi16(mask, mask)));
+            }
+            else
+            {
+                for (PRint j = 0; j < remaining; ++j)
+                    colors[i + j] = (((laneMask >> j) & 0x1) ? color : colors[i + j]);
+            }
+
+            #else
+
+            __m256 uv = _mm256_add_ps(_mm256_set1_ps(PR_INTERP_ACC_TO_FLOAT(u)), uStep);
+            __m256 vv = _mm256_add_ps(_mm256_set1_ps(PR_INTERP_ACC_TO_FLOAT(v)), vStep);
+
+            #ifdef PR_PERSPECTIVE_CORRECTED
+            // Compute perspective corrected texture coordinates
+            __m256 w = _mm256_div_ps(_mm256_set1_ps(1.0f), zv);
+            uv = _mm256_mul_ps(uv, w);
+            vv = _mm256_mul_ps(vv, w);
+            #endif
+
+            #if _SPAN_TEXTURE_LINEAR
+            _mm256_storeu_ps(uCoords, uv);
+            _mm256_storeu_ps(vCoords, vv);
+            #else
+            // Compute texel indices
+            #if _SPAN_TEXTURE_POT
+            __m256i x = _span_texel_coord_pot_avx2(uv, width, widthMask);
+            __m256i y = _span_texel_coord_pot_avx2(vv, height, heightMask);
+            #else
+            __m256i x = _span_texel_coord_avx2(uv, width, widthInt);
+            __m256i y = _span_texel_coord_avx2(vv, height, heightInt);
+            #endif
+            _mm256_storeu_si256((__m256i*)indices, _span_texel_index_avx2(x, y, pitch));
+            #endif
+
+            // Write color index of the visible pixels (texels are only gathered for them)
+            if (laneMask == 0xff)
+            {
+                for (PRint j = 0; j < 8; ++j)
+                    colors[i + j] = _SPAN_GATHER(j);
+            }
+            else
+            {
+                for (PRint j = 0; j < 8; ++j)
+                {
+                    if ((laneMask >> j) & 0x1)
+                        colors[i + j] = _SPAN_GATHER(j);
+                }
+            }
+
+            #endif
+        }
+
+        // Next 8 pixels
+        z += zGroupStep;
+        #if !_SPAN_FLAT
+        u += uGroupStep;
+        v += vGroupStep;
+        #endif
+    }
+
+    return length;
+}
+
+#if _SPAN_DEPTH_WRITE && !_SPAN_FLAT && !_SPAN_TEXTURE_POT && !_SPAN_TEXTURE_LINEAR
+
+// Rasterizes 8 pixels per iteration into the depth buffer only and returns the number of processed pixels (always the entire span).
+static PRint _SPAN_KERNEL(_span_rasterize_depth_avx2)(const pr_span* span)
+{
+    const __m256 laneOffsets    = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    #if _SPAN_DEPTH_FLOAT
+    const __m256i laneIndices   = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    #else
+    const __m128i laneIndices   = _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256 depthMax       = _mm256_set1_ps((PRfloat)PR_DEPTH_MAX);
+    const __m256i depthMask     = _mm256_set1_epi32(PR_DEPTH_MAX);
+    #endif
+
+    const __m256 zStep = _mm256_mul_ps(laneOffsets, _mm256_set1_ps(PR_INTERP_ACC_TO_FLOAT(span->zStep)));
+
+    _SPAN_DEPTH_TYPE* depths = span->depths;
+    PRinterpacc z = span->z;
+
+    for (PRint i = 0; i < span->length; i += 8)
+    {
+        const PRint remaining = span->length - i;
+
+        // Interpolate depth of all 8 pixels
+        __m256 zv = _mm256_add_ps(_mm256_set1_ps(PR_INTERP_ACC_TO_FLOAT(z)), zStep);
+        #if _SPAN_DEPTH_FLOAT
+        const __m256 depth = zv;
+        #else
+        __m128i depth = _span_bias_depths_avx2(_mm256_and_si256(_mm256_cvttps_epi32(_mm256_mul_ps(zv, depthMax)), depthMask));
+        #endif
+
+        if (remaining + span->slack >= 8)
+        {
+            // Make depth test against the depth of all 8 pixels and write depth of the visible pixels
+            #if _SPAN_DEPTH_FLOAT
+            __m256 dstDepth = _mm256_loadu_ps(depths + i);
+            __m256 depthPass = _SPAN_DEPTH_PASS_PS256(depth, dstDepth);
+            if (remaining < 8)
+                depthPass = _mm256_and_ps(depthPass, _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(remaining), laneIndices)));
+            _mm256_storeu_ps(depths + i, _mm256_blendv_ps(dstDepth, depth, depthPass));
+            #else
+            __m128i dstDepth = _span_load_depths_avx2(depths + i);
+            __m128i mask = _SPAN_DEPTH_PASS_SIMD(depth, dstDepth);
+            if (remaining < 8)
+                mask = _mm_and_si128(mask, _mm_cmpgt_epi16(_mm_set1_epi16((short)remaining), laneIndices));
+            _span_store_depths_avx2(depths + i, _mm_blendv_epi8(dstDepth, depth, mask));
+            #endif
+        }
+        else
+            _SPAN_KERNEL(_span_depth_test_tail_avx2)(depths + i, depth, remaining);
+
+        z += span->zStep * 8;
+    }
+
+    return span->length;
+}
+
+#endif
+
+#endif
+
+// Rasterizes the span: makes the depth test for each pixel and writes the sampled texel (or the flat color) on success.
+static void _SPAN_KERNEL(_span_rasterize)(const pr_span* span, const PRcolorindex* texels, PRtexsize mipWidth, PRtexsize mipHeight)
+{
+    #if _SPAN_FLAT
+    // Flat spans do not sample the texture
+    (void)texels;
+    (void)mipWidth;
+    (void)mipHeight;
+    #endif
+
+    #if defined(_SPAN_AVX2)
+    PRint i = _SPAN_KERNEL(_span_rasterize_avx2)(span, texels, mipWidth, mipHeight);
+    #elif defined(_SPAN_SSE2)
+    PRint i = _SPAN_KERNEL(_span_rasterize_sse2)(span, texels, mipWidth, mipHeight);
+    #else
+    PRint i = 0;
+    #endif
+
+    PRcolorindex* colors = span->colors;
+    #if _SPAN_DEPTH_TEST
+    _SPAN_DEPTH_TYPE* depths = span->depths;
+    #endif
+    #if _SPAN_FLAT
+    const PRcolorindex color = span->color;
+    #else
+    const PRinterpacc uStep = span->uStep;
+    const PRinterpacc vStep = span->vStep;
+    #endif
+    const PRinterpacc zStep = span->zStep;
+    const PRint length = span->length;
+
+    // Rasterize remaining pixels
+    PRinterpacc z = span->z + zStep * i;
+    #if !_SPAN_FLAT
+    PRinterpacc u = span->u + uStep * i;
+    PRinterpacc v = span->v + vStep * i;
+    #endif
+
+    for (; i < length; ++i)
+    {
+        #if _SPAN_DEPTH_TEST
+        // Make depth test
+        _SPAN_DEPTH_TYPE depth = _SPAN_DEPTH_FROM_ACC(z);
+
+        if (_SPAN_DEPTH_PASS(depth, depths[i]))
+        #endif
+        {
+            #if _SPAN_DEPTH_WRITE
+            depths[i] = depth;
+            #endif
+            #if _SPAN_FLAT
+            colors[i] = color;
+            #else
+            colors[i] = _span_sample_texel(
+                PR_INTERP_ACC_TO_INTERP(z), PR_INTERP_ACC_TO_INTERP(u), PR_INTERP_ACC_TO_INTERP(v), texels, mipWidth, mipHeight, _SPAN_SAMPLER
+            );
+            #endif
+        }
+
+        z += zStep;
+        #if !_SPAN_FLAT
+        u += uStep;
+        v += vStep;
+        #endif
+    }
+}
+
+#if defined(PR_PERSPECTIVE_CORRECTED) && !defined(_SPAN_AVX2) && !defined(_SPAN_SSE2) && !_SPAN_FLAT && !_SPAN_TEXTURE_LINEAR
+
+// Rasterizes the span with perspective correction only at every n-th pixel (see pr_span::subspanLength).
+static void _SPAN_KERNEL(_span_rasterize_subspan)(const pr_span* span, const PRcolorindex* texels, PRtexsize mipWidth, PRtexsize mipHeight)
+{
+    const PRint subspanLength = span->subspanLength;
+
+    const PRint length = span->length;
+
+    if (mipWidth == 0 || mipHeight == 0 || length <= subspanLength)
+    {
+        // Untextured polygons and short spans are rasterized per pixel (the subspan setup costs more than it saves)
+        _SPAN_KERNEL(_span_rasterize)(span, texels, mipWidth, mipHeight);
+        return;
+    }
+
+    const PRint width   = (PRint)mipWidth << 16;
+    const PRint height  = (PRint)mipHeight << 16;
+    const PRint pitch   = _pr_texture_texel_pitch(mipWidth);
+    #if _SPAN_TEXTURE_POT
+    const PRint widthMask   = width - 1;
+    const PRint heightMask  = height - 1;
+    #endif
+
+    // Subspan length is a power of two, so the steps of full subspans can be computed with shifts
+    PRint shift = 0;
+    while ((1 << shift) < subspanLength)
+        ++shift;
+
+    PRcolorindex* colors = span->colors;
+    #if _SPAN_DEPTH_TEST
+    _SPAN_DEPTH_TYPE* depths = span->depths;
+    #endif
+    const PRinterpacc zStep = span->zStep;
+
+    PRinterpacc z = span->z;
+    PRfloat u, v, uEnd, vEnd;
+    PRint i, j, n, end, s, t, sEnd, tEnd, sStep, tStep;
+
+    // Compute exact texture coordinates at the start of the first subspan
+    _span_texcoord_at(span, 0, &u, &v);
+
+    s = _span_wrap_texel_coord(u, mipWidth);
+    t = _span_wrap_texel_coord(v, mipHeight);
+
+    for (i = 0; i < length; i += n)
+    {
+        n = PR_MIN(subspanLength, length - i);
+
+        // Compute exact texture coordinates at the start of the next subspan (clamped to the last pixel of the span)
+        end = PR_MIN(i + n, length - 1);
+        _span_texcoord_at(span, end, &uEnd, &vEnd);
+
+        sEnd = _span_wrap_texel_coord(uEnd, mipWidth);
+        tEnd = _span_wrap_texel_coord(vEnd, mipHeight);
+
+        // Interpolate texel coordinates linearly in between (16.16 fixed-point, wrapped into the MIP-map)
+        sStep = (PRint)((uEnd - u) * (PRfloat)width);
+        tStep = (PRint)((vEnd - v) * (PRfloat)height);
+
+        if (end - i == subspanLength)
+        {
+            sStep >>= shift;
+            tStep >>= shift;
+        }
+        else if (end > i)
+        {
+            sStep /= (end - i);
+            tStep /= (end - i);
+        }
+
+        #if !_SPAN_TEXTURE_POT
+        // Steps larger than the MIP-map only occur for strongly minified textures
+        if (sStep >= width || sStep <= -width)
+            sStep %= width;
+        if (tStep >= height || tStep <= -height)
+            tStep %= height;
+        #endif
+
+        for (j = i; j < i + n; ++j)
+        {
+            #if _SPAN_DEPTH_TEST
+            _SPAN_DEPTH_TYPE depth = _SPAN_DEPTH_FROM_ACC(z);
+
+            if (_SPAN_DEPTH_PASS(depth, depths[j]))
+            #endif
+            {
+                #if _SPAN_DEPTH_WRITE
+                depths[j] = depth;
+                #endif
+                colors[j] = texels[_pr_texture_texel_index(s >> 16, t >> 16, pitch)];
+            }
+
+            z += zStep;
+
+            #if _SPAN_TEXTURE_POT
+            s = (s + sStep) & widthMask;
+            t = (t + tStep) & heightMask;
+            #else
+            s += sStep;
+            if (s >= width)
+                s -= width;
+            else if (s < 0)
+                s += width;
+
+            t += tStep;
+            if (t >= height)
+                t -= height;
+            else if (t < 0)
+                t += height;
+            #endif
+        }
+
+        // Continue with the exact coordinates to avoid accumulating errors
+        u = uEnd;
+        v = vEnd;
+        s = sEnd;
+        t = tEnd;
+    }
+}
+
+#endif
+
+#if _SPAN_DEPTH_WRITE && !_SPAN_FLAT && !_SPAN_TEXTURE_POT && !_SPAN_TEXTURE_LINEAR
+
+// Rasterizes the span into the depth buffer only (the texture parameters are unused).
+static void _SPAN_KERNEL(_span_rasterize_depth)(const pr_span* span, const PRcolorindex* texels, PRtexsize mipWidth, PRtexsize mipHeight)
+{
+    (void)texels;
+    (void)mipWidth;
+    (void)mipHeight;
+
+    #if defined(_SPAN_AVX2)
+    PRint i = _SPAN_KERNEL(_span_rasterize_depth_avx2)(span);
+    #elif defined(_SPAN_SSE2)
+    PRint i = _SPAN_KERNEL(_span_rasterize_depth_sse2)(span);
+    #else
+    PRint i = 0;
+    #endif
+
+    // Rasterize remaining pixels
+    _SPAN_DEPTH_TYPE* depths = span->depths;
+    PRinterpacc z = span->z + span->zStep * i;
+
+    for (; i < span->length; ++i)
+    {
+        _SPAN_DEPTH_TYPE depth = _SPAN_DEPTH_FROM_ACC(z);
+
+        if (_SPAN_DEPTH_PASS(depth, depths[i]))
+            depths[i] = depth;
+
+        z += span->zStep;
+    }
+}
+
+#endif
+
+
+#undef _SPAN_DEPTH_PASS
+#undef _SPAN_DEPTH_PASS_SIMD
+#undef _SPAN_DEPTH_PASS_PS
+#undef _SPAN_DEPTH_PASS_PS256
+#undef _SPAN_DEPTH_TYPE
+#undef _SPAN_DEPTH_FROM_ACC
+#undef _SPAN_SAMPLER
+#undef _SPAN_GATHER
+
+#undef _SPAN_DEPTH_TEST
+#undef _SPAN_DEPTH_WRITE
+#undef _SPAN_DEPTH_GEQUAL
+#undef _SPAN_FLAT
+#undef _SPAN_DEPTH_FLOAT
+#undef _SPAN_TEXTURE_POT
+#undef _SPAN_TEXTURE_LINEAR
+#undef _SPAN_KERNEL
@@ -121,11 +121,19 @@ void _pr_state_machine_init(pr_state_machine* stateMachine)
     stateMachine->clearColor                = _pr_color_to_colorindex(0, 0, 0);
     stateMachine->color0                    = _pr_color_to_colorindex(0, 0, 0);
     stateMachine->textureLodBias            = 0;
+    stateMachine->textureSubspanLength      = 0;
+    stateMachine->textureFilter             = PR_NEAREST;
     stateMachine->cullMode                  = PR_CULL_NONE;
     stateMachine->polygonMode               = PR_POLYGON_FILL;
+    stateMachine->rasterizerMode            = PR_RASTERIZER_SCANLINE;
+    stateMachine->depthFunc                 = PR_DEPTH_GREATER;
+
+    stateMachine->colorMask                 = PR_TRUE;
+    stateMachine->depthMask                 = PR_TRUE;
 
     stateMachine->states[PR_SCISSOR]        = PR_FALSE;
     stateMachine->states[PR_MIP_MAPPING]    = PR_FALSE;
+    stateMachine->states[PR_DEPTH_TEST]     = PR_TRUE;
 
     stateMachine->refCounter                = 0;
 }
@@ -180,6 +188,23 @@ void _pr_state_machine_set_texenvi(PRenum param, PRint value)
         case PR_TEXTURE_LOD_BIAS:
             PR_STATE_MACHINE.textureLodBias = (PRubyte)PR_CLAMP(value, 0, 255);
             break;
+        case PR_TEXTURE_PERSPECTIVE_SUBSPAN:
+            if (value != 0 && (value < 2 || value > 64 || (value & (value - 1)) != 0))
+                PR_ERROR(PR_ERROR_INVALID_ARGUMENT);
+            else
+                PR_STATE_MACHINE.textureSubspanLength = value;
+            break;
+        case PR_TEXTURE_FILTER:
+            if (value != PR_NEAREST && value != PR_LINEAR)
+                PR_ERROR(PR_ERROR_INVALID_ARGUMENT);
+            else
+            {
+                // Build the blend tables before any draw call may sample from them in parallel
+                if (value == PR_LINEAR)
+                    _pr_texture_blend_table_init();
+                PR_STATE_MACHINE.textureFilter = (PRenum)value;
+            }
+            break;
         default:
             PR_ERROR(PR_ERROR_INDEX_OUT_OF_BOUNDS);
             break;
@@ -192,6 +217,10 @@ PRint _pr_state_machine_get_texenvi(PRenum param)
     {
         case PR_TEXTURE_LOD_BIAS:
             return (PRint)PR_STATE_MACHINE.textureLodBias;
+        case PR_TEXTURE_PERSPECTIVE_SUBSPAN:
+            return PR_STATE_MACHINE.textureSubspanLength;
+        case PR_TEXTURE_FILTER:
+            return (PRint)PR_STATE_MACHINE.textureFilter;
         default:
             PR_ERROR(PR_ERROR_INDEX_OUT_OF_BOUNDS);
             return 0;
@@ -293,6 +322,22 @@ void _pr_state_machine_polygon_mode(PRenum mode)
         PR_STATE_MACHINE.polygonMode = mode;
 }
 
+void _pr_state_machine_rasterizer_mode(PRenum mode)
+{
+    if (mode < PR_RASTERIZER_SCANLINE || mode > PR_RASTERIZER_HALFSPACE)
+        PR_ERROR(PR_ERROR_INVALID_ARGUMENT);
+    else
+        PR_STATE_MACHINE.rasterizerMode = mode;
+}
+
+void _pr_state_machine_depth_func(PRenum func)
+{
+    if (func < PR_DEPTH_GREATER || func > PR_DEPTH_GEQUAL)
+        PR_ERROR(PR_ERROR_INVALID_ARGUMENT);
+    else
+        PR_STATE_MACHINE.depthFunc = func;
+}
+
 static void _update_viewprojection_matrix()
 {
     _pr_matrix_mul_matrix(
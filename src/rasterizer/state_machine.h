@@ -20,7 +20,7 @@
 
 
 #define PR_STATE_MACHINE    (*_stateMachine)
-#define PR_NUM_STATES       2
+#define PR_NUM_STATES       3
 
 
 typedef struct pr_state_machine
@@ -46,9 +46,16 @@ typedef struct pr_state_machine
     PRcolorindex        clearColor;
     PRcolorindex        color0;                 // Active color index
     PRubyte             textureLodBias;
+    PRint               textureSubspanLength;   // Number of pixels between two perspective divisions (0 for each pixel)
+    PRenum              textureFilter;          // PR_NEAREST or PR_LINEAR
 
     PRenum              cullMode;
     PRenum              polygonMode;
+    PRenum              rasterizerMode;
+    PRenum              depthFunc;
+
+    PRboolean           colorMask;              // Color buffer write mask
+    PRboolean           depthMask;              // Depth buffer write mask
 
     PRboolean           states[PR_NUM_STATES];
 
@@ -86,6 +93,8 @@ void _pr_state_machine_depth_range(PRfloat minDepth, PRfloat maxDepth);
 void _pr_state_machine_scissor(PRint x, PRint y, PRint width, PRint height);
 void _pr_state_machine_cull_mode(PRenum mode);
 void _pr_state_machine_polygon_mode(PRenum mode);
+void _pr_state_machine_rasterizer_mode(PRenum mode);
+void _pr_state_machine_depth_func(PRenum func);
 
 void _pr_state_machine_projection_matrix(const pr_matrix4* matrix);
 void _pr_state_machine_view_matrix(const pr_matrix4* matrix);
@@ -42,17 +42,56 @@
 //! Use a 64-bit interpolation type instead of 32-bit
 #define PR_INTERP_64BIT
 
+/**
+Use fixed-point arithmetic for rasterization instead of floating-point interpolation:
+28.4 sub-pixel screen coordinates and 16.16 depth and texture coordinates (overrides PR_INTERP_64BIT).
+*/
+//#define PR_FIXED_POINT
+
 //! Use a 24-bit color buffer (instead of 8 bit)
 //#define PR_COLOR_BUFFER_24BIT
 
-//! Merge color- and depth buffers to a single one inside a frame buffer.
-#define PR_MERGE_COLOR_AND_DEPTH_BUFFERS //!CAN NOT BE DISABLED YET!
-
 //! Makes all pixels with color black a transparent pixel.
 #define PR_BLACK_IS_ALPHA
 
+//! Rasterizes the screen tiles in parallel (uses Win32 threads or POSIX threads).
+#define PR_MULTI_THREADING
+
+//! Maximal number of threads for the tile rasterizer (including the calling thread).
+#define PR_MAX_NUM_THREADS  16
+
+//! Width and height (in pixels) of the screen tiles polygons are binned into.
+#define PR_TILE_SIZE        64
+
+/**
+Stores the texels of each MIP level in blocks of 8x8 texels (64 bytes, i.e. one cache line) instead of plain rows,
+so that sampling a texture at an angle (e.g. a rotated floor) touches fewer cache lines.
+*/
+//#define PR_TEXTURE_BLOCKS
+
+/**
+Generates the MIP levels of a texture when they are needed for the first time by a draw call, instead of when the image is set.
+The image of the first MIP level is kept in the texture until then, so that reloaded but undrawn textures do not generate their MIP chain.
+*/
+//#define PR_TEXTURE_LAZY_MIPS
 
-#ifdef PR_INTERP_64BIT
+//! Size (in pixels) of the guard band around the viewport. Filled polygons inside the guard band are not clipped in screen space.
+#define PR_GUARD_BAND       2048
+
+//! Use SSE2 or AVX2 span kernels if the compiler targets these instruction sets
+#if defined(__AVX2__)
+#   define PR_SIMD_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define PR_SIMD_SSE2
+#endif
+
+
+#if defined(PR_FIXED_POINT)
+//! 32-bit fixed-point interpolation type (16.16 format, see "fixed_point.h").
+typedef int PRinterp;
+#define PR_FLOAT(x) x##f
+#elif defined(PR_INTERP_64BIT)
 //! 64-bit interpolation type.
 typedef double PRinterp;
 #define PR_FLOAT(x) x
@@ -10,6 +10,7 @@
 #include "error.h"
 #include "helper.h"
 #include "image.h"
+#include "color_palette.h"
 #include "state_machine.h"
 #include "enums.h"
 
@@ -17,122 +18,519 @@
 #include <stdlib.h>
 #include <string.h>
 
+// SIMD 2x2 filter for the MIP chain generation
+#ifdef PR_SIMD_SSE2
+#   include <emmintrin.h>
+#   define _TEXTURE_SSE2
+#endif
+
 
 // --- internals --- //
 
-static void _texture_subimage2d(
-    PRcolorindex* texels, PRubyte mip, PRtexsize width, PRtexsize height, PRenum format, const PRvoid* data, PRboolean dither)
+// Scratch arena for the MIP chain generation and the sub-image updates (see _texture_generate_mips and _texture_subimage2d_rect).
+static PRubyte* _mipArena = NULL;
+static size_t _mipArenaSize = 0;
+
+// Scratch arena for the color index conversion of one MIP level (see _texture_store_colors), while the MIP arena holds the colors.
+static PRubyte* _convertArena = NULL;
+static size_t _convertArenaSize = 0;
+
+// Returns the arena with at least the specified size in bytes. Its previous content is lost when it grows.
+static PRubyte* _texture_grow_arena(PRubyte** arena, size_t* arenaSize, size_t size)
 {
-    if (format != PR_UBYTE_RGB)
+    if (*arenaSize < size)
     {
-        _pr_error_set(PR_ERROR_INVALID_ARGUMENT, __FUNCTION__);
-        return;
+        PR_FREE(*arena);
+        *arena = PR_CALLOC(PRubyte, size);
+        *arenaSize = size;
+    }
+    return *arena;
+}
+
+static PRubyte* _texture_scratch(size_t size)
+{
+    return _texture_grow_arena(&_mipArena, &_mipArenaSize, size);
+}
+
+static PRubyte* _texture_convert_scratch(size_t size)
+{
+    return _texture_grow_arena(&_convertArena, &_convertArenaSize, size);
+}
+
+// Returns the width or height of the specified MIP level (dimensions of 1 are not halved).
+PR_INLINE PRtexsize _texture_mip_size(PRtexsize size, PRubyte mip)
+{
+    size >>= mip;
+    return (size > 0 ? size : 1);
+}
+
+#ifndef PR_COLOR_BUFFER_24BIT
+
+// Color indices of the blended color index pairs for the fractions 1..(PR_TEXTURE_BLEND_WEIGHTS-1) (see _pr_texture_blend_table_init).
+static PRcolorindex _blendTable[PR_TEXTURE_BLEND_WEIGHTS - 1][256][256];
+static PRboolean _blendTableReady = PR_FALSE;
+
+#endif
+
+// Blends the colors (or color indices) 'a' and 'b' with the fraction 'weight/PR_TEXTURE_BLEND_WEIGHTS' of 'b'.
+PR_INLINE PRcolorindex _texture_blend(PRcolorindex a, PRcolorindex b, PRint weight)
+{
+    #ifdef PR_COLOR_BUFFER_24BIT
+    const PRint invWeight = PR_TEXTURE_BLEND_WEIGHTS - weight;
+    a.r = (PRubyte)((a.r*invWeight + b.r*weight) >> PR_TEXTURE_BLEND_SHIFT);
+    a.g = (PRubyte)((a.g*invWeight + b.g*weight) >> PR_TEXTURE_BLEND_SHIFT);
+    a.b = (PRubyte)((a.b*invWeight + b.b*weight) >> PR_TEXTURE_BLEND_SHIFT);
+    return a;
+    #else
+    return (weight == 0 ? a : _blendTable[weight - 1][a][b]);
+    #endif
+}
+
+/*
+Converts the texture coordinate into the coordinate of the left (or upper) texel of a bilinear sample, which is wrapped into [-1, size),
+and stores the fraction of the right (or lower) texel in units of 1/PR_TEXTURE_BLEND_WEIGHTS in 'weight'.
+*/
+PR_INLINE PRint _texture_linear_coord(PRfloat t, PRtexsize size, PRint* weight)
+{
+    PRfloat frac = t - (PRfloat)(PRint)t;
+    if (frac < 0.0f)
+        frac += 1.0f;
+
+    // Shift by half a texel to the texel centers and round to the nearest fraction (the argument of the cast is non-negative)
+    const PRint x = (PRint)(frac * (PRfloat)(size << PR_TEXTURE_BLEND_SHIFT) + 0.5f) - PR_TEXTURE_BLEND_WEIGHTS/2;
+
+    *weight = (x & (PR_TEXTURE_BLEND_WEIGHTS - 1));
+    return (x >> PR_TEXTURE_BLEND_SHIFT);
+}
+
+#ifdef PR_TEXTURE_BLOCKS
+
+// Copies the row-major texels into the block order of the texture (see '_pr_texture_texel_index').
+static void _texture_store_blocks(PRcolorindex* dst, const PRcolorindex* src, PRtexsize width, PRtexsize height)
+{
+    const PRint pitch = _pr_texture_texel_pitch(width);
+
+    for (PRint y = 0; y < height; ++y)
+    {
+        for (PRint x = 0; x < width; ++x)
+            dst[_pr_texture_texel_index(x, y, pitch)] = *src++;
     }
+}
+
+#endif
 
+// Converts the colors (with 'components' bytes per texel, see pr_image) into the texels of one MIP level.
+static void _texture_store_colors(
+    PRcolorindex* texels, PRtexsize width, PRtexsize height, const PRubyte* colors, PRint components, PRenum dither)
+{
     // Setup structure for sub-image
     pr_image subimage;
     subimage.width      = width;
     subimage.height     = height;
-    subimage.format     = 3;
+    subimage.format     = components;
     subimage.defFree    = PR_TRUE;
-    subimage.colors     = (PRubyte*)data;
+    subimage.colors     = (PRubyte*)colors;
+
+    #ifdef PR_TEXTURE_BLOCKS
+
+    // Convert colors in row-major order first, then store them in texel blocks (the dithering rows follow at an aligned offset)
+    const size_t rowTexelsSize = (sizeof(PRcolorindex)*width*height + 15) & ~(size_t)15;
+    PRubyte* scratch = _texture_convert_scratch(rowTexelsSize + _pr_image_scratch_size(width, dither));
+    PRcolorindex* rowTexels = (PRcolorindex*)scratch;
 
-    _pr_image_color_to_colorindex(texels, &subimage, dither);
+    _pr_image_color_to_colorindex(rowTexels, &subimage, dither, scratch + rowTexelsSize);
+    _texture_store_blocks(texels, rowTexels, width, height);
+
+    #else
+
+    _pr_image_color_to_colorindex(texels, &subimage, dither, _texture_convert_scratch(_pr_image_scratch_size(width, dither)));
+
+    #endif
 }
 
-static void _texture_subimage2d_rect(
-    pr_texture* texture, PRubyte mip, PRtexsize x, PRtexsize y, PRtexsize width, PRtexsize height, PRenum format, const PRvoid* data)
+static void _texture_subimage2d(
+    PRcolorindex* texels, PRtexsize width, PRtexsize height, PRenum format, const PRvoid* data, PRenum dither)
 {
-    //...
+    if (format != PR_UBYTE_RGB)
+    {
+        _pr_error_set(PR_ERROR_INVALID_ARGUMENT, __FUNCTION__);
+        return;
+    }
+
+    _texture_store_colors(texels, width, height, (const PRubyte*)data, 3, dither);
 }
 
-static PRubyte _color_box4_blur(PRubyte a, PRubyte b, PRubyte c, PRubyte d)
+#ifdef _TEXTURE_SSE2
+
+// Loads four RGBx colors, or expands four RGB colors (12 bytes, but 16 bytes are read) into RGBx colors.
+PR_INLINE __m128i _mip_load4_sse2(const PRubyte* src, PRint components)
 {
-    PRint x;
-    x  = a;
-    x += b;
-    x += c;
-    x += d;
-    return (PRubyte)(x / 4);
+    const __m128i colors = _mm_loadu_si128((const __m128i*)src);
+
+    if (components == 4)
+        return colors;
+
+    // Color i needs the bytes [3*i, 3*i + 3), i.e. the packed colors shifted by i bytes
+    return _mm_or_si128(
+        _mm_or_si128(
+            _mm_and_si128(colors, _mm_setr_epi32(0x00ffffff, 0, 0, 0)),
+            _mm_and_si128(_mm_slli_si128(colors, 1), _mm_setr_epi32(0, 0x00ffffff, 0, 0))
+        ),
+        _mm_or_si128(
+            _mm_and_si128(_mm_slli_si128(colors, 2), _mm_setr_epi32(0, 0, 0x00ffffff, 0)),
+            _mm_and_si128(_mm_slli_si128(colors, 3), _mm_setr_epi32(0, 0, 0, 0x00ffffff))
+        )
+    );
 }
 
-static PRubyte _color_box2_blur(PRubyte a, PRubyte b)
+#endif
+
+/*
+Box-filters two rows of RGB colors (with 'components' 3) or RGBx colors (with 'components' 4)
+into one row of 'width' RGBx colors, i.e. each color is the average of 2x2 colors.
+*/
+static void _mip_filter_row(PRubyte* dst, const PRubyte* row0, const PRubyte* row1, PRint width, PRint components)
 {
-    PRint x;
-    x  = a;
-    x += b;
-    return (PRubyte)(x / 2);
+    PRint x = 0;
+
+    #ifdef _TEXTURE_SSE2
+
+    const __m128i zero = _mm_setzero_si128();
+
+    // The last load of RGB colors reads 4 bytes beyond its colors, so keep one more color pair in the rows
+    const PRint simdWidth = (components == 4 ? width : width - 1);
+
+    for (; x + 4 <= simdWidth; x += 4)
+    {
+        const PRint offset = x*2*components;
+
+        const __m128i a0 = _mip_load4_sse2(row0 + offset, components);
+        const __m128i a1 = _mip_load4_sse2(row0 + offset + 4*components, components);
+        const __m128i b0 = _mip_load4_sse2(row1 + offset, components);
+        const __m128i b1 = _mip_load4_sse2(row1 + offset + 4*components, components);
+
+        // Vertical sums with two colors per register (16-bit components)
+        const __m128i s0 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+        const __m128i s1 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+        const __m128i s2 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+        const __m128i s3 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+
+        // Horizontal sums of the even and odd colors
+        const __m128i d0 = _mm_add_epi16(_mm_unpacklo_epi64(s0, s1), _mm_unpackhi_epi64(s0, s1));
+        const __m128i d1 = _mm_add_epi16(_mm_unpacklo_epi64(s2, s3), _mm_unpackhi_epi64(s2, s3));
+
+        _mm_storeu_si128((__m128i*)(dst + x*4), _mm_packus_epi16(_mm_srli_epi16(d0, 2), _mm_srli_epi16(d1, 2)));
+    }
+
+    #endif
+
+    for (; x < width; ++x)
+    {
+        const PRubyte* a = row0 + x*2*components;
+        const PRubyte* b = row1 + x*2*components;
+
+        for (PRint i = 0; i < 3; ++i)
+            dst[x*4 + i] = (PRubyte)((a[i] + a[i + components] + b[i] + b[i + components]) / 4);
+        dst[x*4 + 3] = 0;
+    }
 }
 
-static PRubyte* _image_scale_down_ubyte_rgb(PRtexsize width, PRtexsize height, const PRubyte* data)
+/*
+Scales the RGB image (with 'components' 3) or RGBx image (with 'components' 4) down to half its size into RGBx colors.
+Dimensions of 1 are not halved, so these images are only filtered along the other dimension.
+*/
+static void _mip_scale_down(PRubyte* dst, const PRubyte* src, PRint components, PRtexsize width, PRtexsize height)
 {
-    #define COLOR(x, y, i) data[((y)*width + (x))*3 + (i)]
-
     const PRtexsize scaledWidth = (width > 1 ? width/2 : 1);
     const PRtexsize scaledHeight = (height > 1 ? height/2 : 1);
 
-    PRubyte* scaled = PR_CALLOC(PRubyte, scaledWidth*scaledHeight*3);
+    const PRint pitch = width*components;
 
-    if (width > 1 && height > 1)
+    for (PRtexsize y = 0; y < scaledHeight; ++y, dst += scaledWidth*4)
     {
-        for (PRtexsize y = 0; y < scaledHeight; ++y)
+        // Rows (and columns) of images with a height (or width) of 1 are filtered with themselves
+        const PRubyte* row0 = src + (height > 1 ? y*2 : 0)*pitch;
+        const PRubyte* row1 = (height > 1 ? row0 + pitch : row0);
+
+        if (width > 1)
+            _mip_filter_row(dst, row0, row1, scaledWidth, components);
+        else
         {
-            for (PRtexsize x = 0; x < scaledWidth; ++x)
-            {
-                for (PRint i = 0; i < 3; ++i)
-                {
-                    scaled[(y*scaledWidth + x)*3 + i] = _color_box4_blur(
-                        COLOR(x*2    , y*2    , i),
-                        COLOR(x*2 + 1, y*2    , i),
-                        COLOR(x*2 + 1, y*2 + 1, i),
-                        COLOR(x*2    , y*2 + 1, i)
-                    );
-                }
-            }
+            for (PRint i = 0; i < 3; ++i)
+                dst[i] = (PRubyte)((row0[i]*2 + row1[i]*2) / 4);
+            dst[3] = 0;
         }
     }
-    else if (width > 1)
+}
+
+/*
+Generates the texels of the MIP levels [firstMip, lastMip] from the RGB image of the first MIP level.
+All images of the MIP chain (in RGBx colors, so that 2x2 texels are filtered with SIMD) are stored in one scratch arena,
+which is shared by all textures and only grows. The conversion of each level takes its staging texels and dithering rows
+from a second arena, i.e. reloading textures of the same size does not allocate any memory.
+*/
+static void _texture_generate_mips(pr_texture* texture, const PRubyte* data, PRenum dither, PRubyte firstMip, PRubyte lastMip)
+{
+    // Determine size of the scratch arena for all scaled images
+    size_t arenaSize = 0;
+
+    for (PRubyte mip = 1; mip <= lastMip; ++mip)
     {
-        for (PRtexsize x = 0; x < scaledWidth; ++x)
-        {
-            for (PRint i = 0; i < 3; ++i)
-            {
-                scaled[x*3 + i] = _color_box2_blur(
-                    COLOR(x*2    , 0, i),
-                    COLOR(x*2 + 1, 0, i)
-                );
-            }
-        }
+        const PRtexsize w = _texture_mip_size(texture->width, mip);
+        const PRtexsize h = _texture_mip_size(texture->height, mip);
+        arenaSize += (size_t)w*h*4;
     }
-    else if (height > 1)
+
+    PRubyte* colors = _texture_scratch(arenaSize);
+
+    // Scale down each MIP level from the previous one
+    const PRubyte* prevColors = data;
+    PRint components = 3;
+    PRtexsize width = texture->width;
+    PRtexsize height = texture->height;
+
+    for (PRubyte mip = 1; mip <= lastMip; ++mip)
     {
-        for (PRtexsize y = 0; y < scaledHeight; ++y)
-        {
-            for (PRint i = 0; i < 3; ++i)
-            {
-                scaled[y*scaledWidth*3 + i] = _color_box2_blur(
-                    COLOR(0, y*2    , i),
-                    COLOR(0, y*2 + 1, i)
-                );
-            }
-        }
+        _mip_scale_down(colors, prevColors, components, width, height);
+
+        // Halve MIP size
+        if (width > 1)
+            width /= 2;
+        if (height > 1)
+            height /= 2;
+
+        // Fill image data for current MIP level
+        if (mip >= firstMip)
+            _texture_store_colors((PRcolorindex*)texture->mipTexels[mip], width, height, colors, 4, dither);
+
+        prevColors = colors;
+        colors += (size_t)width*height*4;
+        components = 4;
+    }
+}
+
+// (Re-)allocates the texels for the specified size and number of MIP levels. The texels are kept if the size is unchanged.
+static void _texture_alloc(pr_texture* texture, PRtexsize width, PRtexsize height, PRubyte mips)
+{
+    if (texture->width == width && texture->height == height && texture->mips == mips)
+        return;
+
+    // Setup new texture dimension
+    texture->width  = width;
+    texture->height = height;
+    texture->mips   = mips;
+
+    // Determine number of texels
+    size_t numTexels = 0;
+    PRtexsize w = width, h = height;
+
+    for (PRubyte mip = 0; mip < mips; ++mip)
+    {
+        numTexels += _pr_texture_mip_texels(w, h);
+
+        // Halve MIP size
+        if (w > 1)
+            w /= 2;
+        if (h > 1)
+            h /= 2;
     }
 
-    return scaled;
+    // Free previous texels
+    PR_FREE(texture->texels);
+    #ifdef PR_TEXTURE_LAZY_MIPS
+    PR_FREE(texture->mipSource);
+    #endif
 
-    #undef COLOR
+    // Create texels
+    texture->texels = PR_CALLOC(PRcolorindex, numTexels);
+
+    // Setup MIP texel offsets
+    const PRcolorindex* texels = texture->texels;
+    w = width;
+    h = height;
+
+    for (PRubyte mip = 0; mip < mips; ++mip)
+    {
+        // Store current texel offset
+        texture->mipTexels[mip] = texels;
+
+        // Goto next texel MIP level
+        texels += _pr_texture_mip_texels(w, h);
+
+        // Halve MIP size
+        if (w > 1)
+            w /= 2;
+        if (h > 1)
+            h /= 2;
+    }
 }
 
-static PRubyte* _image_scale_down(PRtexsize width, PRtexsize height, PRenum format, const PRvoid* data)
+// Copies the row-major color indices into the specified rectangle of a MIP level.
+static void _texture_store_rect(
+    pr_texture* texture, PRubyte mip, PRint x, PRint y, PRint width, PRint height, const PRcolorindex* indices)
 {
-    switch (format)
+    PRcolorindex* texels = (PRcolorindex*)texture->mipTexels[mip];
+    const PRint pitch = _pr_texture_texel_pitch(_texture_mip_size(texture->width, mip));
+
+    for (PRint j = 0; j < height; ++j, indices += width)
     {
-        case PR_UBYTE_RGB:
-            return _image_scale_down_ubyte_rgb(width, height, (const PRubyte*)data);
-        default:
+        #ifdef PR_TEXTURE_BLOCKS
+        for (PRint i = 0; i < width; ++i)
+            texels[_pr_texture_texel_index(x + i, y + j, pitch)] = indices[i];
+        #else
+        memcpy(texels + _pr_texture_texel_index(x, y + j, pitch), indices, sizeof(PRcolorindex)*width);
+        #endif
+    }
+}
+
+// Converts the colors (with 'components' bytes per color) into the specified rectangle of a MIP level.
+static void _texture_store_colors_rect(
+    pr_texture* texture, PRubyte mip, PRint x, PRint y, PRint width, PRint height,
+    const PRubyte* colors, PRint components, PRenum dither, PRcolorindex* indices)
+{
+    pr_image subimage;
+    subimage.width      = width;
+    subimage.height     = height;
+    subimage.format     = components;
+    subimage.defFree    = PR_TRUE;
+    subimage.colors     = (PRubyte*)colors;
+
+    _pr_image_color_to_colorindex(indices, &subimage, dither, _texture_convert_scratch(_pr_image_scratch_size(width, dither)));
+    _texture_store_rect(texture, mip, x, y, width, height, indices);
+}
+
+/*
+Stores the RGB image in the rectangle [x, x + width) x [y, y + height) of the first MIP level,
+and the MIP chain of the image alone in the rectangles (x >> mip, y >> mip) of the following levels.
+The texels around the rectangle are not filtered into it, so 'x' and 'y' must be multiples of 2^(mips - 1).
+*/
+static void _texture_subimage2d_chain(
+    pr_texture* texture, PRint x, PRint y, PRtexsize width, PRtexsize height, const PRubyte* data, PRenum dither)
+{
+    // Scratch memory for the color indices of the first level, followed by the RGBx images of the following levels
+    const size_t indicesSize = sizeof(PRcolorindex)*width*height;
+    size_t arenaSize = indicesSize;
+
+    PRtexsize w = width, h = height;
+    for (PRubyte mip = 1; mip < texture->mips; ++mip)
+    {
+        w = _texture_mip_size(width, mip);
+        h = _texture_mip_size(height, mip);
+        arenaSize += (size_t)w*h*4;
+    }
+
+    PRcolorindex* indices = (PRcolorindex*)_texture_scratch(arenaSize);
+    PRubyte* colors = (PRubyte*)indices + indicesSize;
+
+    // Fill image data for first MIP level
+    _texture_store_colors_rect(texture, 0, x, y, width, height, data, 3, dither, indices);
+
+    // Scale down each MIP level of the image from the previous one
+    const PRubyte* prevColors = data;
+    PRint components = 3;
+    w = width;
+    h = height;
+
+    for (PRubyte mip = 1; mip < texture->mips; ++mip)
+    {
+        _mip_scale_down(colors, prevColors, components, w, h);
+
+        // Halve MIP size
+        if (w > 1)
+            w /= 2;
+        if (h > 1)
+            h /= 2;
+
+        // The color indices of the previous level are no longer needed
+        _texture_store_colors_rect(texture, mip, x >> mip, y >> mip, w, h, colors, 4, dither, indices);
+
+        prevColors = colors;
+        colors += (size_t)w*h*4;
+        components = 4;
+    }
+}
+
+/*
+Stores the RGB image in the rectangle [x, x + width) x [y, y + height) of the MIP level 'mip',
+and recomputes the texels of the following MIP levels (up to 'lastMip') which the 2x2 filter derives from that rectangle.
+Only the rectangle is converted, and each following level is scaled down from the region of the previous level around its rectangle.
+Where the rectangle is not aligned to the 2x2 texels, the texels around it are decoded from their color indices,
+so these colors are quantized unlike the colors from which the MIP chain is generated.
+*/
+static void _texture_subimage2d_rect(
+    pr_texture* texture, PRubyte mip, PRubyte lastMip, PRint x, PRint y, PRint width, PRint height, const PRubyte* data, PRenum dither)
+{
+    // Scratch memory for the region of the previous level, the colors of the rectangle, and its color indices
+    const size_t regionSize = (size_t)(width + 2)*(height + 2);
+
+    PRubyte* region = _texture_scratch(regionSize*(8 + sizeof(PRcolorindex)));
+    PRubyte* rectColors = region + regionSize*4;
+    PRcolorindex* indices = (PRcolorindex*)(rectColors + regionSize*4);
+
+    // Fill image data for specified MIP level
+    _texture_store_colors_rect(texture, mip, x, y, width, height, data, 3, dither, indices);
+
+    const PRubyte* colors = data;
+    PRint components = 3;
+
+    for (; mip < lastMip; ++mip)
+    {
+        const PRtexsize levelWidth = _texture_mip_size(texture->width, mip);
+        const PRtexsize levelHeight = _texture_mip_size(texture->height, mip);
+
+        // Determine the affected rectangle of the next level (the last column or row of odd sizes is not filtered into it)
+        const PRint nextX0 = (levelWidth > 1 ? x/2 : 0);
+        const PRint nextY0 = (levelHeight > 1 ? y/2 : 0);
+        const PRint nextX1 = (levelWidth > 1 ? PR_MIN((x + width + 1)/2, levelWidth/2) : 1);
+        const PRint nextY1 = (levelHeight > 1 ? PR_MIN((y + height + 1)/2, levelHeight/2) : 1);
+
+        if (nextX0 >= nextX1 || nextY0 >= nextY1)
             break;
+
+        // Gather the region of this level which is filtered into that rectangle
+        const PRint regionX = (levelWidth > 1 ? nextX0*2 : 0);
+        const PRint regionY = (levelHeight > 1 ? nextY0*2 : 0);
+        const PRint regionWidth = (levelWidth > 1 ? (nextX1 - nextX0)*2 : 1);
+        const PRint regionHeight = (levelHeight > 1 ? (nextY1 - nextY0)*2 : 1);
+
+        const PRcolorindex* texels = texture->mipTexels[mip];
+        const PRint pitch = _pr_texture_texel_pitch(levelWidth);
+        PRubyte* dst = region;
+
+        for (PRint ty = regionY; ty < regionY + regionHeight; ++ty)
+        {
+            for (PRint tx = regionX; tx < regionX + regionWidth; ++tx, dst += 4)
+            {
+                if (tx >= x && tx < x + width && ty >= y && ty < y + height)
+                {
+                    const PRubyte* src = colors + ((ty - y)*width + (tx - x))*components;
+                    dst[0] = src[0];
+                    dst[1] = src[1];
+                    dst[2] = src[2];
+                }
+                else
+                {
+                    const pr_color color = _pr_color_from_colorindex(texels[_pr_texture_texel_index(tx, ty, pitch)]);
+                    dst[0] = color.r;
+                    dst[1] = color.g;
+                    dst[2] = color.b;
+                }
+                dst[3] = 0;
+            }
+        }
+
+        // Scale down the region into the rectangle of the next level
+        x       = nextX0;
+        y       = nextY0;
+        width   = nextX1 - nextX0;
+        height  = nextY1 - nextY0;
+
+        _mip_scale_down(rectColors, region, 4, (PRtexsize)regionWidth, (PRtexsize)regionHeight);
+        _texture_store_colors_rect(texture, mip + 1, x, y, width, height, rectColors, 4, dither, indices);
+
+        colors = rectColors;
+        components = 4;
     }
-    return NULL;
 }
 
 // --- interface --- //
@@ -147,6 +545,14 @@ pr_texture* _pr_texture_create()
     texture->mips   = 0;
     texture->texels = NULL;
 
+    texture->powerOfTwo = PR_FALSE;
+
+    #ifdef PR_TEXTURE_LAZY_MIPS
+    texture->mipsReady = 0;
+    texture->mipDither = PR_DITHER_NONE;
+    texture->mipSource = NULL;
+    #endif
+
     for (size_t i = 0; i < PR_MAX_NUM_MIPS; ++i)
         texture->mipTexels[i] = NULL;
 
@@ -162,29 +568,15 @@ void _pr_texture_delete(pr_texture* texture)
         _pr_ref_release(texture);
 
         PR_FREE(texture->texels);
+        #ifdef PR_TEXTURE_LAZY_MIPS
+        PR_FREE(texture->mipSource);
+        #endif
         PR_FREE(texture);
     }
 }
 
-void _pr_texture_singular_init(pr_texture* texture)
-{
-    if (texture != NULL)
-    {
-        texture->width  = 1;
-        texture->height = 1;
-        texture->mips   = 0;
-        texture->texels = PR_CALLOC(PRcolorindex, 1);
-    }
-}
-
-void _pr_texture_singular_clear(pr_texture* texture)
-{
-    if (texture != NULL)
-        PR_FREE(texture->texels);
-}
-
 PRboolean _pr_texture_image2d(
-    pr_texture* texture, PRtexsize width, PRtexsize height, PRenum format, const PRvoid* data, PRboolean dither, PRboolean generateMips)
+    pr_texture* texture, PRtexsize width, PRtexsize height, PRenum format, const PRvoid* data, PRenum dither, PRboolean generateMips)
 {
     // Validate parameters
     if (texture == NULL)
@@ -202,137 +594,224 @@ PRboolean _pr_texture_image2d(
         _pr_error_set(PR_ERROR_INVALID_ARGUMENT, "maximum texture size exceeded");
         return PR_FALSE;
     }
+    if (format != PR_UBYTE_RGB)
+    {
+        _pr_error_set(PR_ERROR_INVALID_ARGUMENT, "invalid texture image format");
+        return PR_FALSE;
+    }
+    if (dither != PR_DITHER_NONE && dither != PR_DITHER_FLOYD_STEINBERG && dither != PR_DITHER_ORDERED)
+    {
+        _pr_error_set(PR_ERROR_INVALID_ARGUMENT, "invalid dithering mode");
+        return PR_FALSE;
+    }
 
-    // Determine number of texels
-    PRubyte mips = 0;
-    size_t numTexels = 0;
+    // Determine number of MIP levels
+    PRubyte mips = 1;
 
     if (generateMips != PR_FALSE)
     {
-        PRtexsize w = width;
-        PRtexsize h = height;
-
-        while (1)
-        {
-            // Count number of texels
-            numTexels += w*h;
+        for (PRtexsize w = width, h = height; w > 1 || h > 1; w /= 2, h /= 2)
             ++mips;
+    }
 
-            if (w == 1 && h == 1)
-                break;
+    _texture_alloc(texture, width, height, mips);
 
-            // Halve MIP size
-            if (w > 1)
-                w /= 2;
-            if (h > 1)
-                h /= 2;
-        }
-    }
-    else
-    {
-        mips = 1;
-        numTexels = width*height;
-    }
+    #ifdef PR_TEXTURE_LAZY_MIPS
+    // Create storage for the image the MIP levels are generated from
+    if (mips > 1 && texture->mipSource == NULL)
+        texture->mipSource = PR_CALLOC(PRubyte, (size_t)width*height*3);
+    #endif
 
-    // Check if texels must be reallocated
-    if (texture->width != width || texture->height != height || texture->mips != mips)
-    {
-        // Setup new texture dimension
-        texture->width  = width;
-        texture->height = height;
-        texture->mips   = mips;
+    // Power-of-two textures are sampled with bitmasks instead of wrapping the coordinates (see _pr_texture_select_sampler)
+    texture->powerOfTwo = (PR_IS_POWER_OF_TWO(width) && PR_IS_POWER_OF_TWO(height));
 
-        // Free previous texels
-        PR_FREE(texture->texels);
+    // Fill image data of first MIP level
+    _texture_subimage2d(texture->texels, width, height, format, data, dither);
 
-        // Create texels
-        texture->texels = PR_CALLOC(PRcolorindex, numTexels);
+    #ifdef PR_TEXTURE_LAZY_MIPS
+    texture->mipsReady = 1;
+    #endif
+
+    if (texture->mips > 1)
+    {
+        #ifdef PR_TEXTURE_LAZY_MIPS
+        // Keep the image until the other MIP levels are sampled for the first time (see _pr_texture_generate_mips)
+        memcpy(texture->mipSource, data, (size_t)width*height*3);
+        texture->mipDither = dither;
+        #else
+        _texture_generate_mips(texture, (const PRubyte*)data, dither, 1, texture->mips - 1);
+        #endif
+    }
 
-        // Setup MIP texel offsets
-        const PRcolorindex* texels = texture->texels;
-        PRtexsize w = width, h = height;
+    return PR_TRUE;
+}
 
-        for (PRubyte mip = 0; mip < texture->mips; ++mip)
-        {
-            // Store current texel offset
-            texture->mipTexels[mip] = texels;
+PRboolean _pr_texture_subimage2d(
+    pr_texture* texture, PRubyte mip, PRtexsize x, PRtexsize y, PRtexsize width, PRtexsize height, PRenum format, const PRvoid* data, PRenum dither)
+{
+    // Validate parameters
+    if (texture == NULL || data == NULL)
+    {
+        _pr_error_set(PR_ERROR_NULL_POINTER, __FUNCTION__);
+        return PR_FALSE;
+    }
+    if (texture->texels == NULL || mip >= texture->mips || width <= 0 || height <= 0 || x < 0 || y < 0 ||
+        (PRint)x + width > _texture_mip_size(texture->width, mip) || (PRint)y + height > _texture_mip_size(texture->height, mip))
+    {
+        _pr_error_set(PR_ERROR_INVALID_ARGUMENT, __FUNCTION__);
+        return PR_FALSE;
+    }
+    if (format != PR_UBYTE_RGB)
+    {
+        _pr_error_set(PR_ERROR_INVALID_ARGUMENT, "invalid texture image format");
+        return PR_FALSE;
+    }
+    if (dither != PR_DITHER_NONE && dither != PR_DITHER_FLOYD_STEINBERG && dither != PR_DITHER_ORDERED)
+    {
+        _pr_error_set(PR_ERROR_INVALID_ARGUMENT, "invalid dithering mode");
+        return PR_FALSE;
+    }
 
-            // Goto next texel MIP level
-            texels += w*h;
+    #ifdef PR_TEXTURE_LAZY_MIPS
 
-            // Halve MIP size
-            if (w > 1)
-                w /= 2;
-            if (h > 1)
-                h /= 2;
+    if (mip == 0)
+    {
+        // Update the image which the pending MIP levels are generated from
+        if (texture->mipSource != NULL)
+        {
+            const PRubyte* src = (const PRubyte*)data;
+            for (PRint j = 0; j < height; ++j, src += width*3)
+                memcpy(texture->mipSource + ((y + j)*texture->width + x)*3, src, (size_t)width*3);
         }
     }
+    else
+    {
+        // Lower levels are not generated from the source image, so the whole MIP chain must be generated first
+        _pr_texture_generate_mips(texture, texture->mips - 1);
+    }
 
-    // Fill image data of first MIP level
-    PRcolorindex* texels = texture->texels;
+    const PRubyte lastMip = texture->mipsReady - 1;
 
-    _texture_subimage2d(texels, 0, width, height, format, data, dither);
+    #else
 
-    if (generateMips != PR_FALSE)
-    {
-        PRvoid* prevData = (PRvoid*)data;
+    const PRubyte lastMip = texture->mips - 1;
 
-        // Fill image data
-        for (PRubyte mip = 1; mip < texture->mips; ++mip)
-        {
-            // Goto next texel MIP level
-            texels += width*height;
+    #endif
 
-            // Scale down image data
-            data = _image_scale_down(width, height, format, prevData);
+    // Fill image data for specified MIP level and refresh the following MIP levels
+    _texture_subimage2d_rect(texture, mip, lastMip, x, y, width, height, (const PRubyte*)data, dither);
 
-            if (mip > 1)
-                PR_FREE(prevData);
-            prevData = (PRvoid*)data;
+    return PR_TRUE;
+}
 
-            if (data == NULL)
-            {
-                _pr_error_set(PR_ERROR_INVALID_ARGUMENT, __FUNCTION__);
-                return PR_FALSE;
-            }
+PRboolean _pr_texture_storage2d(pr_texture* texture, PRtexsize width, PRtexsize height, PRubyte mips)
+{
+    // Validate parameters
+    if (texture == NULL)
+    {
+        _pr_error_set(PR_ERROR_NULL_POINTER, __FUNCTION__);
+        return PR_FALSE;
+    }
+    if (width == 0 || height == 0)
+    {
+        _pr_error_set(PR_ERROR_INVALID_ARGUMENT, "textures must not have a size equal to zero");
+        return PR_FALSE;
+    }
+    if (width > PR_MAX_TEX_SIZE || height > PR_MAX_TEX_SIZE)
+    {
+        _pr_error_set(PR_ERROR_INVALID_ARGUMENT, "maximum texture size exceeded");
+        return PR_FALSE;
+    }
+    if (mips == 0 || mips > PR_MAX_NUM_MIPS)
+    {
+        _pr_error_set(PR_ERROR_INVALID_ARGUMENT, "invalid number of MIP levels");
+        return PR_FALSE;
+    }
 
-            // Halve MIP size
-            if (width > 1)
-                width /= 2;
-            if (height > 1)
-                height /= 2;
+    _texture_alloc(texture, width, height, mips);
 
-            // Fill image data for current MIP level
-            _texture_subimage2d(texels, mip, width, height, format, data, dither);
-        }
+    // Clear all MIP levels
+    PRcolorindex* lastTexels = (PRcolorindex*)texture->mipTexels[mips - 1];
+    const size_t numTexels = (size_t)(lastTexels - texture->texels) +
+        _pr_texture_mip_texels(_texture_mip_size(width, mips - 1), _texture_mip_size(height, mips - 1));
 
-        PR_FREE(prevData);
-    }
+    memset(texture->texels, 0, sizeof(PRcolorindex)*numTexels);
+
+    texture->powerOfTwo = (PR_IS_POWER_OF_TWO(width) && PR_IS_POWER_OF_TWO(height));
+
+    #ifdef PR_TEXTURE_LAZY_MIPS
+    // There is no image the MIP levels could be generated from, so they are always up to date
+    PR_FREE(texture->mipSource);
+    texture->mipsReady = mips;
+    #endif
 
     return PR_TRUE;
 }
 
-PRboolean _pr_texture_subimage2d(
-    pr_texture* texture, PRubyte mip, PRtexsize x, PRtexsize y, PRtexsize width, PRtexsize height, PRenum format, const PRvoid* data, PRboolean dither)
+PRboolean _pr_texture_subimage2d_chain(
+    pr_texture* texture, PRtexsize x, PRtexsize y, PRtexsize width, PRtexsize height, PRenum format, const PRvoid* data, PRenum dither)
 {
     // Validate parameters
-    if (texture == NULL)
+    if (texture == NULL || data == NULL)
     {
         _pr_error_set(PR_ERROR_NULL_POINTER, __FUNCTION__);
         return PR_FALSE;
     }
-    if (texture->texels == NULL || x < 0 || y < 0 || x + width >= texture->width || y + height >= texture->height || width <= 0 || height <= 0 || mip >= texture->mips)
+
+    const PRint alignMask = (1 << (texture->mips - 1)) - 1;
+
+    if (texture->texels == NULL || width <= 0 || height <= 0 || x < 0 || y < 0 || (x & alignMask) != 0 || (y & alignMask) != 0 ||
+        (PRint)x + width > texture->width || (PRint)y + height > texture->height)
     {
         _pr_error_set(PR_ERROR_INVALID_ARGUMENT, __FUNCTION__);
         return PR_FALSE;
     }
+    if (format != PR_UBYTE_RGB)
+    {
+        _pr_error_set(PR_ERROR_INVALID_ARGUMENT, "invalid texture image format");
+        return PR_FALSE;
+    }
+    if (dither != PR_DITHER_NONE && dither != PR_DITHER_FLOYD_STEINBERG && dither != PR_DITHER_ORDERED)
+    {
+        _pr_error_set(PR_ERROR_INVALID_ARGUMENT, "invalid dithering mode");
+        return PR_FALSE;
+    }
 
-    // Fill image data for specified MIP level
-    _texture_subimage2d_rect(texture, mip, x, y, width, height, format, data);
+    #ifdef PR_TEXTURE_LAZY_MIPS
+    // Pending MIP levels would be generated over the stored MIP chain
+    _pr_texture_generate_mips(texture, texture->mips - 1);
+    #endif
+
+    // Fill image data for the rectangle of all MIP levels
+    _texture_subimage2d_chain(texture, x, y, width, height, (const PRubyte*)data, dither);
 
     return PR_TRUE;
 }
 
+#ifdef PR_TEXTURE_LAZY_MIPS
+
+void _pr_texture_generate_mips(pr_texture* texture, PRubyte mip)
+{
+    if (mip >= texture->mips)
+        mip = texture->mips - 1;
+
+    if (mip >= texture->mipsReady)
+    {
+        _texture_generate_mips(texture, texture->mipSource, texture->mipDither, texture->mipsReady, mip);
+        texture->mipsReady = mip + 1;
+    }
+}
+
+#endif
+
+void _pr_texture_release_scratch()
+{
+    PR_FREE(_mipArena);
+    _mipArenaSize = 0;
+    PR_FREE(_convertArena);
+    _convertArenaSize = 0;
+}
+
 PRubyte _pr_texture_num_mips(PRubyte maxSize)
 {
     return maxSize > 0 ? (PRubyte)(floorf(log2f(maxSize))) + 1 : 0;
@@ -347,33 +826,31 @@ const PRcolorindex* _pr_texture_select_miplevel(const pr_texture* texture, PRuby
     // Add MIP level offset
     mip = PR_CLAMP((PRubyte)(((PRint)mip) + _stateMachine->textureLodBias), 0, texture->mips - 1);
 
-    // Store mip size in output parameters
-    *width = PR_MIP_SIZE(texture->width, mip);
-    *height = PR_MIP_SIZE(texture->height, mip);
+    // Store mip size in output parameters (the smallest levels of non-square textures are Nx1 or 1xN, not Nx0)
+    *width = _texture_mip_size(texture->width, mip);
+    *height = _texture_mip_size(texture->height, mip);
 
     // Return MIP-map texel offset
     return texture->mipTexels[mip];
 }
 
-/*PRubyte _pr_texture_compute_miplevel(const pr_texture* texture, PRfloat r1x, PRfloat r1y, PRfloat r2x, PRfloat r2y)
+PRubyte _pr_texture_compute_miplevel(const pr_texture* texture, PRfloat r1x, PRfloat r1y, PRfloat r2x, PRfloat r2y)
 {
-    // Compute derivation of u and v vectors
-    r1x = fabsf(r1x);// * texture->width;
-    r1y = fabsf(r1y);// * texture->height;
+    // Scale derivations from texture coordinates to texels
+    r1x *= texture->width;
+    r1y *= texture->height;
 
-    r2x = fabsf(r2x);// * texture->width;
-    r2y = fabsf(r2y);// * texture->height;
+    r2x *= texture->width;
+    r2y *= texture->height;
 
-    // Select LOD by maximal derivation vector length (using dot product)
-    PRfloat r1_len = sqrtf(r1x*r1x + r1y*r1y);
-    PRfloat r2_len = sqrtf(r2x*r2x + r2y*r2y);
-    PRfloat d = PR_MAX(r1_len, r2_len)*10.0f;
-    
-    // Clamp LOD to [0, texture->texture->mips)
-    PRint lod = _int_log2(d);
-    //PRint lod = (PRint)log2f(d);
+    // Select LOD by maximal derivation vector length (log2 of the squared length is twice the LOD, so no square root is needed)
+    const PRfloat r1LenSq = r1x*r1x + r1y*r1y;
+    const PRfloat r2LenSq = r2x*r2x + r2y*r2y;
+    const PRint lod = _int_log2(PR_MAX(r1LenSq, r2LenSq)) / 2;
+
+    // Clamp LOD to [0, texture->mips)
     return (PRubyte)PR_CLAMP(lod, 0, texture->mips - 1);
-}*/
+}
 
 PRcolorindex _pr_texture_sample_nearest_from_mipmap(const PRcolorindex* mipTexels, PRtexsize mipWidth, PRtexsize mipHeight, PRfloat u, PRfloat v)
 {
@@ -387,7 +864,88 @@ PRcolorindex _pr_texture_sample_nearest_from_mipmap(const PRcolorindex* mipTexel
         y += mipHeight;
 
     // Sample from texels
-    return mipTexels[y*mipWidth + x];
+    return mipTexels[_pr_texture_texel_index(x, y, _pr_texture_texel_pitch(mipWidth))];
+}
+
+PRcolorindex _pr_texture_sample_nearest_pot_from_mipmap(const PRcolorindex* mipTexels, PRtexsize mipWidth, PRtexsize mipHeight, PRfloat u, PRfloat v)
+{
+    // Wrap texture coordinates (the multiplication with a power of two is exact, so no fraction is needed)
+    PRint x = (PRint)(u*mipWidth) & (mipWidth - 1);
+    PRint y = (PRint)(v*mipHeight) & (mipHeight - 1);
+
+    // Sample from texels
+    return mipTexels[_pr_texture_texel_index(x, y, _pr_texture_texel_pitch(mipWidth))];
+}
+
+PRcolorindex _pr_texture_sample_linear_from_mipmap(const PRcolorindex* mipTexels, PRtexsize mipWidth, PRtexsize mipHeight, PRfloat u, PRfloat v)
+{
+    // Get the upper left texel and the fractions of the bilinear sample
+    PRint wx, wy;
+    PRint x0 = _texture_linear_coord(u, mipWidth, &wx);
+    PRint y0 = _texture_linear_coord(v, mipHeight, &wy);
+
+    // Wrap the neighbor texels around the edges
+    PRint x1 = x0 + 1;
+    PRint y1 = y0 + 1;
+
+    if (x0 < 0)
+        x0 += mipWidth;
+    if (x1 >= mipWidth)
+        x1 -= mipWidth;
+    if (y0 < 0)
+        y0 += mipHeight;
+    if (y1 >= mipHeight)
+        y1 -= mipHeight;
+
+    // Blend the four texels horizontally, then vertically
+    const PRint pitch = _pr_texture_texel_pitch(mipWidth);
+
+    const PRcolorindex top = _texture_blend(
+        mipTexels[_pr_texture_texel_index(x0, y0, pitch)], mipTexels[_pr_texture_texel_index(x1, y0, pitch)], wx
+    );
+    const PRcolorindex bottom = _texture_blend(
+        mipTexels[_pr_texture_texel_index(x0, y1, pitch)], mipTexels[_pr_texture_texel_index(x1, y1, pitch)], wx
+    );
+
+    return _texture_blend(top, bottom, wy);
+}
+
+pr_texture_sampler _pr_texture_select_sampler(const pr_texture* texture)
+{
+    if (_stateMachine->textureFilter == PR_LINEAR)
+        return _pr_texture_sample_linear_from_mipmap;
+    return (texture->powerOfTwo ? _pr_texture_sample_nearest_pot_from_mipmap : _pr_texture_sample_nearest_from_mipmap);
+}
+
+void _pr_texture_blend_table_init()
+{
+    #ifndef PR_COLOR_BUFFER_24BIT
+
+    if (_blendTableReady)
+        return;
+
+    // Blend the color components on their palette levels (see _pr_color_palette_fill_r3g3b2) and round to the nearest level
+    for (PRint weight = 1; weight < PR_TEXTURE_BLEND_WEIGHTS; ++weight)
+    {
+        const PRint invWeight = PR_TEXTURE_BLEND_WEIGHTS - weight;
+
+        for (PRint a = 0; a < 256; ++a)
+        {
+            for (PRint b = 0; b < 256; ++b)
+            {
+                #define BLEND(shift, mask) \
+                    (((((a >> (shift)) & (mask))*invWeight + ((b >> (shift)) & (mask))*weight + PR_TEXTURE_BLEND_WEIGHTS/2) >> PR_TEXTURE_BLEND_SHIFT) << (shift))
+
+                _blendTable[weight - 1][a][b] = (PRcolorindex)(BLEND(5, 0x07) | BLEND(2, 0x07) | BLEND(0, 0x03));
+
+                #undef BLEND
+            }
+        }
+    }
+
+    _blendTableReady = PR_TRUE;
+
+    #endif
 }
 
 PRcolorindex _pr_texture_sample_nearest(const pr_texture* texture, PRfloat u, PRfloat v, PRfloat ddx, PRfloat ddy)
@@ -406,6 +964,8 @@ PRcolorindex _pr_texture_sample_nearest(const pr_texture* texture, PRfloat u, PR
     const PRcolorindex* texels = _pr_texture_select_miplevel(texture, mip, &w, &h);
 
     // Sample nearest texel
+    if (texture->powerOfTwo)
+        return _pr_texture_sample_nearest_pot_from_mipmap(texels, w, h, u, v);
     return _pr_texture_sample_nearest_from_mipmap(texels, w, h, u, v);
     //return _pr_color_to_colorindex_r3g3b2(mip*20, mip*20, mip*20);
 }
@@ -13,6 +13,7 @@
 #include "enums.h"
 #include "vector2.h"
 #include "color.h"
+#include "static_config.h"
 
 
 // Maximal 11 MIP-maps restricts the textures to have a
@@ -22,17 +23,34 @@
 
 #define PR_MIP_SIZE(size, mip)      ((size) >> (mip))
 #define PR_TEXTURE_HAS_MIPS(tex)    ((tex)->mips > 1)
+#define PR_IS_POWER_OF_TWO(size)    (((size) & ((size) - 1)) == 0)
+
+// Bilinear filtering quantizes the texel fractions to 1/PR_TEXTURE_BLEND_WEIGHTS (see _pr_texture_blend_table_init).
+#define PR_TEXTURE_BLEND_SHIFT      2
+#define PR_TEXTURE_BLEND_WEIGHTS    (1 << PR_TEXTURE_BLEND_SHIFT)
+
+// Texel blocks are 8x8 texels (see PR_TEXTURE_BLOCKS).
+#define PR_TEXTURE_BLOCK_SHIFT      3
+#define PR_TEXTURE_BLOCK_SIZE       (1 << PR_TEXTURE_BLOCK_SHIFT)
+#define PR_TEXTURE_BLOCK_MASK       (PR_TEXTURE_BLOCK_SIZE - 1)
 
 
 //! Textures can have a maximum size of 256x256 texels.
 //! Textures store all their mip maps in a single texel array for compact memory access.
+//! With PR_TEXTURE_BLOCKS each MIP level is padded to whole texel blocks, which are stored row by row.
 typedef struct pr_texture
 {
     PRtexsize           width;                      //!< Width of the first MIP level.
     PRtexsize           height;                     //!< Height of the first MIP level.
     PRubyte             mips;                       //!< Number of MIP levels.
+    PRboolean           powerOfTwo;                 //!< Width and height are powers of two (then all MIP levels are too).
     PRcolorindex*       texels;                     //!< Texel MIP chain.
     const PRcolorindex* mipTexels[PR_MAX_NUM_MIPS]; //!< Texel offsets for the MIP chain (Use a static array for better cache locality).
+    #ifdef PR_TEXTURE_LAZY_MIPS
+    PRubyte             mipsReady;                  //!< Number of MIP levels whose texels have been generated.
+    PRenum              mipDither;                  //!< Dithering mode for the pending MIP levels.
+    PRubyte*            mipSource;                  //!< RGB image of the first MIP level, which the pending MIP levels are generated from.
+    #endif
 }
 pr_texture;
 
@@ -40,46 +58,130 @@ pr_texture;
 pr_texture* _pr_texture_create();
 void _pr_texture_delete(pr_texture* texture);
 
-void _pr_texture_singular_init(pr_texture* texture);
-void _pr_texture_singular_clear(pr_texture* texture);
-
-//! Sets the single color to the specified texture. No null pointer assertion!
-PR_INLINE void _pr_texture_singular_color(pr_texture* texture, PRcolorindex colorIndex)
-{
-    texture->texels[0] = colorIndex;
-}
-
 //! Sets the 2D image data to the specified texture.
 PRboolean _pr_texture_image2d(
     pr_texture* texture,
     PRtexsize width, PRtexsize height,
-    PRenum format, const PRvoid* data, PRboolean dither, PRboolean generateMips
+    PRenum format, const PRvoid* data, PRenum dither, PRboolean generateMips
 );
 
+//! Sets the image data of a rectangle within a MIP level of the specified texture and refreshes the following MIP levels.
 PRboolean _pr_texture_subimage2d(
     pr_texture* texture,
     PRubyte mip, PRtexsize x, PRtexsize y,
     PRtexsize width, PRtexsize height,
-    PRenum format, const PRvoid* data, PRboolean dither
+    PRenum format, const PRvoid* data, PRenum dither
 );
 
+//! Allocates the cleared texels of the specified number of MIP levels (which may be less than the full MIP chain).
+PRboolean _pr_texture_storage2d(pr_texture* texture, PRtexsize width, PRtexsize height, PRubyte mips);
+
+/**
+Sets the image data of a rectangle within the first MIP level of the specified texture, and stores the MIP chain
+which is generated from that image alone at the scaled rectangles (x >> mip, y >> mip) of the following MIP levels.
+Unlike '_pr_texture_subimage2d' the texels around the rectangle are left unchanged in all MIP levels (see pr_atlas),
+so 'x' and 'y' must be multiples of 2^(mips - 1).
+*/
+PRboolean _pr_texture_subimage2d_chain(
+    pr_texture* texture,
+    PRtexsize x, PRtexsize y,
+    PRtexsize width, PRtexsize height,
+    PRenum format, const PRvoid* data, PRenum dither
+);
+
+#ifdef PR_TEXTURE_LAZY_MIPS
+
+/**
+Generates the texels of all MIP levels up to 'mip' which have not been generated yet (see PR_TEXTURE_LAZY_MIPS).
+This must be called before the tiles are rasterized, i.e. it must not be called by the worker threads.
+*/
+void _pr_texture_generate_mips(pr_texture* texture, PRubyte mip);
+
+#endif
+
+//! Releases the scratch memory which is shared by all textures for the MIP chain generation.
+void _pr_texture_release_scratch();
+
 //! Returns the number of MIP levels for the specified maximal texture dimension (width or height).
 PRubyte _pr_texture_num_mips(PRubyte maxSize);
 
 //! Returns a pointer to the specified texture MIP level.
 const PRcolorindex* _pr_texture_select_miplevel(const pr_texture* texture, PRubyte mip, PRtexsize* width, PRtexsize* height);
 
-//! Returns the MIP level index for the specified texture.
-//PRubyte _pr_texture_compute_miplevel(const pr_texture* texture, PRfloat r1x, PRfloat r1y, PRfloat r2x, PRfloat r2y);
+/**
+Returns the MIP level index for the specified texture by the screen space derivatives of the texture coordinates,
+i.e. r1 = (du/dx, dv/dx) and r2 = (du/dy, dv/dy). The level bias is not yet applied (see _pr_texture_select_miplevel).
+*/
+PRubyte _pr_texture_compute_miplevel(const pr_texture* texture, PRfloat r1x, PRfloat r1y, PRfloat r2x, PRfloat r2y);
+
+//! MIP-map sampler function (see _pr_texture_sample_nearest_from_mipmap).
+typedef PRcolorindex (*pr_texture_sampler)(const PRcolorindex* mipTexels, PRtexsize mipWidth, PRtexsize mipHeight, PRfloat u, PRfloat v);
 
 //! Samples the nearest texel from the specified MIP-map level.
 PRcolorindex _pr_texture_sample_nearest_from_mipmap(const PRcolorindex* mipTexels, PRtexsize mipWidth, PRtexsize mipHeight, PRfloat u, PRfloat v);
 
+/**
+Samples the nearest texel from the specified MIP-map level, whose width and height must be powers of two.
+The texture coordinates are wrapped with a bitmask, which gives the same texels as '_pr_texture_sample_nearest_from_mipmap'.
+*/
+PRcolorindex _pr_texture_sample_nearest_pot_from_mipmap(const PRcolorindex* mipTexels, PRtexsize mipWidth, PRtexsize mipHeight, PRfloat u, PRfloat v);
+
+/**
+Samples the specified MIP-map level with bilinear filtering (see PR_TEXTURE_FILTER).
+The four nearest texels are blended with the tables of '_pr_texture_blend_table_init', which must have been built before.
+*/
+PRcolorindex _pr_texture_sample_linear_from_mipmap(const PRcolorindex* mipTexels, PRtexsize mipWidth, PRtexsize mipHeight, PRfloat u, PRfloat v);
+
+//! Returns the MIP-map sampler for the specified texture and the active texture filter (see PR_TEXTURE_FILTER).
+pr_texture_sampler _pr_texture_select_sampler(const pr_texture* texture);
+
+/**
+Builds the blend tables for bilinear filtering, unless they have already been built. For each fraction 1/4, 2/4 and 3/4,
+a table stores the color index of the blended color for each pair of color indices (R3G3B2), i.e. 192 KB in total.
+With PR_COLOR_BUFFER_24BIT the colors are blended directly and no tables are needed.
+*/
+void _pr_texture_blend_table_init();
+
 //! Samples the nearest texel from the specified texture. MIP-map selection is compuited by tex-coord derivations ddx and ddy.
 PRcolorindex _pr_texture_sample_nearest(const pr_texture* texture, PRfloat u, PRfloat v, PRfloat ddx, PRfloat ddy);
 
 //! Returns a parameter of the specified texture MIP-map level.
 PRint _pr_texture_get_mip_parameter(const pr_texture* texture, PRubyte mip, PRenum param);
 
+/**
+Returns the texel pitch of a MIP level with the specified width: the width itself for row-major texels,
+or the number of texel blocks per row if PR_TEXTURE_BLOCKS is defined.
+*/
+PR_INLINE PRint _pr_texture_texel_pitch(PRtexsize mipWidth)
+{
+    #ifdef PR_TEXTURE_BLOCKS
+    return ((PRint)mipWidth + PR_TEXTURE_BLOCK_MASK) >> PR_TEXTURE_BLOCK_SHIFT;
+    #else
+    return (PRint)mipWidth;
+    #endif
+}
+
+//! Returns the index of the texel (x, y) within its MIP level. 'pitch' must be computed by '_pr_texture_texel_pitch'.
+PR_INLINE PRint _pr_texture_texel_index(PRint x, PRint y, PRint pitch)
+{
+    #ifdef PR_TEXTURE_BLOCKS
+    const PRint block = (y >> PR_TEXTURE_BLOCK_SHIFT) * pitch + (x >> PR_TEXTURE_BLOCK_SHIFT);
+    return (block << (PR_TEXTURE_BLOCK_SHIFT*2)) + ((y & PR_TEXTURE_BLOCK_MASK) << PR_TEXTURE_BLOCK_SHIFT) + (x & PR_TEXTURE_BLOCK_MASK);
+    #else
+    return y*pitch + x;
+    #endif
+}
+
+//! Returns the number of texels which are stored for a MIP level of the specified size (including the padding of the texel blocks).
+PR_INLINE size_t _pr_texture_mip_texels(PRtexsize mipWidth, PRtexsize mipHeight)
+{
+    #ifdef PR_TEXTURE_BLOCKS
+    const size_t rows = ((size_t)mipHeight + PR_TEXTURE_BLOCK_MASK) >> PR_TEXTURE_BLOCK_SHIFT;
+    return (size_t)_pr_texture_texel_pitch(mipWidth) * rows * (PR_TEXTURE_BLOCK_SIZE*PR_TEXTURE_BLOCK_SIZE);
+    #else
+    return (size_t)mipWidth * mipHeight;
+    #endif
+}
+
 
 #endif
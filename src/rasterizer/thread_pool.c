@@ -0,0 +1,298 @@
+/*
+ * thread_pool.c
+ *
+ * This file is part of the "PicoRenderer" (Copyright (c) 2014 by Lukas Hermanns)
+ * See "LICENSE.txt" for license information.
+ */
+
+#include "thread_pool.h"
+#include "ext_math.h"
+#include "helper.h"
+
+#include <stdlib.h>
+
+#ifdef PR_MULTI_THREADING
+#   ifdef _WIN32
+#       include <windows.h>
+#   else
+#       include <pthread.h>
+#       include <unistd.h>
+#   endif
+#endif
+
+
+// --- internals --- //
+
+#ifdef PR_MULTI_THREADING
+
+#ifdef _WIN32
+
+typedef HANDLE              pr_thread;
+typedef CRITICAL_SECTION    pr_mutex;
+typedef CONDITION_VARIABLE  pr_cond;
+
+#define _MUTEX_INIT(m)      InitializeCriticalSection(&(m))
+#define _MUTEX_DESTROY(m)   DeleteCriticalSection(&(m))
+#define _MUTEX_LOCK(m)      EnterCriticalSection(&(m))
+#define _MUTEX_UNLOCK(m)    LeaveCriticalSection(&(m))
+
+#define _COND_INIT(c)       InitializeConditionVariable(&(c))
+#define _COND_DESTROY(c)
+#define _COND_WAIT(c, m)    SleepConditionVariableCS(&(c), &(m), INFINITE)
+#define _COND_SIGNAL(c)     WakeConditionVariable(&(c))
+#define _COND_BROADCAST(c)  WakeAllConditionVariable(&(c))
+
+#else
+
+typedef pthread_t           pr_thread;
+typedef pthread_mutex_t     pr_mutex;
+typedef pthread_cond_t      pr_cond;
+
+#define _MUTEX_INIT(m)      pthread_mutex_init(&(m), NULL)
+#define _MUTEX_DESTROY(m)   pthread_mutex_destroy(&(m))
+#define _MUTEX_LOCK(m)      pthread_mutex_lock(&(m))
+#define _MUTEX_UNLOCK(m)    pthread_mutex_unlock(&(m))
+
+#define _COND_INIT(c)       pthread_cond_init(&(c), NULL)
+#define _COND_DESTROY(c)    pthread_cond_destroy(&(c))
+#define _COND_WAIT(c, m)    pthread_cond_wait(&(c), &(m))
+#define _COND_SIGNAL(c)     pthread_cond_signal(&(c))
+#define _COND_BROADCAST(c)  pthread_cond_broadcast(&(c))
+
+#endif
+
+typedef struct pr_worker
+{
+    pr_thread_pool* threadPool;
+    PRuint          threadIndex;
+    pr_thread       thread;
+}
+pr_worker;
+
+struct pr_thread_pool
+{
+    PRuint              numThreads;
+    pr_worker           workers[PR_MAX_NUM_THREADS];
+
+    pr_mutex            mutex;
+    pr_cond             taskCond;       // Signaled when new tasks are available (or on shutdown)
+    pr_cond             doneCond;       // Signaled when the last pending task is finished
+
+    PR_THREAD_TASK_PROC taskProc;
+    PRvoid*             userData;
+    PRuint              numTasks;
+    PRuint              nextTask;       // Index of the next task which is to be processed
+    PRuint              numPendingTasks;
+    PRboolean           isShutdown;
+};
+
+// Processes tasks until all tasks are taken. The mutex must be locked before and is locked afterwards.
+static void _thread_pool_process_tasks(pr_thread_pool* threadPool, PRuint threadIndex)
+{
+    while (threadPool->nextTask < threadPool->numTasks)
+    {
+        PRuint taskIndex = threadPool->nextTask++;
+
+        _MUTEX_UNLOCK(threadPool->mutex);
+        {
+            threadPool->taskProc(threadPool->userData, taskIndex, threadIndex);
+        }
+        _MUTEX_LOCK(threadPool->mutex);
+
+        if (--threadPool->numPendingTasks == 0)
+            _COND_SIGNAL(threadPool->doneCond);
+    }
+}
+
+static void _worker_main(pr_worker* worker)
+{
+    pr_thread_pool* threadPool = worker->threadPool;
+
+    _MUTEX_LOCK(threadPool->mutex);
+
+    while (1)
+    {
+        // Wait for new tasks
+        while (!threadPool->isShutdown && threadPool->nextTask >= threadPool->numTasks)
+            _COND_WAIT(threadPool->taskCond, threadPool->mutex);
+
+        if (threadPool->isShutdown)
+            break;
+
+        _thread_pool_process_tasks(threadPool, worker->threadIndex);
+    }
+
+    _MUTEX_UNLOCK(threadPool->mutex);
+}
+
+#ifdef _WIN32
+
+static DWORD WINAPI _worker_proc(LPVOID arg)
+{
+    _worker_main((pr_worker*)arg);
+    return 0;
+}
+
+#else
+
+static void* _worker_proc(void* arg)
+{
+    _worker_main((pr_worker*)arg);
+    return NULL;
+}
+
+#endif
+
+#else
+
+struct pr_thread_pool
+{
+    PRuint numThreads;
+};
+
+#endif
+
+// --- interface --- //
+
+PRuint _pr_thread_hardware_concurrency()
+{
+    #if defined(PR_MULTI_THREADING) && defined(_WIN32)
+
+    SYSTEM_INFO sysInfo;
+    GetSystemInfo(&sysInfo);
+    return (PRuint)PR_MAX(sysInfo.dwNumberOfProcessors, 1);
+
+    #elif defined(PR_MULTI_THREADING) && defined(_SC_NPROCESSORS_ONLN)
+
+    long numProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+    return (PRuint)PR_MAX(numProcessors, 1);
+
+    #else
+
+    return 1;
+
+    #endif
+}
+
+pr_thread_pool* _pr_thread_pool_create(PRuint numThreads)
+{
+    pr_thread_pool* threadPool = PR_MALLOC(pr_thread_pool);
+
+    threadPool->numThreads = PR_CLAMP(numThreads, 1, PR_MAX_NUM_THREADS);
+
+    #ifdef PR_MULTI_THREADING
+
+    threadPool->taskProc        = NULL;
+    threadPool->userData        = NULL;
+    threadPool->numTasks        = 0;
+    threadPool->nextTask        = 0;
+    threadPool->numPendingTasks = 0;
+    threadPool->isShutdown      = PR_FALSE;
+
+    _MUTEX_INIT(threadPool->mutex);
+    _COND_INIT(threadPool->taskCond);
+    _COND_INIT(threadPool->doneCond);
+
+    // Start worker threads (thread index 0 is reserved for the calling thread)
+    for (PRuint i = 1; i < threadPool->numThreads; ++i)
+    {
+        pr_worker* worker = &(threadPool->workers[i]);
+
+        worker->threadPool  = threadPool;
+        worker->threadIndex = i;
+
+        #ifdef _WIN32
+        worker->thread = CreateThread(NULL, 0, _worker_proc, worker, 0, NULL);
+        if (worker->thread == NULL)
+        #else
+        if (pthread_create(&(worker->thread), NULL, _worker_proc, worker) != 0)
+        #endif
+        {
+            // Continue with the threads started so far
+            threadPool->numThreads = i;
+            break;
+        }
+    }
+
+    #else
+
+    threadPool->numThreads = 1;
+
+    #endif
+
+    return threadPool;
+}
+
+void _pr_thread_pool_delete(pr_thread_pool* threadPool)
+{
+    if (threadPool != NULL)
+    {
+        #ifdef PR_MULTI_THREADING
+
+        // Wake up all worker threads and wait until they are terminated
+        _MUTEX_LOCK(threadPool->mutex);
+        {
+            threadPool->isShutdown = PR_TRUE;
+            _COND_BROADCAST(threadPool->taskCond);
+        }
+        _MUTEX_UNLOCK(threadPool->mutex);
+
+        for (PRuint i = 1; i < threadPool->numThreads; ++i)
+        {
+            #ifdef _WIN32
+            WaitForSingleObject(threadPool->workers[i].thread, INFINITE);
+            CloseHandle(threadPool->workers[i].thread);
+            #else
+            pthread_join(threadPool->workers[i].thread, NULL);
+            #endif
+        }
+
+        _COND_DESTROY(threadPool->doneCond);
+        _COND_DESTROY(threadPool->taskCond);
+        _MUTEX_DESTROY(threadPool->mutex);
+
+        #endif
+
+        PR_FREE(threadPool);
+    }
+}
+
+PRuint _pr_thread_pool_num_threads(const pr_thread_pool* threadPool)
+{
+    return (threadPool != NULL ? threadPool->numThreads : 1);
+}
+
+void _pr_thread_pool_run(pr_thread_pool* threadPool, PRuint numTasks, PR_THREAD_TASK_PROC taskProc, PRvoid* userData)
+{
+    #ifdef PR_MULTI_THREADING
+
+    if (threadPool != NULL && threadPool->numThreads > 1 && numTasks > 1)
+    {
+        _MUTEX_LOCK(threadPool->mutex);
+        {
+            // Publish tasks to the worker threads
+            threadPool->taskProc        = taskProc;
+            threadPool->userData        = userData;
+            threadPool->numTasks        = numTasks;
+            threadPool->nextTask        = 0;
+            threadPool->numPendingTasks = numTasks;
+
+            _COND_BROADCAST(threadPool->taskCond);
+
+            // Take part in processing the tasks, then wait for the remaining ones
+            _thread_pool_process_tasks(threadPool, 0);
+
+            while (threadPool->numPendingTasks > 0)
+                _COND_WAIT(threadPool->doneCond, threadPool->mutex);
+        }
+        _MUTEX_UNLOCK(threadPool->mutex);
+
+        return;
+    }
+
+    #endif
+
+    // Process all tasks on the calling thread
+    for (PRuint i = 0; i < numTasks; ++i)
+        taskProc(userData, i, 0);
+}
@@ -0,0 +1,50 @@
+/*
+ * thread_pool.h
+ *
+ * This file is part of the "PicoRenderer" (Copyright (c) 2014 by Lukas Hermanns)
+ * See "LICENSE.txt" for license information.
+ */
+
+#ifndef __PR_THREAD_POOL_H__
+#define __PR_THREAD_POOL_H__
+
+
+#include "types.h"
+#include "static_config.h"
+
+
+/**
+Thread task procedure.
+\param[in] userData Raw pointer to the user data which was passed to '_pr_thread_pool_run'.
+\param[in] taskIndex Specifies the index of the task which is to be processed.
+\param[in] threadIndex Specifies the index of the thread which processes the task (0 is the calling thread).
+*/
+typedef void (*PR_THREAD_TASK_PROC)(PRvoid* userData, PRuint taskIndex, PRuint threadIndex);
+
+//! Opaque thread pool structure.
+typedef struct pr_thread_pool pr_thread_pool;
+
+
+//! Returns the number of hardware threads (at least 1).
+PRuint _pr_thread_hardware_concurrency();
+
+/**
+Creates a new thread pool.
+\param[in] numThreads Specifies the number of threads including the calling thread.
+This will be clamped to the range [1, PR_MAX_NUM_THREADS].
+*/
+pr_thread_pool* _pr_thread_pool_create(PRuint numThreads);
+void _pr_thread_pool_delete(pr_thread_pool* threadPool);
+
+//! Returns the number of threads of the specified pool (including the calling thread).
+PRuint _pr_thread_pool_num_threads(const pr_thread_pool* threadPool);
+
+/**
+Runs the specified number of tasks and blocks until all of them are finished.
+The calling thread takes part in processing the tasks (with thread index 0).
+\param[in] threadPool Specifies the thread pool. If this is null, all tasks are processed by the calling thread.
+*/
+void _pr_thread_pool_run(pr_thread_pool* threadPool, PRuint numTasks, PR_THREAD_TASK_PROC taskProc, PRvoid* userData);
+
+
+#endif
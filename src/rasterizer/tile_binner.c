@@ -0,0 +1,284 @@
+/*
+ * tile_binner.c
+ *
+ * This file is part of the "PicoRenderer" (Copyright (c) 2014 by Lukas Hermanns)
+ * See "LICENSE.txt" for license information.
+ */
+
+#include "tile_binner.h"
+#include "ext_math.h"
+#include "helper.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+// --- internals --- //
+
+// Returns the new capacity for a dynamic array which must hold at least 'size' elements.
+static PRuint _grow_capacity(PRuint capacity, PRuint size)
+{
+    if (capacity < 16)
+        capacity = 16;
+    while (capacity < size)
+        capacity *= 2;
+    return capacity;
+}
+
+static void _tile_binner_free_bins(pr_tile_binner* tileBinner)
+{
+    if (tileBinner->bins != NULL)
+    {
+        for (PRuint i = 0, n = tileBinner->numTilesX * tileBinner->numTilesY; i < n; ++i)
+            PR_FREE(tileBinner->bins[i].polygons);
+        PR_FREE(tileBinner->bins);
+    }
+    PR_FREE(tileBinner->activeBins);
+
+    tileBinner->numTilesX = 0;
+    tileBinner->numTilesY = 0;
+}
+
+static void _tile_bin_append(pr_tile_bin* bin, PRuint polygonIndex)
+{
+    if (bin->numPolygons == bin->capacity)
+    {
+        bin->capacity = _grow_capacity(bin->capacity, bin->numPolygons + 1);
+        bin->polygons = (PRuint*)realloc(bin->polygons, sizeof(PRuint) * bin->capacity);
+    }
+    bin->polygons[bin->numPolygons++] = polygonIndex;
+}
+
+static void _tile_binner_rasterize_bin(PRvoid* userData, PRuint taskIndex, PRuint threadIndex)
+{
+    pr_tile_binner* tileBinner = (pr_tile_binner*)userData;
+    pr_framebuffer* frameBuffer = tileBinner->frameBuffer;
+
+    // Setup tile rectangle for the current thread
+    const PRuint binIndex = tileBinner->activeBins[taskIndex];
+    pr_tile_bin* bin = &(tileBinner->bins[binIndex]);
+    pr_raster_tile* tile = &(tileBinner->tiles[threadIndex]);
+
+    tile->rect.left     = (PRint)((binIndex % tileBinner->numTilesX) * PR_TILE_SIZE);
+    tile->rect.top      = (PRint)((binIndex / tileBinner->numTilesX) * PR_TILE_SIZE);
+    tile->rect.right    = tile->rect.left + PR_TILE_SIZE - 1;
+    tile->rect.bottom   = tile->rect.top + PR_TILE_SIZE - 1;
+
+    // Clamp tile to the clipping rectangle (only tiles which overlap it are active)
+    PR_CLAMP_LARGEST(tile->rect.left, tileBinner->clipRect.left);
+    PR_CLAMP_LARGEST(tile->rect.top, tileBinner->clipRect.top);
+    PR_CLAMP_SMALLEST(tile->rect.right, tileBinner->clipRect.right);
+    PR_CLAMP_SMALLEST(tile->rect.bottom, tileBinner->clipRect.bottom);
+
+    // Fill the pending clears of this tile first (it is owned by this thread, see _pr_framebuffer_clear)
+    _pr_framebuffer_resolve_tile(frameBuffer, binIndex);
+
+    // Rasterize all polygons of this tile in submission order
+    pr_depth_tile* depthTile = &(frameBuffer->depthTiles[binIndex]);
+    const PRuint tileArea = (PRuint)((tile->rect.right - tile->rect.left + 1) * (tile->rect.bottom - tile->rect.top + 1));
+    const pr_raster_state* state = &(tileBinner->state);
+    PRuint coverage;
+
+    for (PRuint i = 0; i < bin->numPolygons; ++i)
+    {
+        const pr_raster_polygon* polygon = &(tileBinner->polygons[bin->polygons[i]]);
+
+        // Skip polygons behind all pixels of this tile (the HiZ tile may have been updated since binning)
+        if (state->depthTest && polygon->depthMax < depthTile->minDepth)
+            continue;
+
+        if (state->rasterizerMode == PR_RASTERIZER_HALFSPACE)
+            coverage = _pr_rasterize_polygon_halfspace(frameBuffer, tile, state, polygon, tileBinner->edges + polygon->firstVertex);
+        else
+            coverage = _pr_rasterize_polygon_fill(frameBuffer, tile, state, polygon, tileBinner->vertices + polygon->firstVertex);
+
+        // Update HiZ tile once as many pixels have been rasterized as the tile has (only if the depth buffer is written)
+        if (state->depthWrite)
+        {
+            depthTile->coverage += coverage;
+            if (depthTile->coverage >= tileArea)
+                _pr_framebuffer_update_depth_tile(frameBuffer, binIndex);
+        }
+    }
+
+    bin->numPolygons = 0;
+}
+
+// --- interface --- //
+
+void _pr_tile_binner_init(pr_tile_binner* tileBinner)
+{
+    if (tileBinner != NULL)
+    {
+        tileBinner->frameBuffer     = NULL;
+        tileBinner->numTilesX       = 0;
+        tileBinner->numTilesY       = 0;
+        tileBinner->bins            = NULL;
+        tileBinner->activeBins      = NULL;
+        tileBinner->numActiveBins   = 0;
+        tileBinner->polygons        = NULL;
+        tileBinner->numPolygons     = 0;
+        tileBinner->polygonCapacity = 0;
+        tileBinner->vertices        = NULL;
+        tileBinner->edges           = NULL;
+        tileBinner->numVertices     = 0;
+        tileBinner->vertexCapacity  = 0;
+    }
+}
+
+void _pr_tile_binner_clear(pr_tile_binner* tileBinner)
+{
+    if (tileBinner != NULL)
+    {
+        _tile_binner_free_bins(tileBinner);
+        PR_FREE(tileBinner->polygons);
+        PR_FREE(tileBinner->vertices);
+        PR_FREE(tileBinner->edges);
+        _pr_tile_binner_init(tileBinner);
+    }
+}
+
+void _pr_tile_binner_begin(
+    pr_tile_binner* tileBinner, pr_framebuffer* frameBuffer, const pr_rect* clipRect, const pr_raster_state* state)
+{
+    const PRuint numTilesX = (frameBuffer->width + PR_TILE_SIZE - 1) / PR_TILE_SIZE;
+    const PRuint numTilesY = (frameBuffer->height + PR_TILE_SIZE - 1) / PR_TILE_SIZE;
+
+    // Check if tile bins must be reallocated
+    if (tileBinner->numTilesX != numTilesX || tileBinner->numTilesY != numTilesY)
+    {
+        _tile_binner_free_bins(tileBinner);
+
+        tileBinner->numTilesX   = numTilesX;
+        tileBinner->numTilesY   = numTilesY;
+        tileBinner->bins        = PR_CALLOC(pr_tile_bin, numTilesX*numTilesY);
+        tileBinner->activeBins  = PR_CALLOC(PRuint, numTilesX*numTilesY);
+    }
+
+    tileBinner->frameBuffer     = frameBuffer;
+    tileBinner->state           = *state;
+
+    // Clamp clipping rectangle to the frame buffer
+    tileBinner->clipRect.left   = PR_MAX(clipRect->left, 0);
+    tileBinner->clipRect.top    = PR_MAX(clipRect->top, 0);
+    tileBinner->clipRect.right  = PR_MIN(clipRect->right, (PRint)frameBuffer->width - 1);
+    tileBinner->clipRect.bottom = PR_MIN(clipRect->bottom, (PRint)frameBuffer->height - 1);
+    tileBinner->numActiveBins   = 0;
+    tileBinner->numPolygons     = 0;
+    tileBinner->numVertices     = 0;
+}
+
+void _pr_tile_binner_add_polygon(
+    pr_tile_binner* tileBinner, const pr_raster_vertex* vertices, PRint numVertices, const pr_texture* texture, PRubyte mipLevel)
+{
+    // Drop polygon if it writes neither color nor depth
+    if (tileBinner->state.spanKernel == NULL)
+        return;
+
+    // Allocate polygon and copy vertices
+    if (tileBinner->numPolygons == tileBinner->polygonCapacity)
+    {
+        tileBinner->polygonCapacity = _grow_capacity(tileBinner->polygonCapacity, tileBinner->numPolygons + 1);
+        tileBinner->polygons = (pr_raster_polygon*)realloc(tileBinner->polygons, sizeof(pr_raster_polygon) * tileBinner->polygonCapacity);
+    }
+
+    if (tileBinner->numVertices + numVertices > tileBinner->vertexCapacity)
+    {
+        tileBinner->vertexCapacity = _grow_capacity(tileBinner->vertexCapacity, tileBinner->numVertices + numVertices);
+        tileBinner->vertices = (pr_raster_vertex*)realloc(tileBinner->vertices, sizeof(pr_raster_vertex) * tileBinner->vertexCapacity);
+        tileBinner->edges = (pr_edge_function*)realloc(tileBinner->edges, sizeof(pr_edge_function) * tileBinner->vertexCapacity);
+    }
+
+    const PRuint polygonIndex = tileBinner->numPolygons;
+    pr_raster_polygon* polygon = &(tileBinner->polygons[polygonIndex]);
+
+    polygon->firstVertex    = tileBinner->numVertices;
+    polygon->numVertices    = numVertices;
+    polygon->texture        = texture;
+    polygon->mipLevel       = mipLevel;
+
+    if (!_pr_raster_polygon_setup(polygon, vertices, tileBinner->frameBuffer->depthFormat))
+        return;
+
+    // Reject polygon if it is outside of the clipping rectangle
+    const pr_rect* clipRect = &(tileBinner->clipRect);
+
+    if (polygon->bounds.right < clipRect->left || polygon->bounds.left > clipRect->right ||
+        polygon->bounds.bottom < clipRect->top || polygon->bounds.top > clipRect->bottom)
+    {
+        return;
+    }
+
+    // Reject polygon if it is behind all pixels of all overlapped tiles (HiZ test)
+    const PRuint tileLeft   = (PRuint)PR_MAX(polygon->bounds.left, clipRect->left) / PR_TILE_SIZE;
+    const PRuint tileTop    = (PRuint)PR_MAX(polygon->bounds.top, clipRect->top) / PR_TILE_SIZE;
+    const PRuint tileRight  = (PRuint)PR_MIN(polygon->bounds.right, clipRect->right) / PR_TILE_SIZE;
+    const PRuint tileBottom = (PRuint)PR_MIN(polygon->bounds.bottom, clipRect->bottom) / PR_TILE_SIZE;
+
+    const pr_depth_tile* depthTiles = tileBinner->frameBuffer->depthTiles;
+    const PRboolean depthTest = tileBinner->state.depthTest;
+    PRboolean visible = !depthTest;
+
+    for (PRuint ty = tileTop; ty <= tileBottom && !visible; ++ty)
+    {
+        for (PRuint tx = tileLeft; tx <= tileRight; ++tx)
+        {
+            if (polygon->depthMax >= depthTiles[ty * tileBinner->numTilesX + tx].minDepth)
+            {
+                visible = PR_TRUE;
+                break;
+            }
+        }
+    }
+
+    if (!visible)
+        return;
+
+    // Setup edge functions and attribute planes only once for all tiles
+    if (tileBinner->state.rasterizerMode == PR_RASTERIZER_HALFSPACE)
+    {
+        if (!_pr_raster_polygon_setup_halfspace(polygon, vertices, tileBinner->edges + tileBinner->numVertices))
+            return;
+    }
+    else if (tileBinner->state.mipMapping)
+    {
+        if (!_pr_raster_polygon_setup_planes(polygon, vertices))
+            return;
+    }
+
+    memcpy(tileBinner->vertices + tileBinner->numVertices, vertices, sizeof(pr_raster_vertex) * numVertices);
+
+    ++tileBinner->numPolygons;
+    tileBinner->numVertices += numVertices;
+
+    // Add polygon to all overlapped tile bins, which are not occluded
+    for (PRuint ty = tileTop; ty <= tileBottom; ++ty)
+    {
+        for (PRuint tx = tileLeft; tx <= tileRight; ++tx)
+        {
+            const PRuint binIndex = ty * tileBinner->numTilesX + tx;
+            pr_tile_bin* bin = &(tileBinner->bins[binIndex]);
+
+            if (depthTest && polygon->depthMax < depthTiles[binIndex].minDepth)
+                continue;
+
+            if (bin->numPolygons == 0)
+                tileBinner->activeBins[tileBinner->numActiveBins++] = binIndex;
+
+            _tile_bin_append(bin, polygonIndex);
+        }
+    }
+}
+
+void _pr_tile_binner_flush(pr_tile_binner* tileBinner, pr_thread_pool* threadPool)
+{
+    if (tileBinner->numActiveBins > 0)
+    {
+        // Rasterize each tile as a separate task
+        _pr_thread_pool_run(threadPool, tileBinner->numActiveBins, _tile_binner_rasterize_bin, tileBinner);
+    }
+
+    tileBinner->numActiveBins   = 0;
+    tileBinner->numPolygons     = 0;
+    tileBinner->numVertices     = 0;
+}
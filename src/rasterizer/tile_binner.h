@@ -0,0 +1,82 @@
+/*
+ * tile_binner.h
+ *
+ * This file is part of the "PicoRenderer" (Copyright (c) 2014 by Lukas Hermanns)
+ * See "LICENSE.txt" for license information.
+ */
+
+#ifndef __PR_TILE_BINNER_H__
+#define __PR_TILE_BINNER_H__
+
+
+#include "rasterizer.h"
+#include "thread_pool.h"
+
+
+//! List of polygon indices (in submission order) which overlap a screen tile.
+typedef struct pr_tile_bin
+{
+    PRuint*             polygons;
+    PRuint              numPolygons;
+    PRuint              capacity;
+}
+pr_tile_bin;
+
+/**
+The tile binner collects all polygons of a draw call, sorts them into screen tiles
+and rasterizes the tiles independently of each other with the thread pool.
+*/
+typedef struct pr_tile_binner
+{
+    pr_framebuffer*     frameBuffer;
+    pr_rect             clipRect;       //!< Clipping rectangle, all polygons are clamped to.
+    pr_raster_state     state;          //!< Render states of the current draw call.
+
+    PRuint              numTilesX;
+    PRuint              numTilesY;
+    pr_tile_bin*        bins;           //!< Tile bins (numTilesX * numTilesY).
+    PRuint*             activeBins;     //!< Indices of all bins with at least one polygon.
+    PRuint              numActiveBins;
+
+    pr_raster_polygon*  polygons;
+    PRuint              numPolygons;
+    PRuint              polygonCapacity;
+
+    pr_raster_vertex*   vertices;
+    pr_edge_function*   edges;          //!< Edge functions for the half-space rasterizer (same indices as the vertices).
+    PRuint              numVertices;
+    PRuint              vertexCapacity;
+
+    pr_raster_tile      tiles[PR_MAX_NUM_THREADS]; //!< Scanline scratch buffers for each thread.
+}
+pr_tile_binner;
+
+
+void _pr_tile_binner_init(pr_tile_binner* tileBinner);
+void _pr_tile_binner_clear(pr_tile_binner* tileBinner);
+
+/**
+Starts binning polygons for the specified frame buffer.
+\param[in] clipRect Specifies the clipping rectangle (in pixels). Polygons are only rasterized inside this rectangle.
+\param[in] state Specifies the render states for all polygons until the next flush, which will be copied.
+Polygons are dropped if nothing is written (see _pr_span_kernel_select). Without depth test, the HiZ tiles are ignored.
+*/
+void _pr_tile_binner_begin(
+    pr_tile_binner* tileBinner, pr_framebuffer* frameBuffer, const pr_rect* clipRect, const pr_raster_state* state
+);
+
+/**
+Adds the specified convex polygon to all tiles it overlaps.
+\param[in] vertices Specifies the raster vertices, which will be copied.
+The vertices may lie outside of the frame buffer (within the guard band, see PR_GUARD_BAND).
+\param[in] texture Specifies the texture or null for untextured polygons, which are filled with the flat color of the render states.
+*/
+void _pr_tile_binner_add_polygon(
+    pr_tile_binner* tileBinner, const pr_raster_vertex* vertices, PRint numVertices, const pr_texture* texture, PRubyte mipLevel
+);
+
+//! Rasterizes all binned polygons with the specified thread pool and resets the bins.
+void _pr_tile_binner_flush(pr_tile_binner* tileBinner, pr_thread_pool* threadPool);
+
+
+#endif
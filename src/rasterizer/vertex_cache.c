@@ -0,0 +1,17 @@
+/*
+ * vertex_cache.c
+ *
+ * This file is part of the "PicoRenderer" (Copyright (c) 2014 by Lukas Hermanns)
+ * See "LICENSE.txt" for license information.
+ */
+
+#include "vertex_cache.h"
+
+#include <string.h>
+
+
+void _pr_vertex_cache_invalidate(pr_vertex_cache* vertexCache)
+{
+    memset(vertexCache->indices, 0xff, sizeof(vertexCache->indices));
+}
+
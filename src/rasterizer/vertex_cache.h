@@ -0,0 +1,61 @@
+/*
+ * vertex_cache.h
+ *
+ * This file is part of the "PicoRenderer" (Copyright (c) 2014 by Lukas Hermanns)
+ * See "LICENSE.txt" for license information.
+ */
+
+#ifndef __PR_VERTEX_CACHE_H__
+#define __PR_VERTEX_CACHE_H__
+
+
+#include "vertexbuffer.h"
+
+
+//! Number of entries in the post-transform vertex cache (must be a power of two).
+#define PR_VERTEX_CACHE_SIZE    256
+
+/**
+Direct-mapped post-transform vertex cache for indexed draw calls.
+Each vertex index is mapped to the entry (index % PR_VERTEX_CACHE_SIZE),
+so a vertex which is shared by several triangles is only transformed once as long as it stays in its entry.
+*/
+typedef struct pr_vertex_cache
+{
+    PRuint          indices[PR_VERTEX_CACHE_SIZE];  //!< Vertex index of each entry (or ~0 if the entry is empty).
+    pr_clip_vertex  vertices[PR_VERTEX_CACHE_SIZE]; //!< Transformed vertices (in clip space).
+    PRfloat         rhw[PR_VERTEX_CACHE_SIZE];      //!< Reciprocal W coordinates of the transformed vertices.
+    PRuint          outcodes[PR_VERTEX_CACHE_SIZE]; //!< Outcodes of the transformed vertices (see PR_CLIP_...).
+}
+pr_vertex_cache;
+
+
+//! Clears all entries. This must be called before each draw call, because the transformation may have changed.
+void _pr_vertex_cache_invalidate(pr_vertex_cache* vertexCache);
+
+//! Returns the entry of the specified vertex, which is transformed by the world-view-projection matrix on a cache miss.
+PR_INLINE PRuint _pr_vertex_cache_fetch(
+    pr_vertex_cache* vertexCache, const pr_vertexbuffer* vertexBuffer, PRuint index,
+    const pr_matrix4* worldViewProjectionMatrix, const pr_vector2* guardBand)
+{
+    const PRuint entry = index & (PR_VERTEX_CACHE_SIZE - 1);
+
+    if (vertexCache->indices[entry] != index)
+    {
+        const pr_vertex* vert = &(vertexBuffer->vertices[index]);
+        pr_clip_vertex* clipVert = &(vertexCache->vertices[entry]);
+
+        _pr_matrix_mul_float4(&(clipVert->x), worldViewProjectionMatrix, &(vert->coord.x));
+        clipVert->u = vert->texCoord.x;
+        clipVert->v = vert->texCoord.y;
+
+        vertexCache->rhw[entry] = 1.0f / clipVert->w;
+        vertexCache->outcodes[entry] = _pr_clip_vertex_outcode(clipVert, guardBand);
+        vertexCache->indices[entry] = index;
+    }
+
+    return entry;
+}
+
+
+#endif
@@ -12,6 +12,16 @@
 #include "static_config.h"
 
 #include <stdlib.h>
+#include <string.h>
+
+// Batch transform processes groups of 8 vertices with AVX2 or groups of 4 vertices with SSE2
+#if defined(PR_SIMD_AVX2)
+#   include <immintrin.h>
+#   define _TRANSFORM_AVX2
+#elif defined(PR_SIMD_SSE2)
+#   include <emmintrin.h>
+#   define _TRANSFORM_SSE2
+#endif
 
 
 pr_vertexbuffer* _pr_vertexbuffer_create()
@@ -99,6 +109,319 @@ void _pr_vertexbuffer_transform_all(
         _vertex_transform((vertexBuffer->vertices + i), worldViewProjectionMatrix, viewport);
 }
 
+void _pr_vertex_stream_init(pr_vertex_stream* stream)
+{
+    if (stream != NULL)
+        memset(stream, 0, sizeof(pr_vertex_stream));
+}
+
+void _pr_vertex_stream_clear(pr_vertex_stream* stream)
+{
+    if (stream != NULL)
+    {
+        PR_FREE(stream->x);
+        _pr_vertex_stream_init(stream);
+    }
+}
+
+static void _vertex_stream_reserve(pr_vertex_stream* stream, PRsizei numVertices)
+{
+    if (stream->capacity < numVertices)
+    {
+        PR_FREE(stream->x);
+
+        // Allocate all arrays in a single block (the capacity is rounded up to whole groups of 8 vertices)
+        const PRsizei capacity = (numVertices + 7) & ~7;
+
+        stream->capacity    = capacity;
+        stream->x           = PR_CALLOC(PRfloat, capacity * 8);
+        stream->y           = stream->x + capacity;
+        stream->z           = stream->y + capacity;
+        stream->w           = stream->z + capacity;
+        stream->rhw         = stream->w + capacity;
+        stream->u           = stream->rhw + capacity;
+        stream->v           = stream->u + capacity;
+        stream->outcodes    = (PRuint*)(stream->v + capacity);
+    }
+}
+
+PRuint _pr_clip_vertex_outcode(const pr_clip_vertex* vertex, const pr_vector2* guardBand)
+{
+    PRuint code = 0;
+
+    const PRfloat gx = guardBand->x * vertex->w;
+    const PRfloat gy = guardBand->y * vertex->w;
+
+    if (vertex->x < -vertex->w)
+        code |= PR_CLIP_LEFT;
+    if (vertex->x > vertex->w)
+        code |= PR_CLIP_RIGHT;
+    if (vertex->y < -vertex->w)
+        code |= PR_CLIP_BOTTOM;
+    if (vertex->y > vertex->w)
+        code |= PR_CLIP_TOP;
+    if (vertex->z < 0.0f)
+        code |= PR_CLIP_NEAR;
+    if (vertex->z > vertex->w)
+        code |= PR_CLIP_FAR;
+    if (vertex->w < PR_CLIP_MIN_W)
+        code |= PR_CLIP_DEPTH;
+
+    if (vertex->x < -gx)
+        code |= PR_CLIP_GUARD_LEFT;
+    if (vertex->x > gx)
+        code |= PR_CLIP_GUARD_RIGHT;
+    if (vertex->y < -gy)
+        code |= PR_CLIP_GUARD_BOTTOM;
+    if (vertex->y > gy)
+        code |= PR_CLIP_GUARD_TOP;
+
+    return code;
+}
+
+// Transforms a single vertex into the stream entry 'i'
+static void _transform_stream_vertex(
+    pr_vertex_stream* stream, PRsizei i, const pr_vertex* vertex,
+    const pr_matrix4* worldViewProjectionMatrix, const pr_vector2* guardBand)
+{
+    pr_clip_vertex clipVert;
+
+    _pr_matrix_mul_float4(&(clipVert.x), worldViewProjectionMatrix, &(vertex->coord.x));
+
+    stream->x[i]        = clipVert.x;
+    stream->y[i]        = clipVert.y;
+    stream->z[i]        = clipVert.z;
+    stream->w[i]        = clipVert.w;
+    stream->rhw[i]      = 1.0f / clipVert.w;
+    stream->u[i]        = vertex->texCoord.x;
+    stream->v[i]        = vertex->texCoord.y;
+    stream->outcodes[i] = _pr_clip_vertex_outcode(&clipVert, guardBand);
+}
+
+#if defined(_TRANSFORM_AVX2)
+
+// Returns the outcode bit in all lanes where the mask is set
+PR_INLINE __m256 _outcode_bits_avx2(__m256 mask, PRuint bit)
+{
+    return _mm256_and_ps(mask, _mm256_castsi256_ps(_mm256_set1_epi32((PRint)bit)));
+}
+
+// Returns m[0] * a + m[1] * b + m[2] * c + m[3] * d (in the same order as _pr_matrix_mul_float4)
+PR_INLINE __m256 _dot4_avx2(const __m256* m, __m256 a, __m256 b, __m256 c, __m256 d)
+{
+    return _mm256_add_ps(
+        _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m[0], a), _mm256_mul_ps(m[1], b)), _mm256_mul_ps(m[2], c)),
+        _mm256_mul_ps(m[3], d)
+    );
+}
+
+// Loads the coordinates of 4 vertices and transposes them into the lanes [0, 4) or [4, 8)
+PR_INLINE void _load_coords_sse(const pr_vertex* verts, __m128* x, __m128* y, __m128* z, __m128* w)
+{
+    *x = _mm_loadu_ps(&(verts[0].coord.x));
+    *y = _mm_loadu_ps(&(verts[1].coord.x));
+    *z = _mm_loadu_ps(&(verts[2].coord.x));
+    *w = _mm_loadu_ps(&(verts[3].coord.x));
+    _MM_TRANSPOSE4_PS(*x, *y, *z, *w);
+}
+
+#define _COMBINE_M128(lo, hi) _mm256_insertf128_ps(_mm256_castps128_ps256(lo), (hi), 1)
+
+static PRsizei _transform_stream_avx2(
+    pr_vertex_stream* stream, PRsizei numVertices, const pr_vertex* verts,
+    const pr_matrix4* worldViewProjectionMatrix, const pr_vector2* guardBand)
+{
+    // Broadcast matrix elements (mat[i][j] is the factor of input component j for output component i)
+    __m256 mat[4][4];
+
+    for (PRint i = 0; i < 4; ++i)
+    {
+        for (PRint j = 0; j < 4; ++j)
+            mat[i][j] = _mm256_set1_ps(worldViewProjectionMatrix->m[j][i]);
+    }
+
+    const __m256 zero   = _mm256_setzero_ps();
+    const __m256 one    = _mm256_set1_ps(1.0f);
+    const __m256 minW   = _mm256_set1_ps(PR_CLIP_MIN_W);
+    const __m256 gbx    = _mm256_set1_ps(guardBand->x);
+    const __m256 gby    = _mm256_set1_ps(guardBand->y);
+
+    PRsizei i = 0;
+
+    for (; i + 8 <= numVertices; i += 8)
+    {
+        // Load and transpose coordinates into SoA layout
+        __m128 x0, y0, z0, w0, x1, y1, z1, w1;
+        _load_coords_sse(verts + i, &x0, &y0, &z0, &w0);
+        _load_coords_sse(verts + i + 4, &x1, &y1, &z1, &w1);
+
+        const __m256 cx = _COMBINE_M128(x0, x1);
+        const __m256 cy = _COMBINE_M128(y0, y1);
+        const __m256 cz = _COMBINE_M128(z0, z1);
+        const __m256 cw = _COMBINE_M128(w0, w1);
+
+        // Transform into clip space
+        const __m256 x = _dot4_avx2(mat[0], cx, cy, cz, cw);
+        const __m256 y = _dot4_avx2(mat[1], cx, cy, cz, cw);
+        const __m256 z = _dot4_avx2(mat[2], cx, cy, cz, cw);
+        const __m256 w = _dot4_avx2(mat[3], cx, cy, cz, cw);
+
+        _mm256_storeu_ps(stream->x + i, x);
+        _mm256_storeu_ps(stream->y + i, y);
+        _mm256_storeu_ps(stream->z + i, z);
+        _mm256_storeu_ps(stream->w + i, w);
+        _mm256_storeu_ps(stream->rhw + i, _mm256_div_ps(one, w));
+
+        // Compute outcodes
+        const __m256 negW   = _mm256_sub_ps(zero, w);
+        const __m256 gx     = _mm256_mul_ps(gbx, w);
+        const __m256 gy     = _mm256_mul_ps(gby, w);
+
+        __m256 code = _outcode_bits_avx2(_mm256_cmp_ps(x, negW, _CMP_LT_OQ), PR_CLIP_LEFT);
+        code = _mm256_or_ps(code, _outcode_bits_avx2(_mm256_cmp_ps(x, w, _CMP_GT_OQ), PR_CLIP_RIGHT));
+        code = _mm256_or_ps(code, _outcode_bits_avx2(_mm256_cmp_ps(y, negW, _CMP_LT_OQ), PR_CLIP_BOTTOM));
+        code = _mm256_or_ps(code, _outcode_bits_avx2(_mm256_cmp_ps(y, w, _CMP_GT_OQ), PR_CLIP_TOP));
+        code = _mm256_or_ps(code, _outcode_bits_avx2(_mm256_cmp_ps(z, zero, _CMP_LT_OQ), PR_CLIP_NEAR));
+        code = _mm256_or_ps(code, _outcode_bits_avx2(_mm256_cmp_ps(z, w, _CMP_GT_OQ), PR_CLIP_FAR));
+        code = _mm256_or_ps(code, _outcode_bits_avx2(_mm256_cmp_ps(w, minW, _CMP_LT_OQ), PR_CLIP_DEPTH));
+        code = _mm256_or_ps(code, _outcode_bits_avx2(_mm256_cmp_ps(x, _mm256_sub_ps(zero, gx), _CMP_LT_OQ), PR_CLIP_GUARD_LEFT));
+        code = _mm256_or_ps(code, _outcode_bits_avx2(_mm256_cmp_ps(x, gx, _CMP_GT_OQ), PR_CLIP_GUARD_RIGHT));
+        code = _mm256_or_ps(code, _outcode_bits_avx2(_mm256_cmp_ps(y, _mm256_sub_ps(zero, gy), _CMP_LT_OQ), PR_CLIP_GUARD_BOTTOM));
+        code = _mm256_or_ps(code, _outcode_bits_avx2(_mm256_cmp_ps(y, gy, _CMP_GT_OQ), PR_CLIP_GUARD_TOP));
+
+        _mm256_storeu_si256((__m256i*)(stream->outcodes + i), _mm256_castps_si256(code));
+
+        // Copy texture coordinates
+        for (PRint j = 0; j < 8; ++j)
+        {
+            stream->u[i + j] = verts[i + j].texCoord.x;
+            stream->v[i + j] = verts[i + j].texCoord.y;
+        }
+    }
+
+    return i;
+}
+
+#undef _COMBINE_M128
+
+#elif defined(_TRANSFORM_SSE2)
+
+// Returns the outcode bit in all lanes where the mask is set
+PR_INLINE __m128 _outcode_bits_sse2(__m128 mask, PRuint bit)
+{
+    return _mm_and_ps(mask, _mm_castsi128_ps(_mm_set1_epi32((PRint)bit)));
+}
+
+// Returns m[0] * a + m[1] * b + m[2] * c + m[3] * d (in the same order as _pr_matrix_mul_float4)
+PR_INLINE __m128 _dot4_sse2(const __m128* m, __m128 a, __m128 b, __m128 c, __m128 d)
+{
+    return _mm_add_ps(
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0], a), _mm_mul_ps(m[1], b)), _mm_mul_ps(m[2], c)),
+        _mm_mul_ps(m[3], d)
+    );
+}
+
+static PRsizei _transform_stream_sse2(
+    pr_vertex_stream* stream, PRsizei numVertices, const pr_vertex* verts,
+    const pr_matrix4* worldViewProjectionMatrix, const pr_vector2* guardBand)
+{
+    // Broadcast matrix elements (mat[i][j] is the factor of input component j for output component i)
+    __m128 mat[4][4];
+
+    for (PRint i = 0; i < 4; ++i)
+    {
+        for (PRint j = 0; j < 4; ++j)
+            mat[i][j] = _mm_set1_ps(worldViewProjectionMatrix->m[j][i]);
+    }
+
+    const __m128 zero   = _mm_setzero_ps();
+    const __m128 one    = _mm_set1_ps(1.0f);
+    const __m128 minW   = _mm_set1_ps(PR_CLIP_MIN_W);
+    const __m128 gbx    = _mm_set1_ps(guardBand->x);
+    const __m128 gby    = _mm_set1_ps(guardBand->y);
+
+    PRsizei i = 0;
+
+    for (; i + 4 <= numVertices; i += 4)
+    {
+        // Load and transpose coordinates into SoA layout
+        __m128 cx = _mm_loadu_ps(&(verts[i    ].coord.x));
+        __m128 cy = _mm_loadu_ps(&(verts[i + 1].coord.x));
+        __m128 cz = _mm_loadu_ps(&(verts[i + 2].coord.x));
+        __m128 cw = _mm_loadu_ps(&(verts[i + 3].coord.x));
+        _MM_TRANSPOSE4_PS(cx, cy, cz, cw);
+
+        // Transform into clip space
+        const __m128 x = _dot4_sse2(mat[0], cx, cy, cz, cw);
+        const __m128 y = _dot4_sse2(mat[1], cx, cy, cz, cw);
+        const __m128 z = _dot4_sse2(mat[2], cx, cy, cz, cw);
+        const __m128 w = _dot4_sse2(mat[3], cx, cy, cz, cw);
+
+        _mm_storeu_ps(stream->x + i, x);
+        _mm_storeu_ps(stream->y + i, y);
+        _mm_storeu_ps(stream->z + i, z);
+        _mm_storeu_ps(stream->w + i, w);
+        _mm_storeu_ps(stream->rhw + i, _mm_div_ps(one, w));
+
+        // Compute outcodes
+        const __m128 negW   = _mm_sub_ps(zero, w);
+        const __m128 gx     = _mm_mul_ps(gbx, w);
+        const __m128 gy     = _mm_mul_ps(gby, w);
+
+        __m128 code = _outcode_bits_sse2(_mm_cmplt_ps(x, negW), PR_CLIP_LEFT);
+        code = _mm_or_ps(code, _outcode_bits_sse2(_mm_cmpgt_ps(x, w), PR_CLIP_RIGHT));
+        code = _mm_or_ps(code, _outcode_bits_sse2(_mm_cmplt_ps(y, negW), PR_CLIP_BOTTOM));
+        code = _mm_or_ps(code, _outcode_bits_sse2(_mm_cmpgt_ps(y, w), PR_CLIP_TOP));
+        code = _mm_or_ps(code, _outcode_bits_sse2(_mm_cmplt_ps(z, zero), PR_CLIP_NEAR));
+        code = _mm_or_ps(code, _outcode_bits_sse2(_mm_cmpgt_ps(z, w), PR_CLIP_FAR));
+        code = _mm_or_ps(code, _outcode_bits_sse2(_mm_cmplt_ps(w, minW), PR_CLIP_DEPTH));
+        code = _mm_or_ps(code, _outcode_bits_sse2(_mm_cmplt_ps(x, _mm_sub_ps(zero, gx)), PR_CLIP_GUARD_LEFT));
+        code = _mm_or_ps(code, _outcode_bits_sse2(_mm_cmpgt_ps(x, gx), PR_CLIP_GUARD_RIGHT));
+        code = _mm_or_ps(code, _outcode_bits_sse2(_mm_cmplt_ps(y, _mm_sub_ps(zero, gy)), PR_CLIP_GUARD_BOTTOM));
+        code = _mm_or_ps(code, _outcode_bits_sse2(_mm_cmpgt_ps(y, gy), PR_CLIP_GUARD_TOP));
+
+        _mm_storeu_si128((__m128i*)(stream->outcodes + i), _mm_castps_si128(code));
+
+        // Copy texture coordinates
+        for (PRint j = 0; j < 4; ++j)
+        {
+            stream->u[i + j] = verts[i + j].texCoord.x;
+            stream->v[i + j] = verts[i + j].texCoord.y;
+        }
+    }
+
+    return i;
+}
+
+#endif
+
+void _pr_vertexbuffer_transform_stream(
+    pr_vertex_stream* stream, PRsizei numVertices, PRsizei firstVertex, const pr_vertexbuffer* vertexBuffer,
+    const pr_matrix4* worldViewProjectionMatrix, const pr_vector2* guardBand)
+{
+    if (firstVertex + numVertices > vertexBuffer->numVertices)
+    {
+        _pr_error_set(PR_ERROR_INDEX_OUT_OF_BOUNDS, __FUNCTION__);
+        return;
+    }
+
+    _vertex_stream_reserve(stream, numVertices);
+
+    const pr_vertex* verts = vertexBuffer->vertices + firstVertex;
+    PRsizei i = 0;
+
+    // Transform groups of vertices
+    #if defined(_TRANSFORM_AVX2)
+    i = _transform_stream_avx2(stream, numVertices, verts, worldViewProjectionMatrix, guardBand);
+    #elif defined(_TRANSFORM_SSE2)
+    i = _transform_stream_sse2(stream, numVertices, verts, worldViewProjectionMatrix, guardBand);
+    #endif
+
+    // Transform remaining vertices
+    for (; i < numVertices; ++i)
+        _transform_stream_vertex(stream, i, verts + i, worldViewProjectionMatrix, guardBand);
+}
+
 static void _vertexbuffer_resize(pr_vertexbuffer* vertexBuffer, PRsizei numVertices)
 {
     // Check if vertex buffer must be reallocated
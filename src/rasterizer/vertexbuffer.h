@@ -10,6 +10,7 @@
 
 
 #include "vertex.h"
+#include "raster_vertex.h"
 #include "viewport.h"
 #include "structs.h"
 
@@ -23,6 +24,43 @@ typedef struct pr_vertexbuffer
 }
 pr_vertexbuffer;
 
+// Outcode bits of a vertex in homogeneous clip space (a vertex is inside the view frustum if its outcode is 0)
+#define PR_CLIP_LEFT            0x001
+#define PR_CLIP_RIGHT           0x002
+#define PR_CLIP_BOTTOM          0x004
+#define PR_CLIP_TOP             0x008
+#define PR_CLIP_NEAR            0x010
+#define PR_CLIP_FAR             0x020
+#define PR_CLIP_DEPTH           0x040
+#define PR_CLIP_GUARD_LEFT      0x080
+#define PR_CLIP_GUARD_RIGHT     0x100
+#define PR_CLIP_GUARD_BOTTOM    0x200
+#define PR_CLIP_GUARD_TOP       0x400
+
+#define PR_CLIP_FRUSTUM         (PR_CLIP_LEFT | PR_CLIP_RIGHT | PR_CLIP_BOTTOM | PR_CLIP_TOP | PR_CLIP_NEAR | PR_CLIP_FAR | PR_CLIP_DEPTH)
+#define PR_CLIP_PLANES          (PR_CLIP_NEAR | PR_CLIP_FAR | PR_CLIP_DEPTH | PR_CLIP_GUARD_LEFT | PR_CLIP_GUARD_RIGHT | PR_CLIP_GUARD_BOTTOM | PR_CLIP_GUARD_TOP)
+
+//! Minimal W coordinate which can be stored in the depth buffer (it stores 1/w in the range [0, 1]).
+#define PR_CLIP_MIN_W           1.0f
+
+/**
+Transformed vertices in structure-of-arrays layout, i.e. the output of the batch transform stage.
+Entry i holds the clip space coordinate, its reciprocal W, the texture coordinate and the outcode of one vertex.
+*/
+typedef struct pr_vertex_stream
+{
+    PRsizei     capacity;   //!< Number of entries each array can hold (multiple of 8).
+    PRfloat*    x;
+    PRfloat*    y;
+    PRfloat*    z;
+    PRfloat*    w;
+    PRfloat*    rhw;        //!< Reciprocal W coordinate (1/w).
+    PRfloat*    u;
+    PRfloat*    v;
+    PRuint*     outcodes;   //!< Outcodes in homogeneous clip space (see PR_CLIP_...).
+}
+pr_vertex_stream;
+
 
 pr_vertexbuffer* _pr_vertexbuffer_create();
 void _pr_vertexbuffer_delete(pr_vertexbuffer* vertexBuffer);
@@ -44,6 +82,26 @@ void _pr_vertexbuffer_transform_all(
     const pr_viewport* viewport
 );
 
+void _pr_vertex_stream_init(pr_vertex_stream* stream);
+void _pr_vertex_stream_clear(pr_vertex_stream* stream);
+
+//! Returns the outcode of the specified vertex in homogeneous clip space (0 <= z <= w for the near and far planes).
+PRuint _pr_clip_vertex_outcode(const pr_clip_vertex* vertex, const pr_vector2* guardBand);
+
+/**
+Transforms the vertices [firstVertex, firstVertex + numVertices) into the stream entries [0, numVertices) and computes their outcodes.
+The vertices are processed in groups of 4 with SSE2 or in groups of 8 with AVX2. The stream grows if necessary.
+\param[in] guardBand Specifies the guard band planes in normalized device coordinates.
+*/
+void _pr_vertexbuffer_transform_stream(
+    pr_vertex_stream* stream,
+    PRsizei numVertices,
+    PRsizei firstVertex,
+    const pr_vertexbuffer* vertexBuffer,
+    const pr_matrix4* worldViewProjectionMatrix,
+    const pr_vector2* guardBand
+);
+
 void _pr_vertexbuffer_data(pr_vertexbuffer* vertexBuffer, PRsizei numVertices, const PRvoid* coords, const PRvoid* texCoords, PRsizei vertexStride);
 void _pr_vertexbuffer_data_from_file(pr_vertexbuffer* vertexBuffer, PRsizei* numVertices, FILE* file);
 
@@ -116,14 +116,14 @@ int main()
     context = prCreateContext(&contextDesc, screenWidth, screenHeight);
 
     // Create frame buffer
-    frameBuffer = prCreateFrameBuffer(screenWidth, screenHeight);
+    frameBuffer = prCreateFrameBuffer(screenWidth, screenHeight, PR_DEPTH_COMPONENT);
     prBindFrameBuffer(frameBuffer);
 
     // Create textures
     #ifdef PR_COLOR_BUFFER_24BIT
-    const PRboolean dither = PR_FALSE;
+    const PRenum dither = PR_DITHER_NONE;
     #else
-    const PRboolean dither = PR_TRUE;
+    const PRenum dither = PR_DITHER_FLOYD_STEINBERG;
     #endif
 
     PRobject textureA = prCreateTexture();
@@ -112,7 +112,7 @@ int main(int argc, char* argv[])
     //prMakeCurrent();
     
     // Create frame buffer
-    frameBuffer = prCreateFrameBuffer(scrWidth, scrHeight);
+    frameBuffer = prCreateFrameBuffer(scrWidth, scrHeight, PR_DEPTH_COMPONENT);
     prBindFrameBuffer(frameBuffer);
     
     prClearColor(0, 0, 0);
@@ -133,7 +133,7 @@ int main(int argc, char* argv[])
     PRfloat rotation = 0.0f;
     
     PRobject tex0 = prCreateTexture();
-    prTexImage2DFromFile(tex0, "crate.png", PR_TRUE, PR_TRUE);
+    prTexImage2DFromFile(tex0, "crate.png", PR_DITHER_FLOYD_STEINBERG, PR_TRUE);
     prTexEnvi(PR_TEXTURE_LOD_BIAS, 2);
     
     // Main loop
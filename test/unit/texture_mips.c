@@ -0,0 +1,113 @@
+/*
+ * texture_mips.c
+ * 
+ * This file is part of the "PicoRenderer" (Copyright (c) 2014 by Lukas Hermanns)
+ * See "LICENSE.txt" for license information.
+ */
+
+// Regression check for the MIP level sizes of non-square textures, whose smallest levels are Nx1 or 1xN.
+
+#include "texture.h"
+#include "enums.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static void _check_samples(
+    const PRcolorindex* texels, PRtexsize mipWidth, PRtexsize mipHeight, PRtexsize width, PRtexsize height, PRubyte mip, int* errors)
+{
+    for (PRint y = 0; y < mipHeight; ++y)
+    {
+        for (PRint x = 0; x < mipWidth; ++x)
+        {
+            const PRfloat u = (x + 0.5f) / mipWidth;
+            const PRfloat v = (y + 0.5f) / mipHeight;
+
+            const PRcolorindex nearest = _pr_texture_sample_nearest_from_mipmap(texels, mipWidth, mipHeight, u, v);
+            const PRcolorindex linear = _pr_texture_sample_linear_from_mipmap(texels, mipWidth, mipHeight, u, v);
+
+            if (memcmp(&nearest, &linear, sizeof(PRcolorindex)) != 0)
+            {
+                printf("%dx%d texture: linear sample of texel (%d, %d) in MIP level %d differs from nearest sample\n",
+                    width, height, x, y, mip);
+                ++(*errors);
+            }
+        }
+    }
+}
+
+static int _check_texture(PRtexsize width, PRtexsize height)
+{
+    int errors = 0;
+
+    // Create texture with random texels and full MIP chain
+    PRubyte* image = (PRubyte*)malloc((size_t)width*height*3);
+    for (int i = 0; i < width*height*3; ++i)
+        image[i] = (PRubyte)rand();
+
+    pr_texture* texture = _pr_texture_create();
+    _pr_texture_image2d(texture, width, height, PR_UBYTE_RGB, image, PR_DITHER_NONE, PR_TRUE);
+
+    #ifdef PR_TEXTURE_LAZY_MIPS
+    _pr_texture_generate_mips(texture, texture->mips - 1);
+    #endif
+
+    PRtexsize expectedWidth = width, expectedHeight = height;
+
+    for (PRubyte mip = 0; mip < texture->mips; ++mip)
+    {
+        // Check the reported size against the allocated size
+        PRtexsize mipWidth = 0, mipHeight = 0;
+        const PRcolorindex* texels = _pr_texture_select_miplevel(texture, mip, &mipWidth, &mipHeight);
+
+        if (texels != texture->mipTexels[mip] || mipWidth != expectedWidth || mipHeight != expectedHeight)
+        {
+            printf("%dx%d texture: MIP level %d is reported as %dx%d (expected %dx%d)\n",
+                width, height, mip, mipWidth, mipHeight, expectedWidth, expectedHeight);
+            ++errors;
+        }
+        else
+        {
+            // Bilinear samples at the texel centers must return the texels of this level only
+            _check_samples(texels, mipWidth, mipHeight, width, height, mip, &errors);
+        }
+
+        // Halve MIP size
+        if (expectedWidth > 1)
+            expectedWidth /= 2;
+        if (expectedHeight > 1)
+            expectedHeight /= 2;
+    }
+
+    _pr_texture_delete(texture);
+    free(image);
+
+    return errors;
+}
+
+int main()
+{
+    static const PRtexsize sizes[][2] =
+    {
+        { 4, 2 }, { 2, 4 }, { 8, 1 }, { 1, 8 }, { 16, 4 }, { 4, 16 }, { 37, 5 }, { 1, 1 }
+    };
+
+    _pr_texture_blend_table_init();
+
+    int errors = 0;
+
+    for (size_t i = 0; i < sizeof(sizes)/sizeof(sizes[0]); ++i)
+        errors += _check_texture(sizes[i][0], sizes[i][1]);
+
+    _pr_texture_release_scratch();
+
+    if (errors > 0)
+    {
+        printf("%d errors\n", errors);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}